@@ -1,8 +1,18 @@
 #ifndef BUTTON_H
 #define BUTTON_H
 
-#include <Arduino.h>
+#include "platform.h"
 #include "durations.h"
+#include "hal.h"
+#include "loop_monitor.h"
+#include "profile.h"
+#include "telemetry.h"
+
+enum ButtonEdge { // What 'check_press' saw happen to the button.
+    EDGE_NONE, // nothing changed
+    EDGE_PRESSED, // the button went down; 'releaseDuration' holds the gap before it
+    EDGE_RELEASED // the button came up; 'pressDuration' holds how long it was held
+};
 
 class Button {// Handles structures and functions regarding button presses.
 
@@ -10,26 +20,51 @@ class Button {// Handles structures and functions regarding button presses.
     Durations::ButtonProperties button_properties; // Duration, state, and defintion properties of a button.
 
     public: // Allows all objects in class to be used by other project files.
+
+    // Gives access to the durations and statistics of this button (shared with the classifier).
+    Durations::ButtonProperties& properties() {
+        return button_properties;
+    };
     
     // Function to handle detecting valid button presses and releases. Also calculates whether or not the button is pressed or released for x amount of time (ms).
-    void check_press(int buttonPin) {
-        button_properties.currentPressTime = millis(); // gets the current time
+    // 'KeyPin' and 'Clock' are pin and clock policies (hal.h); the key reads high while pressed, and must not bounce (the firmware debounces it with a PortDebouncer, debouncer.h). Returns which edge (if any) was detected by this call.
+    template <typename KeyPin, typename Clock = SystemClock>
+    ButtonEdge check_press() {
+        PROFILE_SCOPE(PROBE_CHECK_PRESS); // times the whole press check
+        return update(KeyPin::read(), Clock::now_ms());
+    };
 
-        // general defining of necessary variables regarding button pressing times and calculations
-        if (digitalRead(buttonPin) == HIGH) { // if button is pressed at all
-            if (!button_properties.isPressed && (button_properties.currentPressTime - button_properties.lastPressTime > button_properties.debounceDelay)) {  // checks that this is the first time the button is pressed
-            button_properties.isPressed = true; // sets pressed marker to 'true'
+    // Same as 'check_press' for a level that was debounced (e.g. a PortEdge, debouncer.h) and settled at 'changedAt' (ms).
+    ButtonEdge check_press(bool pressed, unsigned long changedAt) {
+        PROFILE_SCOPE(PROBE_CHECK_PRESS);
+        return update(pressed, changedAt);
+    };
+
+    // Same as 'check_press' for a key level sampled elsewhere (e.g. a tone detector on the host) at time 'now' (ms).
+    ButtonEdge update(bool pressed, unsigned long now) {
+        if (pressed == button_properties.isPressed) { // no change since the last check
+            return EDGE_NONE;
+        }
+
+        button_properties.isPressed = pressed;
+        if (pressed) { // start of a press
             button_properties.lastPressTime = button_properties.currentPressTime; // update the time of the last press time
             button_properties.lastReleaseTime = button_properties.currentReleaseTime; // updates time track of last release time after new button press
-            } else {
-            button_properties.isPressed = false; // sets marker to 'false' when button is not pressed OR when debounce is checked
-            button_properties.currentReleaseTime = millis(); // tracks time the moment of button release
-            }
+            button_properties.currentPressTime = now;
+            button_properties.releaseDuration = now - button_properties.currentReleaseTime; // calculates release duration based on 'current' press and 'last' release
+            TELEMETRY_EDGE(true, now);
+            return EDGE_PRESSED;
         }
+        button_properties.currentReleaseTime = now; // tracks time the moment of button release
+        button_properties.pressDuration = now - button_properties.currentPressTime; // calculates duration based on 'current' vars
+        LOOP_MONITOR_RELEASE(); // starts timing how long until the decoded character is visible
+        TELEMETRY_EDGE(false, now);
+        return EDGE_RELEASED;
+    };
 
-        // Calculates current individual press and release durations. 
-        button_properties.pressDuration = button_properties.currentReleaseTime - button_properties.currentPressTime; // calculates duration based on 'current' vars
-        button_properties.releaseDuration = button_properties.currentPressTime - button_properties.lastReleaseTime; // calculates release duration based on 'current' press and 'last' release
+    // Time of the most recent accepted press or release (ms).
+    unsigned long last_edge_time() {
+        return button_properties.isPressed ? button_properties.currentPressTime : button_properties.currentReleaseTime;
     };
 };
 
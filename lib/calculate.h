@@ -1,25 +1,31 @@
 #ifndef CALCULATE_H
 #define CALCULATE_H
 
-#include <ArduinoSTL.h>
+#include "platform.h"
 
 class Calculate {
     public: // Allows all objects in class to be used by other project files.
 
-    // Calculates the average of the values (int*) in the given array and returns a (float).
-    float averageArray(int* array) {
-        int sum = 0; // Sum of the data points in the given array.
-        int arraySize = sizeof(array) / sizeof(*array); // Current length of the array.
+    // Calculates the average of the first 'arraySize' values (int) in the given array, or any container indexed with [] such as a RingBuffer (containers.h), and returns a (float).
+    template <typename Values>
+    float averageArray(const Values& array, int arraySize) {
+        if (arraySize <= 0) { // nothing to average
+            return 0.;
+        }
+        long sum = 0; // Sum of the data points in the given array.
         for (int i = 0; i < arraySize; i++) { // Loops through the array.
             sum += array[i]; // Calculates the sum from each array datapoint.
         }
-        float avgResult = sum / sizeof(array); // Calculates the average of array.
+        float avgResult = (float)sum / arraySize; // Calculates the average of array.
         return avgResult;
     };
 
-    // Calculates the standard deviation of the given array (int*) and given average of array (float) and returns (float).
-    float stdArray(int* array, float avg) {
-        int arraySize = sizeof(array) / sizeof(*array); // Current length of the array.
+    // Calculates the sample standard deviation of the first 'arraySize' values (int) given their average (float) and returns (float).
+    template <typename Values>
+    float stdArray(const Values& array, int arraySize, float avg) {
+        if (arraySize < 2) { // a single data point has no spread
+            return 0.;
+        }
         float sum = 0.; // Sum of: (datapoints - average of array)^2
         float stdResult = 0; // Result of the calculated standard deviation.
         for (int i = 0; i < arraySize; i++) { // Loops through the current size of array.
@@ -0,0 +1,231 @@
+#ifndef CLASSIFIER_H
+#define CLASSIFIER_H
+
+#include "platform.h"
+#include "calculate.h"
+#include "containers.h"
+#include "durations.h"
+
+const uint8_t CLASSIFIER_WINDOW = 8; // number of recent presses/releases the statistics are taken over
+
+class Classifier { // Decides whether a press is short or long and whether a release ends the current letter, based on the running statistics of recent presses and releases.
+    private:
+    Calculate calculate; // average / standard deviation helpers
+    Durations::ButtonProperties& button; // where the statistics are kept (shared with the button)
+    RingBuffer<int, CLASSIFIER_WINDOW> pressDurations; // most recent press durations
+    RingBuffer<int, CLASSIFIER_WINDOW> releaseDurations; // most recent release durations
+    uint8_t realPresses = 0; // presses added since the windows were seeded or reset (saturates at CLASSIFIER_WINDOW)
+    uint8_t realReleases = 0; // ... releases
+
+    public: // Allows all objects in class to be used by other project files.
+    float thresholdMultiplier = TUNED_THRESHOLD_MULTIPLIER; // threshold for standard deviation (tunable, see tuning.h)
+
+    Classifier(Durations::ButtonProperties& properties) : button(properties) {};
+
+    // Determines whether the press is short or long from the statistics of previous presses. While the window holds only one kind of press (e.g. the dahs of an O) their average is that kind, so the press is judged against two dits instead.
+    char classify_press(unsigned long pressDuration) {
+        if (pressDuration < (unsigned long)button.shortPressCap) {
+            return button.shortPress; // short press
+        }
+        float threshold = button.avgPressDuration + thresholdMultiplier * button.stdPressDuration;
+        if (!pressDurations.empty() && !mixed_presses()) {
+            threshold = 2 * dit_estimate(); // halfway between a dit and a dah
+        }
+        return pressDuration <= threshold ? button.shortPress : button.longPress;
+    };
+
+    // Classifies a press from the window again, 'age' presses back (1 = the latest, at most the window size), against the window as it is now.
+    char classify_recent(uint8_t age) {
+        return classify_press(pressDurations[pressDurations.size() - age]);
+    };
+
+    // Judges a release from the window again, 'age' releases back (1 = the latest, at most the window size), against the window as it is now.
+    bool recent_ends_letter(uint8_t age) {
+        return ends_letter(releaseDurations[releaseDurations.size() - age]);
+    };
+
+    // Determines if the release duration indicates the end of a character rather than a pause between presses of the same character.
+    bool ends_letter(unsigned long releaseDuration) {
+        return releaseDuration > letter_gap_threshold();
+    };
+
+    // A release longer than this ends the current letter (ms): halfway between the average element gap and the shortest letter gap in the release window, and at least two element gaps. The shortest longer gap leaves word gaps out, so exact letter gaps stay above it while stretched (Farnsworth) ones raise it. Before a letter gap is in the window it is 2.5 element gaps, so a first letter gap over wordGapMultiplier times that is taken for a word gap. Until a press has been seen the long press cap is used.
+    float letter_gap_threshold() {
+        if (pressDurations.empty()) { // no rhythm to go by yet
+            return button.longPressCap;
+        }
+        if (releaseDurations.empty()) { // a single press: taken as a dit, so a dit's element gap does not end the letter (its presses are judged again at the end)
+            return 2 * shortest_press();
+        }
+        float dit = dit_estimate();
+        if (shortest_release() > dit) { // element gaps are a dit long too; a single clipped press must not make every one of them a letter gap
+            dit = shortest_release();
+        }
+        long elementSum = 0;
+        uint8_t elementCount = 0;
+        int letterGap = 0; // shortest release of two dits or more, 0 if there is none
+        for (uint8_t i = 0; i < releaseDurations.size(); i++) {
+            int release = releaseDurations[i];
+            if (release < 2 * dit) {
+                elementSum += release;
+                elementCount++;
+            } else if (!letterGap || release < letterGap) {
+                letterGap = release;
+            }
+        }
+        float elementGap = elementCount ? elementSum / (float)elementCount : dit; // no element gaps, e.g. only E and T keyed
+        float threshold = letterGap ? (elementGap + letterGap) / 2 : 2.5f * elementGap;
+        return threshold < 2 * elementGap ? 2 * elementGap : threshold; // a long element gap taken for a letter gap must not pull it down
+    };
+
+    // Adds a press duration to the window and recalculates the press statistics. A press that fits neither the dits nor the dahs of a seeded window (keyed at another speed) drops the seeded durations.
+    void add_press(unsigned long pressDuration) {
+        if (realPresses < pressDurations.size() && !fits_rhythm(pressDuration)) {
+            forget_seed();
+        }
+        pressDurations.push_over(clamp(pressDuration)); // the oldest one drops out of a full window
+        if (realPresses < CLASSIFIER_WINDOW) {
+            realPresses++;
+        }
+        button.avgPressDuration = calculate.averageArray(pressDurations, pressDurations.size()); // calculates avg durations
+        button.stdPressDuration = calculate.stdArray(pressDurations, pressDurations.size(), button.avgPressDuration); // calculates standard deviation durations based on calculated avg
+    };
+
+    // Adds a release duration to the window and recalculates the release statistics.
+    void add_release(unsigned long releaseDuration) {
+        releaseDurations.push_over(clamp(releaseDuration));
+        if (realReleases < CLASSIFIER_WINDOW) {
+            realReleases++;
+        }
+        button.avgReleaseDuration = calculate.averageArray(releaseDurations, releaseDurations.size()); // ...
+        button.stdReleaseDuration = calculate.stdArray(releaseDurations, releaseDurations.size(), button.avgReleaseDuration); // ...
+    };
+
+    // Copies both windows, oldest first, into 'presses' and 'releases' (CLASSIFIER_WINDOW durations each, in ms); what a window does not fill is 0.
+    void copy_windows(int16_t* presses, int16_t* releases) {
+        copy_out(pressDurations, presses);
+        copy_out(releaseDurations, releases);
+    };
+
+    // Fills both windows with durations from 'copy_windows' (e.g. those saved by the last session), as if that rhythm had just been keyed, and recalculates the statistics from them.
+    void seed(const int16_t* presses, const int16_t* releases) {
+        copy_in(pressDurations, presses);
+        copy_in(releaseDurations, releases);
+        realPresses = realReleases = 0; // the seed values do not count as keying
+        button.avgPressDuration = calculate.averageArray(pressDurations, pressDurations.size());
+        button.stdPressDuration = calculate.stdArray(pressDurations, pressDurations.size(), button.avgPressDuration);
+        button.avgReleaseDuration = calculate.averageArray(releaseDurations, releaseDurations.size());
+        button.stdReleaseDuration = calculate.stdArray(releaseDurations, releaseDurations.size(), button.avgReleaseDuration);
+    };
+
+    // Whether a full window of real presses and releases has been added since the last seed or reset, i.e. the statistics are based on real keying only.
+    bool settled() {
+        return realPresses >= CLASSIFIER_WINDOW && realReleases >= CLASSIFIER_WINDOW;
+    };
+
+    // Forgets all recorded durations and statistics.
+    void reset() {
+        pressDurations.clear();
+        releaseDurations.clear();
+        realPresses = realReleases = 0;
+        button.avgPressDuration = button.stdPressDuration = 0.;
+        button.avgReleaseDuration = button.stdReleaseDuration = 0.;
+    };
+
+    private:
+
+    // Whether a press is about a dit (half to 1.5 times the window's dit) or a dah (2 to 4.5 times it) long.
+    bool fits_rhythm(unsigned long pressDuration) {
+        float dits = pressDuration / dit_estimate();
+        return (dits >= 0.5f && dits <= 1.5f) || (dits >= 2 && dits <= 4.5f);
+    };
+
+    // Drops the seeded durations that are still in the windows, keeping only real keying, and recalculates the statistics.
+    void forget_seed() {
+        int dropped;
+        while (pressDurations.size() > realPresses) {
+            pressDurations.pop(dropped);
+        }
+        while (releaseDurations.size() > realReleases) {
+            releaseDurations.pop(dropped);
+        }
+        button.avgPressDuration = calculate.averageArray(pressDurations, pressDurations.size());
+        button.stdPressDuration = calculate.stdArray(pressDurations, pressDurations.size(), button.avgPressDuration);
+        button.avgReleaseDuration = calculate.averageArray(releaseDurations, releaseDurations.size());
+        button.stdReleaseDuration = calculate.stdArray(releaseDurations, releaseDurations.size(), button.avgReleaseDuration);
+    };
+
+    // Shortest press in the window (ms); the window must not be empty.
+    int shortest_press() {
+        int shortest = pressDurations[0];
+        for (uint8_t i = 1; i < pressDurations.size(); i++) {
+            if (pressDurations[i] < shortest) {
+                shortest = pressDurations[i];
+            }
+        }
+        return shortest;
+    };
+
+    // Shortest release in the window (ms); the window must not be empty.
+    int shortest_release() {
+        int shortest = releaseDurations[0];
+        for (uint8_t i = 1; i < releaseDurations.size(); i++) {
+            if (releaseDurations[i] < shortest) {
+                shortest = releaseDurations[i];
+            }
+        }
+        return shortest;
+    };
+
+    // Whether the window holds dits and dahs, i.e. a press at least twice as long as the shortest one.
+    bool mixed_presses() {
+        int shortest = shortest_press();
+        for (uint8_t i = 0; i < pressDurations.size(); i++) {
+            if (pressDurations[i] >= 2 * shortest) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Length of a dit (ms) judged from the press window: the average of the presses shorter than twice the shortest one. Those are dits if the window also holds longer presses; if not, they are dits if they are shorter than twice the shortest release (an element gap is a dit long, a dah three), or for a single press (whose only release may be a letter gap) if they are under the short press cap, and otherwise dahs, three dits each.
+    float dit_estimate() {
+        int shortest = shortest_press();
+        long sum = 0;
+        uint8_t count = 0;
+        for (uint8_t i = 0; i < pressDurations.size(); i++) {
+            if (pressDurations[i] < 2 * shortest) {
+                sum += pressDurations[i];
+                count++;
+            }
+        }
+        float average = count ? sum / (float)count : shortest; // count is 0 only for a shortest press of 0 ms
+        if (count < pressDurations.size()) { // dits and dahs
+            return average;
+        }
+        bool dits = pressDurations.size() < 2 || releaseDurations.empty() ? average < button.shortPressCap : average < 2 * shortest_release();
+        return dits ? average : average / 3.f;
+    };
+
+    // Writes the window, oldest first, to 'durations' and pads it to CLASSIFIER_WINDOW with 0.
+    static void copy_out(const RingBuffer<int, CLASSIFIER_WINDOW>& window, int16_t* durations) {
+        for (uint8_t i = 0; i < CLASSIFIER_WINDOW; i++) {
+            durations[i] = i < window.size() ? (int16_t)window[i] : 0;
+        }
+    };
+
+    // Replaces the window with the durations before the first 0 in 'durations' (at most CLASSIFIER_WINDOW).
+    static void copy_in(RingBuffer<int, CLASSIFIER_WINDOW>& window, const int16_t* durations) {
+        window.clear();
+        for (uint8_t i = 0; i < CLASSIFIER_WINDOW && durations[i] > 0; i++) {
+            window.push(durations[i]);
+        }
+    };
+
+    // Durations are stored as int; anything longer is saturated (it is far outside any letter anyway).
+    static int clamp(unsigned long duration) {
+        return duration > 32767 ? 32767 : (int)duration;
+    };
+};
+
+#endif // CLASSIFIER_H
\ No newline at end of file
@@ -0,0 +1,191 @@
+#ifndef CONTAINERS_H
+#define CONTAINERS_H
+
+/*
+Fixed-capacity containers for the firmware, in place of the STL: the capacity is a template
+parameter, storage is inside the object (a global or a member, never the heap) and nothing throws.
+When a container is full, an insertion that does not fit returns false and leaves it as it was;
+RingBuffer::push_over drops the oldest entry instead.
+
+ * RingBuffer<T, N>: first in, first out; [0] is the oldest entry.
+ * StaticVector<T, N>: array with a current size.
+ * BoundedString<N>: up to N characters, always terminated, so c_str() goes to strcmp, print, etc.
+ * StringView: a pointer and a length into text kept elsewhere (not necessarily terminated).
+
+None of them are safe to share with an ISR without disabling interrupts around the accesses.
+*/
+
+#include "platform.h"
+
+template <typename T, uint8_t N>
+class RingBuffer { // First in, first out queue of up to N entries.
+    public: // Allows all objects in class to be used by other project files.
+
+    // Adds 'value' at the back. Returns false (and drops 'value') if the buffer is full.
+    bool push(const T& value) {
+        if (count == N) {
+            return false;
+        }
+        items[(head + count) % N] = value;
+        count++;
+        return true;
+    };
+
+    // Adds 'value' at the back, dropping the oldest entry if the buffer is full.
+    void push_over(const T& value) {
+        if (count == N) {
+            head = (head + 1) % N;
+            count--;
+        }
+        push(value);
+    };
+
+    // Takes the oldest entry. Returns false if there is none.
+    bool pop(T& value) {
+        if (count == 0) {
+            return false;
+        }
+        value = items[head];
+        head = (head + 1) % N;
+        count--;
+        return true;
+    };
+
+    // Entry 'index', counted from the oldest.
+    const T& operator[](uint8_t index) const {
+        return items[(head + index) % N];
+    };
+
+    uint8_t size() const { return count; };
+    bool empty() const { return count == 0; };
+    bool full() const { return count == N; };
+    static uint8_t capacity() { return N; };
+
+    // Forgets all entries.
+    void clear() {
+        head = count = 0;
+    };
+
+    private:
+    T items[N] = {}; // entries, the oldest at 'head'
+    uint8_t head = 0; // slot of the oldest entry
+    uint8_t count = 0; // entries in use
+};
+
+template <typename T, uint8_t N>
+class StaticVector { // Array of up to N entries with a current size.
+    public: // Allows all objects in class to be used by other project files.
+
+    // Appends 'value'. Returns false (and drops 'value') if the vector is full.
+    bool push_back(const T& value) {
+        if (count == N) {
+            return false;
+        }
+        items[count++] = value;
+        return true;
+    };
+
+    // Removes the last entry, if any.
+    void pop_back() {
+        if (count > 0) {
+            count--;
+        }
+    };
+
+    T& operator[](uint8_t index) { return items[index]; };
+    const T& operator[](uint8_t index) const { return items[index]; };
+    T* begin() { return items; };
+    T* end() { return items + count; };
+    const T* begin() const { return items; };
+    const T* end() const { return items + count; };
+    const T* data() const { return items; };
+
+    uint8_t size() const { return count; };
+    bool empty() const { return count == 0; };
+    bool full() const { return count == N; };
+    static uint8_t capacity() { return N; };
+
+    // Forgets all entries.
+    void clear() {
+        count = 0;
+    };
+
+    private:
+    T items[N] = {}; // entries 0 .. count - 1 are in use
+    uint8_t count = 0; // entries in use
+};
+
+struct StringView { // Characters kept elsewhere: where they start and how many there are.
+    const char* chars;
+    uint8_t length;
+
+    StringView(const char* chars, uint8_t length) : chars(chars), length(length) {};
+    StringView(const char* text) : chars(text), length(strlen(text)) {}; // a terminated string
+
+    char operator[](uint8_t index) const { return chars[index]; };
+};
+
+template <uint8_t N>
+class BoundedString { // Up to N characters, always terminated.
+    public: // Allows all objects in class to be used by other project files.
+
+    // Appends 'c'. Returns false (and drops 'c') if the string is full.
+    bool append(char c) {
+        if (count == N) {
+            return false;
+        }
+        chars[count++] = c;
+        chars[count] = '\0';
+        return true;
+    };
+
+    // Puts 'c' in front, moving the rest one place on; if the string was full its last character is dropped.
+    void prepend(char c) {
+        if (count == N) {
+            count--;
+        }
+        memmove(chars + 1, chars, count);
+        chars[0] = c;
+        chars[++count] = '\0';
+    };
+
+    // Removes and returns the first character ('\0' if the string is empty).
+    char take_front() {
+        if (count == 0) {
+            return '\0';
+        }
+        char first = chars[0];
+        memmove(chars, chars + 1, count--); // moves the terminator along
+        return first;
+    };
+
+    // Removes and returns the last character ('\0' if the string is empty).
+    char take_back() {
+        if (count == 0) {
+            return '\0';
+        }
+        char last = chars[--count];
+        chars[count] = '\0';
+        return last;
+    };
+
+    char operator[](uint8_t index) const { return chars[index]; };
+    const char* c_str() const { return chars; };
+    StringView view() const { return StringView(chars, count); };
+
+    uint8_t length() const { return count; };
+    bool empty() const { return count == 0; };
+    bool full() const { return count == N; };
+    static uint8_t capacity() { return N; };
+
+    // Empties the string.
+    void clear() {
+        chars[count = 0] = '\0';
+    };
+
+    private:
+    char chars[N + 1] = ""; // the characters and their terminator
+    uint8_t count = 0; // characters in use
+};
+
+#endif // CONTAINERS_H
\ No newline at end of file
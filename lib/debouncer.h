@@ -0,0 +1,78 @@
+#ifndef DEBOUNCER_H
+#define DEBOUNCER_H
+
+/*
+Debounces all eight lines of an input port at once with vertical counters.
+
+Every line has a 2-bit counter, but the counters are stored bit-sliced: bit n of 'count0' and
+'count1' together are the counter of line n, so one pass of a handful of byte-wide logic
+operations updates all eight. A line whose sample differs from its debounced level counts up; a
+sample that agrees (a bounce back) resets its counter. After DEBOUNCE_SAMPLES samples in a row at
+the new level the debounced level flips.
+
+'sample' is meant to run from a steady timer interrupt (TickTimer, hal.h) with the whole port read
+in one instruction (Pin::read_port). At the 1 kHz tick an edge is accepted 4 ms after the line
+settles, whatever the other lines and the main loop are doing. Accepted changes are queued as
+PortEdge events whose time is that of the first of the samples at the new level, i.e. when the
+line stopped bouncing.
+*/
+
+#include "platform.h"
+#include "containers.h"
+
+const uint8_t DEBOUNCE_SAMPLES = 4; // equal samples in a row that make a change (what a 2-bit counter counts to)
+const uint8_t DEBOUNCE_QUEUE_SIZE = 8; // edges that can wait to be collected
+
+struct PortEdge { // Lines that changed together at one sample.
+    uint8_t changed; // mask of the lines whose debounced level flipped
+    uint8_t levels; // debounced level of every line after the change
+    unsigned long time; // when the changed lines settled at their new level (ms)
+};
+
+class PortDebouncer { // Debounced levels and edges of eight lines sampled together.
+    public: // Allows all objects in class to be used by other project files.
+    uint8_t watched = 0xFF; // lines whose changes are queued as edges and that 'settled' looks at (all of them are debounced)
+    RingBuffer<PortEdge, DEBOUNCE_QUEUE_SIZE> edges; // filled by 'sample'; read it with interrupts disabled if 'sample' runs in an ISR
+    uint16_t dropped = 0; // edges lost because nobody collected them
+
+    // Starts from 'levels' as the debounced state (e.g. a first read of the port), with no change pending.
+    void begin(uint8_t levels) {
+        state = levels;
+        count0 = count1 = 0;
+        edges.clear();
+    };
+
+    // Takes one sample of the port at 'now' (ms, one sample period apart). Returns the lines whose debounced level changed with it.
+    uint8_t sample(uint8_t levels, unsigned long now) {
+        uint8_t delta = levels ^ state; // lines that read different from their debounced level
+        count1 = (count1 ^ count0) & delta; // counts each such line up by one, and resets the others
+        count0 = ~count0 & delta;
+        uint8_t changed = delta & ~(count0 | count1); // lines whose counter wrapped: DEBOUNCE_SAMPLES samples in a row
+        state ^= changed;
+        if (changed & watched) {
+            PortEdge edge = { (uint8_t)(changed & watched), state, now - (DEBOUNCE_SAMPLES - 1) };
+            if (edges.full()) {
+                dropped++;
+            }
+            edges.push_over(edge);
+        }
+        return changed;
+    };
+
+    // Debounced level of every line.
+    uint8_t levels() {
+        return state;
+    };
+
+    // Whether the watched lines read 'levels' (e.g. a fresh read of the port) as debounced and no edge is waiting.
+    bool settled(uint8_t levels) {
+        return ((levels ^ state) & watched) == 0 && edges.empty();
+    };
+
+    private:
+    uint8_t state = 0; // debounced level of every line
+    uint8_t count0 = 0; // low bits of the per-line counters
+    uint8_t count1 = 0; // high bits of the per-line counters
+};
+
+#endif // DEBOUNCER_H
\ No newline at end of file
@@ -0,0 +1,211 @@
+#ifndef DECODER_H
+#define DECODER_H
+
+#include "platform.h"
+#include "button.h"
+#include "classifier.h"
+#include "containers.h"
+#include "durations.h"
+#include "morse_code.h"
+#include "telemetry.h"
+
+enum DecoderEventType { // Things the decoder reports to whoever shows the output.
+    DECODED_LETTER, // a valid letter was completed
+    DECODED_INVALID, // a pattern was completed that matches no letter
+    DECODED_WORD_GAP, // the pause after a letter was long enough to end the word
+    DECODED_CLEAR // the button was held long enough to clear the display
+};
+
+struct DecoderEvent { // A single output of the decoder.
+    DecoderEventType type;
+    char letter; // decoded letter, '?' for an invalid pattern, ' ' for a word gap
+    uint8_t pattern; // presses of the letter (or invalid pattern), packed by pack_pattern; 0 for other events
+};
+
+const uint8_t DECODER_QUEUE_SIZE = 4; // events that can wait to be collected with 'next_event'
+
+class Decoder { // Turns button presses and releases into letters: classifies each press, collects the pattern and ends letters and words on long enough pauses.
+    private:
+    Durations::ButtonProperties& button; // durations, caps and statistics of the button
+    MorseCode morse; // pattern to letter lookup
+    BoundedString<MAX_PATTERN_SLOTS - 1> pattern; // presses of the letter being keyed, '0' short and '1' long
+    unsigned long releaseTime = 0; // when the button was last released (ms)
+    bool keyDown = false; // the button is currently held
+    bool wordPending = false; // a letter was shown and no word gap has followed it yet
+    bool keyerPaced = false; // the letter/word was sent by a keyer, which reports its own letter and word spaces
+    bool pressedBefore = false; // a press was seen since power-up, i.e. a release duration is a pause in the keying
+    uint8_t letterPresses = 0; // presses classified into the current pattern
+    RingBuffer<DecoderEvent, DECODER_QUEUE_SIZE> queue; // events waiting to be collected
+
+    public: // Allows all objects in class to be used by other project files.
+    Classifier classifier; // short/long and letter gap decisions
+    float wordGapMultiplier = TUNED_WORD_GAP_MULTIPLIER; // a pause this many times the letter gap threshold ends a word (tunable)
+
+    Decoder(Durations::ButtonProperties& properties) : button(properties), classifier(properties) {};
+
+    // Handles what the button reported for this loop and ends letters/words whose pause has run out.
+    void update(ButtonEdge edge, unsigned long now) {
+        if (edge == EDGE_PRESSED) {
+            on_press(button.releaseDuration); // the pause before this press may have ended a letter or word
+        } else if (edge == EDGE_RELEASED) {
+            on_release(button.pressDuration, button.currentReleaseTime); // classifies the press
+            TELEMETRY_STATS(button.avgPressDuration, button.stdPressDuration, button.avgReleaseDuration, button.stdReleaseDuration);
+        }
+        poll(now);
+    };
+
+    // The button went down after being released for 'releaseDuration' ms.
+    void on_press(unsigned long releaseDuration) {
+        keyDown = true;
+        keyerPaced = false;
+        if (!pattern.empty() && classifier.ends_letter(releaseDuration)) { // pause was long enough to end the previous letter
+            finish_letter();
+        }
+        if (wordPending && releaseDuration > word_gap_threshold()) {
+            push(DECODED_WORD_GAP, ' ');
+            wordPending = false;
+        }
+        if (pressedBefore && releaseDuration < button.clearScreenThreshold) { // longer pauses, and the time before the first press, are idle time, not part of the keying rhythm
+            classifier.add_release(releaseDuration);
+        }
+        pressedBefore = true;
+    };
+
+    // The button came up after being held for 'pressDuration' ms at time 'now'.
+    void on_release(unsigned long pressDuration, unsigned long now) {
+        keyDown = false;
+        keyerPaced = false;
+        releaseTime = now;
+        if (pressDuration > button.clearScreenThreshold) { // held to clear the screen, not a morse element
+            pattern.clear();
+            letterPresses = 0;
+            wordPending = false;
+            push(DECODED_CLEAR, ' ');
+            return;
+        }
+        char symbol = classifier.classify_press(pressDuration); // short or long press
+        TELEMETRY_CLASSIFY(symbol, pressDuration);
+        classifier.add_press(pressDuration);
+        if (morse.add_input(pattern, symbol)) {
+            letterPresses++;
+        }
+        if (pattern.full()) { // no letter has more presses; no need to wait for the pause
+            rejudge(); // unless it turns out to hold more than one letter
+        }
+        if (pattern.full()) {
+            finish_letter();
+        }
+    };
+
+    // An element from a keyer (keyer.h): '0' dit or '1' dah. Its length is known, so it goes into the pattern as it is, without classification; the keyer also reports when the letter ends.
+    void on_element(char symbol) {
+        keyerPaced = true;
+        morse.add_input(pattern, symbol);
+        if (pattern.full()) { // no letter has more elements
+            finish_letter();
+        }
+    };
+
+    // The keyer's pause after the last element is long enough to end the letter.
+    void on_letter_space() {
+        if (!pattern.empty()) {
+            finish_letter();
+        }
+    };
+
+    // The keyer's pause is long enough to end the word.
+    void on_word_space() {
+        if (wordPending) {
+            push(DECODED_WORD_GAP, ' ');
+            wordPending = false;
+        }
+        keyerPaced = false;
+    };
+
+    // Ends letters and words whose pause has run out, even if no further press comes. Call regularly.
+    void poll(unsigned long now) {
+        if (keyDown || keyerPaced) { // a keyer reports its own spaces
+            return;
+        }
+        unsigned long released = now - releaseTime; // how long the button has been up
+        if (!pattern.empty() && classifier.ends_letter(released)) {
+            finish_letter();
+        }
+        if (wordPending && pattern.empty() && released > word_gap_threshold()) {
+            push(DECODED_WORD_GAP, ' ');
+            wordPending = false;
+        }
+    };
+
+    // Earliest time at which 'poll' could report something, or 0 if nothing is pending until the next edge (lets simulations skip idle time).
+    unsigned long next_deadline() {
+        if (keyDown || keyerPaced) {
+            return 0;
+        }
+        if (!pattern.empty()) {
+            return releaseTime + (unsigned long)classifier.letter_gap_threshold() + 1;
+        }
+        if (wordPending) {
+            return releaseTime + (unsigned long)word_gap_threshold() + 1;
+        }
+        return 0;
+    };
+
+    // Takes the oldest waiting event. Returns false if there is none.
+    bool next_event(DecoderEvent& event) {
+        return queue.pop(event);
+    };
+
+    // Pattern of the letter currently being keyed.
+    const char* current_pattern() {
+        return pattern.c_str();
+    };
+
+    private:
+
+    // A pause longer than this ends a word.
+    float word_gap_threshold() {
+        return wordGapMultiplier * classifier.letter_gap_threshold();
+    };
+
+    // Reports the collected pattern as a letter, after 'rejudge'.
+    void finish_letter() {
+        rejudge();
+        report_letter();
+        letterPresses = 0;
+    };
+
+    // While the classifier has not settled (e.g. the first letters after power-up, keyed before the rhythm was known), judges the presses of the pattern again with all of them and their gaps in the window, and reports the letters that a gap in it turns out to have ended. The rest stays in the pattern.
+    void rejudge() {
+        if (classifier.settled() || letterPresses != pattern.length()) { // judged with a known rhythm, or not every element was a press
+            return;
+        }
+        uint8_t presses = letterPresses;
+        pattern.clear();
+        letterPresses = 0;
+        for (uint8_t age = presses; age > 0; age--) { // the pattern's gaps are the latest releases
+            pattern.append(classifier.classify_recent(age));
+            letterPresses++;
+            if (age > 1 && classifier.recent_ends_letter(age - 1)) { // the gap after this press
+                report_letter();
+                letterPresses = 0;
+            }
+        }
+    };
+
+    // Looks up the collected pattern and reports the letter (or that it is invalid).
+    void report_letter() {
+        char letter = morse.get_letter(pattern.c_str());
+        push(letter == '?' ? DECODED_INVALID : DECODED_LETTER, letter, pack_pattern(pattern.c_str()));
+        wordPending = true; // an invalid pattern is part of the word too (the word corrector may still place it)
+        morse.clear_input(pattern); // Clear the input to start the next character
+    };
+
+    // Queues an event; the oldest one is overwritten if nobody collected them.
+    void push(DecoderEventType type, char letter, uint8_t packedPattern = 0) {
+        DecoderEvent event = { type, letter, packedPattern };
+        queue.push_over(event);
+    };
+};
+
+#endif // DECODER_H
\ No newline at end of file
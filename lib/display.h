@@ -1,39 +1,69 @@
 #ifndef DISPLAY_H
 #define DISPLAY_H
 
-#include <Arduino.h>
-#include "durations.h"
+#include "platform.h"
+#include "display_text.h"
+#include "lcd.h"
+#include "loop_monitor.h"
+#include "profile.h"
+
+template <typename Lcd>
+class Display { // Shows decoded letters on the lcd (Hd44780 or HostLcd, lcd.h), scrolling older ones along.
+    private:
+    Lcd& lcd; // the lcd the text is printed on
+    bool dirty = false; // the text changed since it was last printed
+    bool shrunk = false; // a row may have become shorter, so the lcd has to be cleared first
 
-class Display {
     public: 
+    DisplayText text; // what is currently on each row
 
-    void lcd_scroll(char letter) {
-        int length0 = strlen(lcd_config.line0); // length of the array for the top row on the lcd
-        int length1 = strlen(lcd_config.line1); // length of the array for the bottom row on the lcd
-        
-        if (length0 == 0) { // if the lcd is completely fresh/blank; runs here and stops
-            lcd_config.line0[0] = letter; // updates the 1st column, 1st row slot with the letter
-        } else {
-            for (int i = 0; i <= length0; i++) { // goes through each filled slot in the 1st lcd row
-            lcd_config.line0[i+1] = lcd_config.line0[i]; // sets next slot to be the next to be the prev character
-            if (i+1 == MAX_LCD_SLOTS) { // if the 1st row of the lcd is full
-                lcd_config.line1[0] = lcd_config.line0[i]; // moves last character in 1st row to start of 2nd row
-                for (int j = 0; j < length1; j++) { // goes through each filled slot in the 2nd lcd row
-                lcd_config.line1[j+1] = lcd_config.line1[j]; // sets next slot to be the prev character
-                }
-            }
-            }
-            lcd_config.line0[0] = letter; // updates (0,0);(c,r) with the letter after scrolling update
-        }
-    };
+    Display(Lcd& lcd) : lcd(lcd) {};
 
     // Updates the display of the LCD including the buffer
     void update_display(char letter) {
-        lcd_scroll(letter);
-        lcd.setCursor(0, 0); // sets cursor to default position
-        lcd.print(lcd_config.line0); // handles actual printing
-        lcd.setCursor(0, 1);
-        lcd.print(lcd_config.line1); // ...
+        add(letter);
+        flush();
+    };
+
+    // Scrolls a letter into the text buffer; 'flush' puts it on the lcd.
+    void add(char letter) {
+        text.scroll(letter);
+        dirty = true;
+    };
+
+    // Replaces the 'count' most recent letters by 'word' (e.g. a corrected word) in the text buffer; 'flush' puts it on the lcd.
+    void replace_word(int count, StringView word) {
+        for (int i = 0; i < count; i++) {
+            text.unscroll();
+        }
+        for (uint8_t i = 0; i < word.length; i++) {
+            text.scroll(word[i]);
+        }
+        dirty = shrunk = true; // rows may have become shorter
+    };
+
+    // Writes the text buffer to the lcd if it changed since the last flush.
+    void flush() {
+        if (!dirty) {
+            return;
+        }
+        PROFILE_SCOPE(PROBE_UPDATE_DISPLAY); // times the lcd writes
+        if (shrunk) {
+            lcd.clear();
+        }
+        lcd.set_cursor(0, 0); // sets cursor to default position
+        lcd.print(text.lines.line0.c_str()); // handles actual printing
+        lcd.set_cursor(0, 1);
+        lcd.print(text.lines.line1.c_str()); // ...
+        dirty = shrunk = false;
+        LOOP_MONITOR_VISIBLE(); // the character is now on the lcd
+    };
+
+    // Clears the lcd and the text buffer.
+    void clear() {
+        text.clear();
+        lcd.clear();
+        dirty = shrunk = false;
     };
 };
 
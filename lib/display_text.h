@@ -0,0 +1,44 @@
+#ifndef DISPLAY_TEXT_H
+#define DISPLAY_TEXT_H
+
+#include "platform.h"
+#include "containers.h"
+
+const int MAX_LCD_SLOTS = 17; // the max amount of slots for a single lcd row (16 columns + terminator)
+
+struct LcdConfiguration { // Sets up the LCD to have predefined lines for buffering
+    BoundedString<MAX_LCD_SLOTS - 1> line0; // Characters which will be displayed on the first row of the lcd.
+    BoundedString<MAX_LCD_SLOTS - 1> line1; // Characters which will be displayed on the second row of the lcd.
+};
+
+class DisplayText { // Text model of the two lcd rows. New letters enter at the top left and push older ones right, then down onto the second row.
+    public: // Allows all objects in class to be used by other project files.
+    LcdConfiguration lines; // contents of both rows
+
+    // Inserts a letter at the start of the first row, scrolling everything else along.
+    void scroll(char letter) {
+        if (lines.line0.full()) { // if the 1st row of the lcd is full
+            lines.line1.prepend(lines.line0.take_back()); // moves last character in 1st row to start of 2nd row; the last one of the 2nd row falls off the display
+        }
+        lines.line0.prepend(letter); // updates (0,0);(c,r) with the letter after scrolling update
+    };
+
+    // Takes back the most recent letter (the reverse of 'scroll'); a letter that already fell off the second row stays lost.
+    void unscroll() {
+        if (lines.line0.empty()) {
+            return;
+        }
+        lines.line0.take_front(); // moves the 1st row one slot left
+        if (!lines.line1.empty()) { // the first letter of the 2nd row goes back to the end of the 1st
+            lines.line0.append(lines.line1.take_front());
+        }
+    };
+
+    // Empties both rows.
+    void clear() {
+        lines.line0.clear();
+        lines.line1.clear();
+    };
+};
+
+#endif // DISPLAY_TEXT_H
\ No newline at end of file
@@ -1,7 +1,8 @@
 #ifndef DURATIONS_H
 #define DURATIONS_H
 
-#include <ArduinoSTL.h>
+#include "platform.h"
+#include "tuning.h"
 
 class Durations // Handles and stores structures containing necessary durations/states for multiple types of input/output.
 {
@@ -24,10 +25,9 @@ class Durations // Handles and stores structures containing necessary durations/
         unsigned long lastReleaseTime = 0; // tracks last time the button was released
         unsigned long pressDuration = 0; // stores the duration of the button press
         unsigned long releaseDuration = 0; // stores duration of button not being pressed
-        const unsigned long debounceDelay = 50; // debounce time in milliseconds
         const unsigned long clearScreenThreshold = 2000; // hold button for 2 seconds to clear lcd
-        const int shortPressCap = 100; // 100 ms hardcap to detect a short press
-        const int longPressCap = 300; // 300 ms hardcap to detect a long press
+        int shortPressCap = TUNED_SHORT_PRESS_CAP; // ms hardcap to detect a short press (tunable)
+        int longPressCap = TUNED_LONG_PRESS_CAP; // ms hardcap to detect a long press (tunable)
 
         char shortPress = '0'; // defines the short press as char 0 
         char longPress = '1'; // defines the long press as char 1
@@ -0,0 +1,149 @@
+#ifndef HAL_H
+#define HAL_H
+
+/*
+Hardware abstraction for the classes in lib/: pins and the clock are types handed in as template
+parameters, so the same headers build for the Uno and for the host without virtual calls or pin
+lookups at run time.
+
+ * Pin<PORT_B, 2> is bit 2 of port B (D10). Port and bit are part of the type, so setting, clearing
+   or reading a pin is a single sbi/cbi/sbis instruction instead of a digitalWrite()/digitalRead()
+   with its pin map lookup. DigitalPin<10> names the same type by its Uno pin number. On the host a
+   pin is the entry of the simulated pin array in hostPlatform (platform.h) at its Uno pin number.
+ * DistinctPins<...>::value is false if two of the pins given are the same, so a static_assert over
+   all the pins of a board catches a pin wired to two functions at build time.
+ * SystemClock gives millis()/micros() and short busy waits: the Arduino core on the Uno, the virtual
+   clock of hostPlatform on the host (where waits return at once).
+ * TickTimer runs timer 2 as a TICK_HZ interrupt (TIMER2_COMPA_vect) for work that has to happen at a
+   steady rate whatever the main loop is doing, such as debouncing the inputs (debouncer.h) or
+   generating keyer elements. The host drives ticks itself.
+
+A pin or clock policy is any type with the same static functions, e.g. for a test double.
+*/
+
+#include "platform.h"
+
+struct SystemClock { // Time from the Arduino core, or from the virtual clock on the host.
+    static unsigned long now_ms() {
+        return millis();
+    };
+
+    static unsigned long now_us() {
+        return micros();
+    };
+
+    // Waits 'us' microseconds (for bus timing).
+    static void delay_us(unsigned int us) {
+        delayMicroseconds(us);
+    };
+
+    // Waits 'ms' milliseconds (for power-up delays).
+    static void delay_ms(unsigned long ms) {
+        delay(ms);
+    };
+};
+
+enum Port : uint8_t { PORT_B, PORT_C, PORT_D }; // the Uno's I/O ports
+
+#ifdef ARDUINO
+
+template <Port P, uint8_t Bit> struct Pin { // Bit 'Bit' of port 'P' with direct port access.
+    static_assert(Bit < (P == PORT_D ? 8 : 6), "the Uno has PB0-PB5, PC0-PC5 and PD0-PD7");
+    static const Port port = P;
+    static const uint8_t bit = Bit;
+    static const uint8_t id = P * 8 + Bit; // unique per pin, for conflict checks
+    static const uint8_t mask = 1 << Bit;
+
+    static volatile uint8_t& out() { return P == PORT_B ? PORTB : (P == PORT_C ? PORTC : PORTD); };
+    static volatile uint8_t& ddr() { return P == PORT_B ? DDRB : (P == PORT_C ? DDRC : DDRD); };
+    static volatile uint8_t& in() { return P == PORT_B ? PINB : (P == PORT_C ? PINC : PIND); };
+
+    static void output() { ddr() |= mask; };
+    static void input() { ddr() &= ~mask; out() &= ~mask; }; // no pull-up
+    static void input_pullup() { ddr() &= ~mask; out() |= mask; }; // for contacts that close to ground
+    static void high() { out() |= mask; };
+    static void low() { out() &= ~mask; };
+    static void write(bool level) { if (level) high(); else low(); };
+    static bool read() { return in() & mask; };
+    static uint8_t read_port() { return in(); }; // all lines of the port in one instruction, this pin at 'mask'
+
+    // Lets a change of the pin raise its port's pin change interrupt (PCINT0_vect for port B, PCINT1_vect for C, PCINT2_vect for D).
+    static void enable_change_interrupt() {
+        if (P == PORT_B) {
+            PCMSK0 |= mask;
+            PCICR |= _BV(PCIE0);
+        } else if (P == PORT_C) {
+            PCMSK1 |= mask;
+            PCICR |= _BV(PCIE1);
+        } else {
+            PCMSK2 |= mask;
+            PCICR |= _BV(PCIE2);
+        }
+    };
+};
+
+#else // host build
+
+template <Port P, uint8_t Bit> struct Pin { // The simulated pin (hostPlatform.pins) at the Uno pin number of this port bit.
+    static_assert(Bit < (P == PORT_D ? 8 : 6), "the Uno has PB0-PB5, PC0-PC5 and PD0-PD7");
+    static const Port port = P;
+    static const uint8_t bit = Bit;
+    static const uint8_t id = P * 8 + Bit; // unique per pin, for conflict checks
+    static const uint8_t number = P == PORT_D ? Bit : (P == PORT_B ? 8 + Bit : 14 + Bit); // D0-D7, D8-D13, A0-A5
+    static const uint8_t mask = 1 << Bit;
+
+    static void output() { pinMode(number, OUTPUT); };
+    static void input() { pinMode(number, INPUT); };
+    static void input_pullup() { pinMode(number, INPUT_PULLUP); };
+    static void high() { digitalWrite(number, HIGH); };
+    static void low() { digitalWrite(number, LOW); };
+    static void write(bool level) { digitalWrite(number, level ? HIGH : LOW); };
+    static bool read() { return digitalRead(number) == HIGH; };
+    static uint8_t read_port() { // the simulated levels of every line of the port, this pin at 'mask'
+        uint8_t levels = 0;
+        for (uint8_t line = 0; line < (P == PORT_D ? 8 : 6); line++) {
+            levels |= digitalRead(number - Bit + line) == HIGH ? 1 << line : 0;
+        }
+        return levels;
+    };
+    static void enable_change_interrupt() {}; // the simulation calls the firmware when it changes a pin
+};
+
+#endif // ARDUINO
+
+const uint16_t TICK_HZ = 1000; // rate of the TickTimer interrupt
+
+struct TickTimer { // Timer 2 as a steady TICK_HZ interrupt.
+    // Starts calling TIMER2_COMPA_vect TICK_HZ times a second (the ISR is defined by whoever uses it).
+    static void begin() {
+#ifdef ARDUINO
+        static_assert(F_CPU / 64 / TICK_HZ - 1 <= 255, "timer 2 is 8 bits: TICK_HZ is too low for clock / 64");
+        PRR &= ~_BV(PRTIM2); // in case it was switched off to save power
+        TCCR2A = _BV(WGM21); // CTC: count up to OCR2A, then start over
+        TCCR2B = _BV(CS22); // clock / 64
+        OCR2A = F_CPU / 64 / TICK_HZ - 1;
+        TIMSK2 = _BV(OCIE2A);
+#endif
+    };
+};
+
+// Uno pin number N (A0-A5 are 14-19) as its port and bit: D0-D7 are port D, D8-D13 port B, A0-A5 port C.
+template <uint8_t N> using DigitalPin = Pin<(N < 8 ? PORT_D : (N < 14 ? PORT_B : PORT_C)), (N < 8 ? N : (N < 14 ? N - 8 : N - 14))>;
+
+template <typename P, typename... Others> struct PinUsedBy { // Whether any of 'Others' is the same pin as 'P'.
+    static const bool value = false;
+};
+
+template <typename P, typename First, typename... Rest> struct PinUsedBy<P, First, Rest...> {
+    static const bool value = P::id == First::id || PinUsedBy<P, Rest...>::value;
+};
+
+template <typename... Pins> struct DistinctPins { // Whether no two of 'Pins' are the same pin; use in a static_assert.
+    static const bool value = true;
+};
+
+template <typename First, typename... Rest> struct DistinctPins<First, Rest...> {
+    static const bool value = !PinUsedBy<First, Rest...>::value && DistinctPins<Rest...>::value;
+};
+
+#endif // HAL_H
\ No newline at end of file
@@ -0,0 +1,161 @@
+#ifndef KEYER_H
+#define KEYER_H
+
+/*
+Iambic keyer for a dual-lever paddle.
+
+'tick' is called every millisecond (from the TickTimer interrupt, hal.h) with the state of both
+contacts. Holding the dit paddle sends dits, holding the dah paddle dahs and squeezing both sends
+them alternately, every element followed by one unit of space, all timed to the tick at 'wpm'.
+Every element and every pause long enough to end a letter or a word is queued as a KeyerEvent;
+since the keyer made the timing, they go to the decoder as they are, with no classification.
+
+Modes (what happens to the paddle that is not being sent):
+ * Mode B: the other paddle is remembered whenever it is pressed during an element or the space
+   after it, so releasing a squeeze during an element still sends one more, opposite, element.
+ * Mode A: releasing a squeeze ends keying after the current element. With 'memory' set, a tap of
+   the other paddle alone during an element or its space is still remembered and sent next (dit or
+   dah memory); without it only the paddles held at the end of the space count.
+Pauses: a letter ends once the key has been up for LETTER_SPACE_UNITS units (between the 1 unit
+between elements and the 3 of a letter space), a word at WORD_SPACE_UNITS (between 3 and 7).
+*/
+
+#include "platform.h"
+#include "containers.h"
+
+const uint8_t LETTER_SPACE_UNITS = 2; // key-up units that end a letter
+const uint8_t WORD_SPACE_UNITS = 5; // key-up units that end a word
+const uint8_t KEYER_QUEUE_SIZE = 8; // events that can wait to be collected
+
+enum KeyerMode : uint8_t { // How a squeeze released during an element is handled.
+    KEYER_MODE_A, // stop after the current element
+    KEYER_MODE_B // send one more, opposite, element
+};
+
+enum KeyerEvent : uint8_t { // What the keyer reports.
+    KEYER_DIT, // a dit was sent
+    KEYER_DAH, // a dah was sent
+    KEYER_LETTER_SPACE, // the pause after the last element ends the letter
+    KEYER_WORD_SPACE // the pause ends the word
+};
+
+class IambicKeyer { // Generates timed dits and dahs from two paddle contacts.
+    public: // Allows all objects in class to be used by other project files.
+    KeyerMode mode = KEYER_MODE_B;
+    bool memory = true; // dit/dah memory in Mode A (Mode B always remembers)
+    RingBuffer<KeyerEvent, KEYER_QUEUE_SIZE> events; // filled by 'tick'; read it with interrupts disabled if 'tick' runs in an ISR
+    uint16_t dropped = 0; // events lost because nobody collected them
+
+    // Sets the speed (5-60 WPM); a dit is 1200 / wpm ms (PARIS timing). Disable interrupts around it if 'tick' runs in an ISR.
+    void set_wpm(uint8_t newWpm) {
+        wpm = newWpm < 5 ? 5 : (newWpm > 60 ? 60 : newWpm);
+        unit = (1200 + wpm / 2) / wpm;
+    };
+
+    // Speed in WPM.
+    uint8_t speed() { return wpm; };
+
+    // Whether the keyer is sending an element right now (for a sidetone or a transmitter).
+    bool key_down() { return state == KEYER_MARK; };
+
+    // Whether nothing has been sent, or is pending, for at least 'ms' ms. Disable interrupts around it if 'tick' runs in an ISR.
+    bool idle_for(unsigned long ms) {
+        return state == KEYER_IDLE && !ditMemory && !dahMemory && quiet >= ms;
+    };
+
+    // Advances the keyer by one ms with the paddles as they are now ('dit', 'dah' true while pressed). Returns true if it queued an event.
+    bool tick(bool dit, bool dah) {
+        switch (state) {
+            case KEYER_MARK:
+                remember(dit, dah);
+                if (--remaining == 0) { // the element is done: one unit of space follows
+                    state = KEYER_SPACE;
+                    remaining = unit;
+                }
+                return false;
+            case KEYER_SPACE:
+                remember(dit, dah);
+                if (--remaining > 0) {
+                    return false;
+                }
+                state = KEYER_IDLE;
+                quiet = unit; // the key has been up for the unit of space
+                break;
+            case KEYER_IDLE:
+                if (quiet < 0xFFFFFFFF) {
+                    quiet++;
+                }
+                break;
+        }
+        bool sendDah;
+        if (!next(dit, dah, sendDah)) {
+            return space();
+        }
+        state = KEYER_MARK;
+        sendingDah = lastDah = sendDah;
+        remaining = sendDah ? 3 * unit : unit;
+        ditMemory = dahMemory = false;
+        letterOpen = wordOpen = true;
+        return queue(sendDah ? KEYER_DAH : KEYER_DIT);
+    };
+
+    private:
+    enum State : uint8_t { KEYER_IDLE, KEYER_MARK, KEYER_SPACE };
+    State state = KEYER_IDLE;
+    uint8_t wpm = 20;
+    uint16_t unit = 60; // ms per dit
+    uint16_t remaining = 0; // ms left of the element or space being sent
+    uint32_t quiet = 0xFFFFFFFF; // ms the key has been up since the last element (saturating; wide enough for any POWER_DOWN_AFTER_MS)
+    bool sendingDah = false; // the element being sent is a dah
+    bool lastDah = false; // the last element sent was a dah (a squeeze alternates from it)
+    bool ditMemory = false, dahMemory = false; // the other paddle was pressed during the element
+    bool letterOpen = false; // elements were sent since the last letter space
+    bool wordOpen = false; // a letter was sent since the last word space
+
+    // Remembers the paddle that is not being sent if the mode says so.
+    void remember(bool dit, bool dah) {
+        bool other = sendingDah ? dit : dah;
+        bool same = sendingDah ? dah : dit;
+        if (other && (mode == KEYER_MODE_B || (memory && !same))) {
+            (sendingDah ? ditMemory : dahMemory) = true;
+        }
+    };
+
+    // Picks the next element: a remembered one first, then the paddles held now (alternating when both are). Returns false if there is none.
+    bool next(bool dit, bool dah, bool& sendDah) {
+        if (ditMemory || dahMemory) {
+            sendDah = dahMemory;
+        } else if (dit && dah) {
+            sendDah = letterOpen && !lastDah; // a squeeze that starts a letter starts with a dit
+        } else if (dit || dah) {
+            sendDah = dah;
+        } else {
+            return false;
+        }
+        return true;
+    };
+
+    // Reports the end of a letter or word once the key has been up long enough.
+    bool space() {
+        if (letterOpen && quiet >= LETTER_SPACE_UNITS * unit) {
+            letterOpen = false;
+            return queue(KEYER_LETTER_SPACE);
+        }
+        if (wordOpen && quiet >= WORD_SPACE_UNITS * unit) {
+            wordOpen = false;
+            return queue(KEYER_WORD_SPACE);
+        }
+        return false;
+    };
+
+    // Queues an event; the oldest one is overwritten if nobody collected them.
+    bool queue(KeyerEvent event) {
+        if (events.full()) {
+            dropped++;
+        }
+        events.push_over(event);
+        return true;
+    };
+};
+
+#endif // KEYER_H
\ No newline at end of file
@@ -0,0 +1,134 @@
+#ifndef LCD_H
+#define LCD_H
+
+/*
+Character lcds for Display (display.h), chosen at compile time:
+ * Hd44780 drives an HD44780 16x2 module over its 4-bit bus (RW tied to ground, so write only). The
+   six bus lines are pin policies (hal.h), so every line change is a single port instruction.
+ * HostLcd is a simulated 16x2 module for host builds: it keeps what each row shows.
+Both offer begin, clear, set_cursor and print.
+*/
+
+#include "platform.h"
+#include "hal.h"
+
+const uint8_t LCD_COLUMNS = 16;
+const uint8_t LCD_ROWS = 2;
+
+template <typename RS, typename EN, typename D4, typename D5, typename D6, typename D7, typename Clock = SystemClock>
+class Hd44780 { // HD44780 lcd on a 4-bit bus.
+    public: // Allows all objects in class to be used by other project files.
+
+    // Initialises the module for 4-bit mode, two lines, display on, cursor off, writing left to right (the power-up sequence of the datasheet).
+    void begin() {
+        RS::output();
+        EN::output();
+        D4::output();
+        D5::output();
+        D6::output();
+        D7::output();
+        RS::low();
+        EN::low();
+        Clock::delay_ms(50); // the module needs 40 ms after power rises
+        nibble(0x03); // 8-bit mode, three times, whatever state it was in
+        Clock::delay_us(4500);
+        nibble(0x03);
+        Clock::delay_us(4500);
+        nibble(0x03);
+        Clock::delay_us(150);
+        nibble(0x02); // now 4-bit
+        command(0x28); // function set: 4-bit bus, 2 lines, 5x8 font
+        command(0x0C); // display on, cursor and blinking off
+        clear();
+        command(0x06); // entry mode: left to right, no display shift
+    };
+
+    // Blanks the display and moves the cursor home.
+    void clear() {
+        command(0x01);
+        Clock::delay_us(2000); // clearing takes 1.52 ms
+    };
+
+    // Moves the cursor to 'column' of 'row' (both from 0).
+    void set_cursor(uint8_t column, uint8_t row) {
+        command(0x80 | (column + (row ? 0x40 : 0x00))); // the second row starts at address 0x40
+    };
+
+    // Writes text at the cursor. Returns the number of characters written.
+    size_t print(const char* text) {
+        size_t count = 0;
+        while (text[count] != '\0') {
+            send(text[count++], true);
+        }
+        return count;
+    };
+
+    private:
+
+    void command(uint8_t value) {
+        send(value, false);
+    };
+
+    // Sends a byte as two nibbles, as data (RS high) or as a command.
+    void send(uint8_t value, bool data) {
+        RS::write(data);
+        nibble(value >> 4);
+        nibble(value & 0x0F);
+    };
+
+    // Puts four bits on D4-D7 and clocks them in on the falling edge of EN.
+    void nibble(uint8_t bits) {
+        D4::write(bits & 0x01);
+        D5::write(bits & 0x02);
+        D6::write(bits & 0x04);
+        D7::write(bits & 0x08);
+        EN::high();
+        Clock::delay_us(1); // enable pulse must be at least 450 ns
+        EN::low();
+        Clock::delay_us(50); // commands take 37 us
+    };
+};
+
+class HostLcd { // Simulated 16x2 lcd: keeps the characters on each row.
+    public: // Allows all objects in class to be used by other project files.
+    char rows[LCD_ROWS][LCD_COLUMNS + 1]; // what each row shows, as strings
+    unsigned long writes = 0; // characters written
+
+    HostLcd() {
+        clear();
+    };
+
+    void begin() {
+        clear();
+    };
+
+    void clear() {
+        for (uint8_t row = 0; row < LCD_ROWS; row++) {
+            memset(rows[row], ' ', LCD_COLUMNS);
+            rows[row][LCD_COLUMNS] = '\0';
+        }
+        column = row = 0;
+    };
+
+    void set_cursor(uint8_t newColumn, uint8_t newRow) {
+        column = newColumn;
+        row = newRow < LCD_ROWS ? newRow : LCD_ROWS - 1;
+    };
+
+    size_t print(const char* text) {
+        size_t count = 0;
+        for (; text[count] != '\0'; count++) {
+            if (column < LCD_COLUMNS) { // characters past the end of the row are not visible
+                rows[row][column] = text[count];
+            }
+            column++;
+            writes++;
+        }
+        return count;
+    };
+
+    private:
+    uint8_t column = 0, row = 0; // cursor
+};
+
+#endif // LCD_H
\ No newline at end of file
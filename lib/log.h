@@ -0,0 +1,97 @@
+#ifndef LOG_H
+#define LOG_H
+
+/*
+Logging facade with compile-time levels and categories.
+
+ * MORSE_LOG_LEVEL picks the most verbose level that is compiled in (default LOG_LEVEL_INFO).
+ * MORSE_LOG_CATEGORIES is a bit mask of the categories that are compiled in (default all).
+
+A statement above the level expands to nothing, so its format string never reaches flash or RAM.
+A statement in a masked-out category is a constant-false branch and is removed by the optimizer.
+Enabled statements keep their format string in flash (PSTR) and format it into a small stack buffer.
+
+Text logging is switched off entirely when MORSE_TELEMETRY is defined, since the serial port then
+carries the binary event stream instead.
+
+Example:
+    LOG_INFO(LOG_CAT_DECODE, "Morse code %s matches letter %c", pattern, letter);
+*/
+
+#include "platform.h"
+#include <stdarg.h>
+
+#define LOG_LEVEL_NONE 0 // no text output at all
+#define LOG_LEVEL_ERROR 1 // failures the device cannot recover from
+#define LOG_LEVEL_WARN 2 // rejected or invalid input
+#define LOG_LEVEL_INFO 3 // decoded letters and state changes
+#define LOG_LEVEL_DEBUG 4 // every press, release and intermediate value
+
+#define LOG_CAT_INPUT 0x01 // button presses, patterns and duration arrays
+#define LOG_CAT_DECODE 0x02 // pattern to letter lookups
+#define LOG_CAT_DISPLAY 0x04 // lcd and rgb light output
+#define LOG_CAT_SYSTEM 0x08 // setup, memory and diagnostics
+#define LOG_CAT_ALL 0xFF
+
+#ifndef MORSE_LOG_LEVEL
+#define MORSE_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#ifndef MORSE_LOG_CATEGORIES
+#define MORSE_LOG_CATEGORIES LOG_CAT_ALL
+#endif
+
+#ifdef MORSE_TELEMETRY // the serial port carries binary frames; text would corrupt the stream
+#undef MORSE_LOG_LEVEL
+#define MORSE_LOG_LEVEL LOG_LEVEL_NONE
+#endif
+
+const uint8_t LOG_LINE_SIZE = 64; // longest formatted log line including the terminator
+
+class Log { // Formats flash-resident log messages and writes them to serial.
+    public: // Allows all objects in class to be used by other project files.
+
+    // Formats a message whose format string is stored in flash and prints it as one line.
+    static void print_P(const char* format, ...) {
+        char line[LOG_LINE_SIZE]; // formatted message, truncated if longer
+        va_list args;
+        va_start(args, format);
+        vsnprintf_P(line, sizeof(line), format, args);
+        va_end(args);
+        Serial.println(line);
+    };
+};
+
+// Logs a message if its category is compiled in. Only used by the level macros below.
+#define LOG_AT(category, format, ...) \
+    do { \
+        if ((category) & (MORSE_LOG_CATEGORIES)) Log::print_P(PSTR(format), ##__VA_ARGS__); \
+    } while (0)
+
+#define LOG_NOTHING() do { } while (0)
+
+#if MORSE_LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(category, format, ...) LOG_AT(category, format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(category, format, ...) LOG_NOTHING()
+#endif
+
+#if MORSE_LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(category, format, ...) LOG_AT(category, format, ##__VA_ARGS__)
+#else
+#define LOG_WARN(category, format, ...) LOG_NOTHING()
+#endif
+
+#if MORSE_LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(category, format, ...) LOG_AT(category, format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(category, format, ...) LOG_NOTHING()
+#endif
+
+#if MORSE_LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(category, format, ...) LOG_AT(category, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(category, format, ...) LOG_NOTHING()
+#endif
+
+#endif // LOG_H
\ No newline at end of file
@@ -0,0 +1,240 @@
+#ifndef LOOP_MONITOR_H
+#define LOOP_MONITOR_H
+
+/*
+Main-loop latency and jitter monitor.
+
+Enabled by adding '-D MORSE_LOOP_MONITOR' to 'build_flags' in platformio.ini; otherwise every macro
+below expands to nothing. Records the loop period, the longest stall, a log2 histogram of the
+loop-to-loop jitter and the latency from a key release to the decoded character being on the LCD.
+
+Any loop period longer than LOOP_STALL_BUDGET_US is flagged over serial together with the name of the
+last profiled section (needs MORSE_PROFILE as well, otherwise the section is reported as "n/a").
+
+The report is written one line per loop iteration and only when the serial TX buffer has room for
+the whole line, so reading it never blocks decoding.
+*/
+
+#include "platform.h"
+#include "profile.h"
+
+#ifndef LOOP_STALL_BUDGET_US
+#define LOOP_STALL_BUDGET_US 5000 // loop periods longer than this (us) are reported as stalls
+#endif
+
+#ifdef MORSE_LOOP_MONITOR
+
+const uint8_t LOOP_JITTER_BINS = 12; // log2 buckets of jitter: <2us, <4us, ... >=2048us
+const uint8_t LOOP_REPORT_LINE_SPACE = 48; // free TX bytes needed before a report line is written; every line is at most this long
+const uint8_t LOOP_REPORT_HEADER_LINES = 7; // report lines before the jitter histogram
+
+class LoopMonitor { // Measures how regularly loop() runs and how long decoded characters take to show up.
+    public: // Allows all objects in class to be used by other project files.
+
+    struct LoopStats { // Everything the monitor reports, copied as a whole when a report starts.
+        uint32_t iterations; // number of measured loop periods
+        uint32_t minPeriod; // shortest loop period (us)
+        uint32_t maxPeriod; // longest loop period, i.e. the worst stall (us)
+        uint32_t totalPeriod; // sum of loop periods, for the mean (us)
+        uint16_t jitter[LOOP_JITTER_BINS]; // histogram of |period - previous period|, saturating
+        uint16_t stalls; // loop periods over the budget
+        uint32_t lastStall; // length of the most recent stall (us)
+        uint8_t lastStallProbe; // last profiled section entered before the most recent stall
+        uint16_t latencyCount; // number of release -> character visible measurements
+        uint32_t latencyLast; // most recent release -> visible latency (us)
+        uint32_t latencyMax; // worst release -> visible latency (us)
+        uint32_t latencyTotal; // sum of latencies, for the mean (us)
+    };
+
+    LoopStats stats; // live statistics
+    LoopStats report; // snapshot being printed
+    int8_t reportLine = -1; // next report line to print, -1 when no report is in progress
+    bool stallPending = false; // a stall happened and has not been printed yet
+    uint32_t lastTick = 0; // micros() at the previous loop iteration
+    uint32_t lastPeriod = 0; // previous loop period, for jitter (us)
+    uint32_t releaseTime = 0; // micros() of the key release whose character is not displayed yet
+    bool releasePending = false; // a key release is waiting for its character to be displayed
+
+    LoopMonitor() {
+        reset();
+    };
+
+    // Clears all statistics.
+    void reset() {
+        memset(&stats, 0, sizeof(stats));
+        stats.minPeriod = 0xFFFFFFFF; // so the first period always becomes the minimum
+        stats.lastStallProbe = PROBE_NONE;
+        lastTick = 0;
+        lastPeriod = 0;
+    };
+
+    // Called once at the top of loop(): measures the period since the previous call.
+    void tick() {
+        uint32_t now = micros();
+        if (lastTick == 0) { // first iteration after boot or reset; nothing to compare against yet
+            lastTick = now;
+            return;
+        }
+        uint32_t period = now - lastTick;
+        lastTick = now;
+
+        stats.iterations++;
+        stats.totalPeriod += period;
+        if (period < stats.minPeriod) stats.minPeriod = period;
+        if (period > stats.maxPeriod) stats.maxPeriod = period;
+
+        if (lastPeriod != 0) { // jitter needs two periods
+            uint32_t jitter = period > lastPeriod ? period - lastPeriod : lastPeriod - period;
+            uint8_t bin = 0;
+            while ((jitter >>= 1) && bin < LOOP_JITTER_BINS - 1) bin++;
+            if (stats.jitter[bin] != 0xFFFF) stats.jitter[bin]++;
+        }
+        lastPeriod = period;
+
+        if (period > LOOP_STALL_BUDGET_US) {
+            stats.stalls++;
+            stats.lastStall = period;
+#ifdef MORSE_PROFILE
+            stats.lastStallProbe = profiler.lastProbe;
+#endif
+            stallPending = true;
+        }
+    };
+
+    // Called when the key is released: starts the release -> visible latency measurement.
+    void mark_release() {
+        releaseTime = micros();
+        releasePending = true;
+    };
+
+    // Called once a decoded character has been written to the LCD.
+    void mark_visible() {
+        if (!releasePending) { // display update that was not caused by a key release
+            return;
+        }
+        uint32_t latency = micros() - releaseTime;
+        releasePending = false;
+        stats.latencyCount++;
+        stats.latencyLast = latency;
+        stats.latencyTotal += latency;
+        if (latency > stats.latencyMax) stats.latencyMax = latency;
+    };
+
+    // Starts printing a report of the current statistics.
+    void start_report() {
+        report = stats;
+        reportLine = 0;
+    };
+
+    // Writes at most one pending line (stall flag or report line) if it fits in the serial TX buffer.
+    void service() {
+        if (Serial.availableForWrite() < LOOP_REPORT_LINE_SPACE) { // printing now would block
+            return;
+        }
+        if (stallPending) {
+            stallPending = false;
+            Serial.print(F("STALL "));
+            Serial.print(stats.lastStall);
+            Serial.print(F("us after "));
+            print_probe(stats.lastStallProbe);
+            Serial.println();
+            return;
+        }
+        if (reportLine < 0) {
+            return;
+        }
+        print_report_line(reportLine);
+        reportLine = reportLine + 1 < LOOP_REPORT_HEADER_LINES + LOOP_JITTER_BINS ? reportLine + 1 : -1;
+    };
+
+    private:
+
+    // Prints the name of a profiled section (or "n/a" when profiling is disabled).
+    static void print_probe(uint8_t probe) {
+#ifdef MORSE_PROFILE
+        Profiler::print_name(probe);
+#else
+        (void)probe;
+        Serial.print(F("n/a"));
+#endif
+    };
+
+    // Prints a single line of the report. Every line stays within LOOP_REPORT_LINE_SPACE bytes even with 10-digit numbers, so 'service' never waits for the TX buffer.
+    void print_report_line(int8_t line) {
+        switch (line) {
+            case 0: // at most 34 bytes
+                Serial.print(F("loop n="));
+                Serial.print(report.iterations);
+                Serial.print(F(" min="));
+                Serial.println(report.iterations ? report.minPeriod : 0);
+                break;
+            case 1: // at most 37 bytes
+                Serial.print(F("loop mean="));
+                Serial.print(report.iterations ? report.totalPeriod / report.iterations : 0);
+                Serial.print(F(" max="));
+                Serial.println(report.maxPeriod);
+                break;
+            case 2: // at most 43 bytes
+                Serial.print(F("stalls>"));
+                Serial.print((uint32_t)LOOP_STALL_BUDGET_US);
+                Serial.print(F("us="));
+                Serial.print(report.stalls);
+                Serial.print(F(" last="));
+                Serial.println(report.lastStall);
+                break;
+            case 3: // at most 25 bytes (the longest probe name is 14)
+                Serial.print(F("last stall in "));
+                print_probe(report.lastStallProbe);
+                Serial.println();
+                break;
+            case 4: // at most 38 bytes
+                Serial.print(F("release->lcd n="));
+                Serial.print(report.latencyCount);
+                Serial.print(F(" last="));
+                Serial.println(report.latencyLast);
+                break;
+            case 5: // at most 45 bytes
+                Serial.print(F("release->lcd mean="));
+                Serial.print(report.latencyCount ? report.latencyTotal / report.latencyCount : 0);
+                Serial.print(F(" max="));
+                Serial.println(report.latencyMax);
+                break;
+            case 6:
+                Serial.println(F("jitter <us count"));
+                break;
+            default: { // one histogram bucket per line
+                uint8_t bin = line - LOOP_REPORT_HEADER_LINES;
+                Serial.print(F("  "));
+                if (bin == LOOP_JITTER_BINS - 1) { // last bucket is open-ended
+                    Serial.print(F(">="));
+                    Serial.print(1UL << bin);
+                } else {
+                    Serial.print(2UL << bin);
+                }
+                Serial.print(' ');
+                Serial.println(report.jitter[bin]);
+                break;
+            }
+        }
+    };
+} loopMonitor;
+
+#define LOOP_MONITOR_TICK() loopMonitor.tick()
+#define LOOP_MONITOR_RELEASE() loopMonitor.mark_release()
+#define LOOP_MONITOR_VISIBLE() loopMonitor.mark_visible()
+#define LOOP_MONITOR_REPORT() loopMonitor.start_report()
+#define LOOP_MONITOR_RESET() loopMonitor.reset()
+#define LOOP_MONITOR_SERVICE() loopMonitor.service()
+
+#else // MORSE_LOOP_MONITOR
+
+#define LOOP_MONITOR_TICK()
+#define LOOP_MONITOR_RELEASE()
+#define LOOP_MONITOR_VISIBLE()
+#define LOOP_MONITOR_REPORT()
+#define LOOP_MONITOR_RESET()
+#define LOOP_MONITOR_SERVICE()
+
+#endif // MORSE_LOOP_MONITOR
+
+#endif // LOOP_MONITOR_H
\ No newline at end of file
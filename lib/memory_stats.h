@@ -0,0 +1,201 @@
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+/*
+Stack and heap high-water-mark instrumentation.
+
+Enabled by adding '-D MORSE_MEMORY_STATS' to 'build_flags' in platformio.ini; otherwise every macro
+below expands to nothing. Heap tracking additionally needs the allocator to be wrapped at link time:
+    -Wl,--wrap=malloc -Wl,--wrap=free -Wl,--wrap=realloc
+(without those flags the heap counters simply stay at zero).
+
+ * At boot (.init3, before constructors run) all SRAM between the end of .bss and the top of the stack
+   is painted with STACK_CANARY. The deepest stack use is found later by scanning for the first byte
+   that is no longer the canary.
+ * Every malloc/free/realloc updates the bytes in use, the peak and the allocation counters.
+ * MEMORY_DUMP() prints everything over serial; MEMORY_CHECK() warns once when the gap between heap and
+   stack has ever dropped below MEMORY_LOW_WATERMARK bytes.
+*/
+
+#include "platform.h"
+#include "log.h"
+
+#ifndef MEMORY_LOW_WATERMARK
+#define MEMORY_LOW_WATERMARK 128 // warn when fewer than this many bytes were ever left between heap and stack
+#endif
+
+#ifdef MORSE_MEMORY_STATS
+
+#include <stdlib.h>
+
+const uint8_t STACK_CANARY = 0xC5; // paint value for unused SRAM
+const unsigned long MEMORY_CHECK_INTERVAL = 1000; // ms between low-memory checks (the scan is not free)
+
+extern uint8_t _end; // end of .bss, where the heap starts (from the linker script)
+extern uint8_t __stack; // top of SRAM, where the stack starts (from the linker script)
+extern char* __brkval; // current top of the heap, 0 until the first malloc (avr-libc)
+
+// Paints unused SRAM with the canary. Runs from .init3, after the stack pointer is set up but before
+// any constructors; naked and written in assembly so it does not touch the stack it is painting.
+void memory_paint_stack(void) __attribute__((naked, used, section(".init3")));
+void memory_paint_stack(void) {
+    __asm volatile(
+        "    ldi r30, lo8(_end)\n"
+        "    ldi r31, hi8(_end)\n"
+        "    ldi r24, %0\n"
+        "    ldi r25, hi8(__stack)\n"
+        "    rjmp 2f\n"
+        "1:  st Z+, r24\n"
+        "2:  cpi r30, lo8(__stack)\n"
+        "    cpc r31, r25\n"
+        "    brlo 1b\n"
+        "    breq 1b\n"
+        :: "M"(STACK_CANARY));
+}
+
+class MemoryStats { // Tracks heap usage and measures how deep the stack has ever grown.
+    public: // Allows all objects in class to be used by other project files.
+
+    size_t heapInUse = 0; // bytes currently allocated (allocator chunk sizes)
+    size_t heapPeak = 0; // most bytes ever allocated at once
+    uint16_t allocations = 0; // successful malloc/realloc calls
+    uint16_t frees = 0; // free calls with a non-null pointer
+    uint16_t failures = 0; // allocations that returned null
+    bool lowWarned = false; // the low-memory warning has been printed
+    unsigned long lastCheck = 0; // millis() of the last low-memory check
+
+    // Returns the current top of the heap (start of the free gap below the stack).
+    static uint8_t* heap_top() {
+        return __brkval ? (uint8_t*)__brkval : &_end;
+    };
+
+    // Returns the bytes currently free between the heap and the stack pointer.
+    static size_t free_now() {
+        uint8_t marker; // lives at the current top of the stack
+        return &marker - heap_top();
+    };
+
+    // Returns the smallest gap there has ever been between heap and stack (still-painted bytes).
+    static size_t free_low_water() {
+        uint8_t* p = heap_top();
+        size_t unused = 0; // canary bytes above the heap that the stack never reached
+        while (p <= &__stack && *p == STACK_CANARY) {
+            p++;
+            unused++;
+        }
+        return unused;
+    };
+
+    // Returns the deepest the stack has ever been, in bytes.
+    static size_t stack_high_water() {
+        return (&__stack + 1) - heap_top() - free_low_water();
+    };
+
+    // Records the allocator chunk behind a pointer returned by malloc/realloc.
+    void on_allocate(void* pointer) {
+        if (pointer == NULL) {
+            failures++;
+            return;
+        }
+        allocations++;
+        heapInUse += chunk_size(pointer);
+        if (heapInUse > heapPeak) heapPeak = heapInUse;
+    };
+
+    // Records a pointer about to be handed back to free/realloc.
+    void on_release(void* pointer) {
+        if (pointer == NULL) {
+            return;
+        }
+        frees++;
+        heapInUse -= chunk_size(pointer);
+    };
+
+    // Warns once if the heap/stack gap has ever fallen below MEMORY_LOW_WATERMARK. Rate limited.
+    void check() {
+        if (lowWarned || millis() - lastCheck < MEMORY_CHECK_INTERVAL) {
+            return;
+        }
+        lastCheck = millis();
+        size_t lowWater = free_low_water();
+        if (lowWater < MEMORY_LOW_WATERMARK) {
+            lowWarned = true;
+            LOG_WARN(LOG_CAT_SYSTEM, "Low memory: only %u bytes ever left between heap and stack.", (unsigned)lowWater);
+        }
+    };
+
+    // Prints stack and heap statistics over serial.
+    void dump() {
+        Serial.print(F("stack max="));
+        Serial.print((unsigned)stack_high_water());
+        Serial.print(F(" free now="));
+        Serial.print((unsigned)free_now());
+        Serial.print(F(" low water="));
+        Serial.println((unsigned)free_low_water());
+        Serial.print(F("heap in use="));
+        Serial.print((unsigned)heapInUse);
+        Serial.print(F(" peak="));
+        Serial.print((unsigned)heapPeak);
+        Serial.print(F(" allocs="));
+        Serial.print(allocations);
+        Serial.print(F(" frees="));
+        Serial.print(frees);
+        Serial.print(F(" failed="));
+        Serial.println(failures);
+    };
+
+    private:
+
+    // avr-libc keeps the usable size of each chunk in the two bytes just before the returned pointer.
+    static size_t chunk_size(void* pointer) {
+        return ((size_t*)pointer)[-1];
+    };
+} memoryStats;
+
+// Allocator wrappers, only linked in when the --wrap flags are given.
+extern "C" {
+    void* __real_malloc(size_t size);
+    void __real_free(void* pointer);
+    void* __real_realloc(void* pointer, size_t size);
+
+    void* __wrap_malloc(size_t size) {
+        void* pointer = __real_malloc(size);
+        memoryStats.on_allocate(pointer);
+        return pointer;
+    }
+
+    void __wrap_free(void* pointer) {
+        memoryStats.on_release(pointer);
+        __real_free(pointer);
+    }
+
+    void* __wrap_realloc(void* pointer, size_t size) {
+        size_t oldSize = pointer ? ((size_t*)pointer)[-1] : 0; // read before the chunk is moved or freed
+        void* resized = __real_realloc(pointer, size);
+        if (resized == NULL) {
+            if (pointer && size == 0) { // behaved like free()
+                memoryStats.heapInUse -= oldSize;
+                memoryStats.frees++;
+            } else { // failed: the old chunk is untouched
+                memoryStats.failures++;
+            }
+            return resized;
+        }
+        memoryStats.heapInUse -= oldSize;
+        if (pointer) memoryStats.frees++;
+        memoryStats.on_allocate(resized);
+        return resized;
+    }
+}
+
+#define MEMORY_DUMP() memoryStats.dump()
+#define MEMORY_CHECK() memoryStats.check()
+
+#else // MORSE_MEMORY_STATS
+
+#define MEMORY_DUMP()
+#define MEMORY_CHECK()
+
+#endif // MORSE_MEMORY_STATS
+
+#endif // MEMORY_STATS_H
\ No newline at end of file
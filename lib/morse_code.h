@@ -1,83 +1,105 @@
 #ifndef MORSE_CODE_H
 #define MORSE_CODE_H
 
-#include <ArduinoSTL.h>
+#include "platform.h"
+#include "containers.h"
 #include "durations.h"
+#include "log.h"
+#include "profile.h"
+#include "telemetry.h"
 
-class MorseCode { // Processes the logic behind the morse code input patterns. Checks for validity of input pattern (i.e. '..-.') as well as calculates short or long presses.
-    private: // Constants accessed by only this class are private. 
+const int MAX_PATTERN_SLOTS = 5; // longest letter pattern (4 presses) plus the terminator
 
-    const char* const validPatterns[26] PROGMEM = { // Array containing (already sorted from A-Z) of valid morse code patterns where shortPress=0 and longPress=1.
+// Array containing (already sorted from A-Z) of valid morse code patterns where shortPress=0 and longPress=1. Stored in flash memory.
+const char validPatterns[26][MAX_PATTERN_SLOTS] PROGMEM = {
     "01", "1000", "1010", "100", "0", "0010", "110", "0000", 
     "00", "0111", "101", "0100", "11", "10", "111", "0110", 
     "1101", "010", "000", "1", "001", "0001", "011", "1001", 
     "1011", "1100"
-    };
+};
 
-    const char alphabet[27] PROGMEM = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"; // Array of 'char' containing a string of the whole alphabet.
+const char alphabet[27] PROGMEM = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"; // Array of 'char' containing a string of the whole alphabet.
 
+// Packs a pattern of up to 7 presses ('0' short, '1' long) into one byte: a leading 1 bit marks where the pattern starts, then one bit per press (1 for long). "01" (A) is 0b101, "" is 1.
+inline uint8_t pack_pattern(const char* pattern) {
+    uint8_t packed = 1;
+    for (int i = 0; pattern[i] != '\0' && i < 7; i++) {
+        packed = (packed << 1) | (pattern[i] == '1');
+    }
+    return packed;
+}
 
+// Packed pattern (see pack_pattern) of the letter at 'index' (0 for A) in 'validPatterns'.
+inline uint8_t packed_letter(int index) {
+    uint8_t packed = 1;
+    for (int i = 0; i < MAX_PATTERN_SLOTS - 1; i++) {
+        char press = pgm_read_byte(&validPatterns[index][i]);
+        if (press == '\0') {
+            break;
+        }
+        packed = (packed << 1) | (press == '1');
+    }
+    return packed;
+}
+
+class MorseCode { // Processes the logic behind the morse code input patterns. Checks for validity of input pattern (i.e. '..-.') as well as calculates short or long presses.
     public: // Allows for objects in class to be used by other project files.
    
-    // Adds user's input (i.e. "0" or "1" for short or long press) to array containing the pattern. For storing a pattern of inputs, which is later used to handle proper character detection.
-    bool add_input(char* array, char newChar, int inputSize) { 
-        int length = strlen(array); // The current amount of objects in the current array.
-        if (length < inputSize - 2) { // Ensures there is space for the new character and null terminator
-            array[length] = newChar; // Adds to the end of the array the user's input.
-            array[length + 1] = '\0'; // Null-terminate the string.
-            // Serial output
-            Serial.print("Added to pattern: ");
-            Serial.println(newChar);
+    // Adds user's input (i.e. "0" or "1" for short or long press) to the string containing the pattern. For storing a pattern of inputs, which is later used to handle proper character detection.
+    template <uint8_t N>
+    bool add_input(BoundedString<N>& pattern, char newChar) {
+        if (pattern.append(newChar)) { // Adds to the end of the pattern the user's input, if there is space left.
+            TELEMETRY_PATTERN(newChar, true);
+            LOG_DEBUG(LOG_CAT_INPUT, "Added to pattern: %c", newChar);
             return true; // Successfully added
         } else {
-            Serial.println("Array containing pattern is full.");
+            TELEMETRY_PATTERN(newChar, false);
+            LOG_WARN(LOG_CAT_INPUT, "Array containing pattern is full.");
             return false; // Array is full
         }
     };
 
     // Adds press or release durations to the respective array for handling short or long press variability detection.
-    bool add_duration(int* array, int dataPoint, int inputSize) {
-        int length = sizeof(array) / sizeof(*array); // The current amount of objects in the current array of type 'int'.
-        if (length < inputSize - 2) { // Ensures there is space for the new data point.
-            array[length] = dataPoint; // Adds the data point to the array.
-            // Serial output
-            Serial.print("Added to duration array: ");
-            Serial.println(dataPoint);
+    template <uint8_t N>
+    bool add_duration(StaticVector<int, N>& durations, int dataPoint) {
+        if (durations.push_back(dataPoint)) { // Adds the data point, if there is space left.
+            TELEMETRY_DURATION(dataPoint, true);
+            LOG_DEBUG(LOG_CAT_INPUT, "Added to duration array: %d", dataPoint);
             return true; // Successfully added data point
         } else {
-            Serial.println("Array containing data points is full.");
+            TELEMETRY_DURATION(dataPoint, false);
+            LOG_WARN(LOG_CAT_INPUT, "Array containing data points is full.");
             return false; // Array is full
         }
     };
 
     // Gets the corresponding letter from the user's input pattern, if valid, from program memory.
-    char get_letter(char* user_pattern) {
+    char get_letter(const char* user_pattern) {
+        PROFILE_SCOPE(PROBE_GET_LETTER); // times the pattern lookup (including serial output)
         for (int i = 0; i < 26; i++) { // Loops through alphabet[] array size
-            if (strcmp_P(user_pattern, (char*)pgm_read_word(&(validPatterns[i]))) == 0) { // Compares RAM-based 'code' string to 'alphabet' flash memory string; returns 0 if a match.
-                // Serial output
-                Serial.print("Morse code ");
-                Serial.print(user_pattern);
-                Serial.print(" matches letter ");
-                Serial.println((char)pgm_read_byte(&(alphabet[i])));
+            if (strcmp_P(user_pattern, validPatterns[i]) == 0) { // Compares RAM-based 'code' string to 'alphabet' flash memory string; returns 0 if a match.
+                TELEMETRY_LETTER(pgm_read_byte(&(alphabet[i])), user_pattern);
+                LOG_INFO(LOG_CAT_DECODE, "Morse code %s matches letter %c", user_pattern, (char)pgm_read_byte(&(alphabet[i])));
                 return pgm_read_byte(&(alphabet[i])); // Address of the morse code string for the letter at index 'i' in the 'morseCode' memory.
             }
         }
 
         // If the user's input pattern is invalid (there's no match)
-        Serial.print("Morse code ");
-        Serial.print(user_pattern);
-        Serial.println(" does not match any letter.");
+        TELEMETRY_LETTER('?', user_pattern);
+        LOG_WARN(LOG_CAT_DECODE, "Morse code %s does not match any letter.", user_pattern);
         return '?'; // Return '?' if no match found
     };
     
     // Clears user's input morse code pattern which is stored in memory.
-    void clear_input(char* userInput) { 
-        memset(userInput, 0, sizeof(userInput));
+    template <uint8_t N>
+    void clear_input(BoundedString<N>& userInput) {
+        userInput.clear();
     };
 
     // Clears the arrays storing the duration of presses and releases for calculating avg and std.
-    void clear_duration(int* array) {
-        memset(array, 0, sizeof(array));
+    template <uint8_t N>
+    void clear_duration(StaticVector<int, N>& durations) {
+        durations.clear();
     };
 
     // 
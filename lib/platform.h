@@ -0,0 +1,127 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+/*
+Thin hardware abstraction so the decoder core in lib/ builds both for the Uno and on a Linux host.
+
+On the Uno (ARDUINO defined by the framework) this is just the Arduino core. On the host it provides
+the small subset of the Arduino API the core uses: millis(), digitalRead()/digitalWrite() backed by a
+simulated pin array, a Serial that prints to stdout, the avr/pgmspace.h helpers as plain reads and the
+avr/eeprom.h byte functions backed by a simulated EEPROM.
+*/
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+
+#else // host build
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+// Program memory is ordinary memory on the host.
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define pgm_read_ptr(address) (*(void* const*)(address))
+#define strcmp_P strcmp
+#define strlen_P strlen
+#define memcpy_P memcpy
+#define vsnprintf_P vsnprintf
+
+const uint8_t HOST_PIN_COUNT = 20; // digital pins 0-13 and analog pins A0-A5 of the Uno
+#define E2END 0x3FF // last EEPROM address (1 KB, as on the ATmega328P)
+
+class HostPlatform { // State behind the host versions of the Arduino functions.
+    public: // Allows all objects in class to be used by other project files.
+    unsigned long now = 0; // value returned by millis()
+    uint8_t pins[HOST_PIN_COUNT] = {}; // levels returned by digitalRead() / set by digitalWrite()
+    uint8_t modes[HOST_PIN_COUNT] = {}; // modes set by pinMode()
+    uint8_t eeprom[E2END + 1]; // EEPROM contents, erased (0xFF) at start
+    unsigned long eepromWrites = 0; // bytes actually written (eeprom_update_byte skips unchanged ones)
+
+    HostPlatform() {
+        memset(eeprom, 0xFF, sizeof(eeprom));
+    };
+} hostPlatform;
+
+inline unsigned long millis() {
+    return hostPlatform.now;
+}
+
+inline unsigned long micros() {
+    return hostPlatform.now * 1000;
+}
+
+inline int digitalRead(uint8_t pin) {
+    return pin < HOST_PIN_COUNT ? hostPlatform.pins[pin] : LOW;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < HOST_PIN_COUNT) hostPlatform.pins[pin] = value ? HIGH : LOW;
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < HOST_PIN_COUNT) hostPlatform.modes[pin] = mode;
+}
+
+// EEPROM addresses are pointers on the AVR; writes complete at once.
+inline uint8_t eeprom_read_byte(const uint8_t* address) {
+    return hostPlatform.eeprom[(uintptr_t)address & E2END];
+}
+
+inline void eeprom_update_byte(uint8_t* address, uint8_t value) {
+    uint8_t& cell = hostPlatform.eeprom[(uintptr_t)address & E2END];
+    if (cell != value) {
+        cell = value;
+        hostPlatform.eepromWrites++;
+    }
+}
+
+inline bool eeprom_is_ready() {
+    return true;
+}
+
+// Waits return at once: time only moves when the simulation moves it.
+inline void delay(unsigned long) {}
+inline void delayMicroseconds(unsigned int) {}
+
+// There are no interrupts on the host.
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class HostSerial { // Stand-in for the Arduino Serial object; output goes to stdout.
+    public: // Allows all objects in class to be used by other project files.
+    void begin(unsigned long) {};
+    int available() { return 0; };
+    int read() { return -1; };
+    int availableForWrite() { return 64; };
+    size_t write(uint8_t value) { return fputc(value, stdout) == EOF ? 0 : 1; };
+    size_t print(const char* text) { return fputs(text, stdout) < 0 ? 0 : strlen(text); };
+    size_t print(char value) { return write(value); };
+    size_t print(int value) { return printf("%d", value); };
+    size_t print(unsigned int value) { return printf("%u", value); };
+    size_t print(long value) { return printf("%ld", value); };
+    size_t print(unsigned long value) { return printf("%lu", value); };
+    size_t print(double value) { return printf("%.2f", value); };
+    size_t println() { return write('\n'); };
+    template <typename T> size_t println(T value) { return print(value) + println(); };
+} Serial;
+
+#endif // ARDUINO
+
+#endif // PLATFORM_H
\ No newline at end of file
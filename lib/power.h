@@ -0,0 +1,144 @@
+#ifndef POWER_H
+#define POWER_H
+
+/*
+Sleep modes for the idle main loop.
+
+When no task is ready, loop() puts the CPU to sleep instead of polling:
+ * IDLE stops only the CPU clock. Timers, the USART and pin change interrupts keep running, so it
+   is woken about 2000 times a second: by the debounce tick of timer 2 (TickTimer, every 1 ms) and by
+   the millis() tick of timer 0 (every 1.024 ms), each time for an interrupt handler and a look at
+   the scheduler, as well as by serial input and the key. Waking takes a few cycles. What it saves
+   is the CPU core's clock between those wakes; the board around the ATmega328P (USB interface chip,
+   regulator, power LED) draws the same asleep or awake, so the saving is a fraction of the board's
+   current. Neither has been measured on hardware yet: the 'z' report gives the share of time
+   asleep and the wakes per second to combine with a current meter.
+ * POWER-DOWN stops every clock, millis() included; only the key's pin change wakes it, after the
+   crystal has restarted (16K clock cycles, 1 ms at 16 MHz). It is only worth it (and only correct,
+   as millis() stands still) when nothing is waiting for a deadline, so loop() uses it after the key
+   has been left alone for POWER_DOWN_AFTER_MS, with the serial output flushed and the light off.
+
+The key is debounced in the tick interrupt, which times each edge at its first stable sample (see
+debouncer.h), so an edge keeps its own time however long the CPU takes to get to it. The stats below
+record two delays. The wake latency runs from the key's first pin change to its capture, so it
+includes the bounce and the 4 ms the debouncer waits. The capture latency runs from the tick that
+accepted the edge to its capture: what waking from sleep and the task already running add.
+*/
+
+#include "platform.h"
+
+#ifdef ARDUINO
+#include <avr/power.h>
+#include <avr/sleep.h>
+#endif
+
+#ifndef POWER_DOWN_AFTER_MS
+#define POWER_DOWN_AFTER_MS 60000 // key idle time before the board powers down (ms); 0 keeps it in IDLE, which still answers serial
+#endif
+
+enum SleepDepth : uint8_t { // How deeply 'Power::sleep' puts the CPU to sleep.
+    SLEEP_IDLE, // CPU stopped, timers and serial running
+    SLEEP_POWER_DOWN // everything stopped until the key changes
+};
+
+class Power { // Puts the CPU to sleep when the main loop has nothing to do, and keeps count.
+    public: // Allows all objects in class to be used by other project files.
+    uint32_t idleSleeps = 0; // times the CPU went to sleep in IDLE
+    uint32_t powerDowns = 0; // times the board powered down
+    uint32_t asleepUs = 0; // time spent in IDLE sleep (us); time powered down is not counted, millis()/micros() stop then
+    uint32_t sinceUs = 0; // micros() at the last 'reset_stats', for the share of time asleep
+    uint16_t wakeLastUs = 0; // key change to its capture for the most recent change (us, saturating)
+    uint16_t wakeWorstUs = 0; // longest key change to capture seen (us, saturating)
+    uint16_t captureLastUs = 0; // debounced edge to its capture for the most recent change (us, saturating)
+    uint16_t captureWorstUs = 0; // longest debounced edge to capture seen (us, saturating)
+
+    // Turns off the peripherals the firmware does not use (ADC, SPI, TWI, timer 2 unless TickTimer turns it back on), so they draw nothing awake or asleep.
+    void begin() {
+#ifdef ARDUINO
+        ADCSRA &= ~_BV(ADEN); // the ADC must be off before its clock is stopped
+        power_adc_disable();
+        power_spi_disable();
+        power_twi_disable();
+        power_timer2_disable();
+#endif
+        reset_stats();
+    };
+
+    // Sleeps until an interrupt. Call with interrupts disabled, right after checking that nothing is ready: they are enabled by the instruction before 'sleep', and an interrupt is only taken after 'sleep' has executed, so one arriving after the check still wakes the CPU instead of being missed.
+    void sleep(SleepDepth depth) {
+#ifdef ARDUINO
+        set_sleep_mode(depth == SLEEP_POWER_DOWN ? SLEEP_MODE_PWR_DOWN : SLEEP_MODE_IDLE);
+        sleep_enable();
+        if (depth == SLEEP_POWER_DOWN) {
+            sleep_bod_disable(); // the brown-out detector draws ~20 uA and is not needed asleep; must come right before sleeping
+        }
+        unsigned long start = micros();
+        interrupts();
+        sleep_cpu();
+        sleep_disable();
+        if (depth == SLEEP_IDLE) {
+            asleepUs += micros() - start;
+        }
+#else
+        interrupts(); // the host has nothing to sleep on
+#endif
+        if (depth == SLEEP_POWER_DOWN) {
+            powerDowns++;
+        } else {
+            idleSleeps++;
+        }
+    };
+
+    // Records how long after its first pin change ('wakeUs') and after the debouncer accepted it ('captureUs') the key's edge was captured.
+    void wake_latency(unsigned long wakeUs, unsigned long captureUs) {
+        record(wakeUs, wakeLastUs, wakeWorstUs);
+        record(captureUs, captureLastUs, captureWorstUs);
+    };
+
+    // Prints the sleep counts, the share of time asleep and the wake latency over serial.
+    void report() {
+        uint32_t elapsed = micros() - sinceUs;
+        Serial.print(F("# sleeps "));
+        Serial.print(idleSleeps);
+        Serial.print(F(" idle ("));
+        Serial.print(elapsed ? 1e6 * idleSleeps / elapsed : 0.);
+        Serial.print(F("/s), "));
+        Serial.print(powerDowns);
+        Serial.println(F(" power down"));
+        Serial.print(F("# asleep "));
+        Serial.print(elapsed ? 100. * asleepUs / elapsed : 0.);
+        Serial.print(F("% of "));
+        Serial.print(elapsed / 1000);
+        Serial.println(F(" ms awake or idle"));
+        Serial.print(F("# wake latency last "));
+        Serial.print((unsigned int)wakeLastUs);
+        Serial.print(F(" worst "));
+        Serial.print((unsigned int)wakeWorstUs);
+        Serial.print(F(" us, after debouncing last "));
+        Serial.print((unsigned int)captureLastUs);
+        Serial.print(F(" worst "));
+        Serial.print((unsigned int)captureWorstUs);
+        Serial.println(F(" us"));
+    };
+
+    // Clears the counters.
+    void reset_stats() {
+        idleSleeps = powerDowns = 0;
+        asleepUs = 0;
+        sinceUs = micros();
+        wakeLastUs = wakeWorstUs = 0;
+        captureLastUs = captureWorstUs = 0;
+    };
+
+    private:
+
+    // Stores a latency in 'last' (saturating at 0xFFFF us) and in 'worst' if it is the longest yet.
+    static void record(unsigned long us, uint16_t& last, uint16_t& worst) {
+        last = us > 0xFFFF ? 0xFFFF : (uint16_t)us;
+        if (last > worst) {
+            worst = last;
+        }
+    };
+};
+
+#endif // POWER_H
\ No newline at end of file
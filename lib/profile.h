@@ -0,0 +1,195 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/*
+Hot-path profiling probes based on Timer1 cycle counts.
+
+Enabled by adding '-D MORSE_PROFILE' to 'build_flags' in platformio.ini. When the flag is not set,
+every macro below expands to nothing so the probes cost no flash, RAM or cycles.
+
+ * PROFILE_SCOPE(probe) times the rest of the enclosing block and accumulates it into the probe's slot.
+ * PROFILE_BEGIN() sets up Timer1 as a free-running cycle counter (call once from setup()).
+ * PROFILE_DUMP() prints min/max/mean and the log2 histogram of every probe over serial.
+ * PROFILE_RESET() clears the table.
+
+Timer1 runs with no prescaler (1 tick = 1 CPU cycle = 62.5 ns at 16 MHz) and is extended to 32 bits
+by counting overflows, so a single probe can measure up to ~268 s. Timer1 normally drives PWM on pins
+9 and 10; those pins are only used with digitalWrite() for the RGB light, so taking the timer over is safe.
+*/
+
+#include "platform.h"
+
+// Identifiers of every profiled section. Add new probes before PROBE_COUNT and give them a name below.
+enum ProfileProbe : uint8_t {
+    PROBE_CHECK_PRESS, // Button::check_press
+    PROBE_CHECK_INPUT, // check_input() in main.cpp
+    PROBE_GET_LETTER, // MorseCode::get_letter
+    PROBE_UPDATE_DISPLAY, // Display::flush
+    PROBE_COUNT, // number of probes (not a probe)
+    PROBE_NONE = 0xFF // marker for "no section profiled yet"
+};
+
+#ifdef MORSE_PROFILE
+
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+const uint8_t PROFILE_HISTOGRAM_BINS = 16; // number of log2 buckets kept per probe
+const uint8_t PROFILE_HISTOGRAM_SHIFT = 6; // bucket 0 holds everything below 2^6 = 64 cycles (4 us)
+
+// Names of the probes, stored in flash. Order must match 'ProfileProbe'.
+const char probeName0[] PROGMEM = "check_press";
+const char probeName1[] PROGMEM = "check_input";
+const char probeName2[] PROGMEM = "get_letter";
+const char probeName3[] PROGMEM = "update_display";
+const char* const probeNames[PROBE_COUNT] PROGMEM = { probeName0, probeName1, probeName2, probeName3 };
+
+volatile uint16_t profileTimerOverflows = 0; // upper 16 bits of the extended Timer1 count
+
+ISR(TIMER1_OVF_vect) { // Extends Timer1 to 32 bits.
+    profileTimerOverflows++;
+}
+
+class Profiler { // Accumulates timing statistics for each profiled section of code.
+    public: // Allows all objects in class to be used by other project files.
+
+    struct ProbeStats { // Statistics collected for a single probe.
+        uint32_t count; // number of times the section ran
+        uint32_t minCycles; // fastest run in cycles
+        uint32_t maxCycles; // slowest run in cycles
+        uint32_t totalCycles; // sum of all runs (wraps after ~268 s of accumulated time; reset before long runs)
+        uint16_t histogram[PROFILE_HISTOGRAM_BINS]; // log2 buckets of the run time, saturating
+    };
+
+    ProbeStats probes[PROBE_COUNT]; // statistics table, one slot per probe
+    uint8_t lastProbe = PROBE_NONE; // most recently entered probe, used to name the section behind a loop stall
+
+    // Configures Timer1 as a free-running cycle counter with overflow interrupt.
+    void begin() {
+        uint8_t oldSREG = SREG; // saves interrupt state
+        cli();
+        TCCR1A = 0; // normal mode, no output compare pins
+        TCCR1B = _BV(CS10); // no prescaler: one tick per CPU cycle
+        TCNT1 = 0;
+        TIFR1 = _BV(TOV1); // clears any pending overflow
+        TIMSK1 = _BV(TOIE1); // enables the overflow interrupt
+        profileTimerOverflows = 0;
+        SREG = oldSREG; // restores interrupt state
+        reset();
+    };
+
+    // Returns the current 32-bit cycle count.
+    static uint32_t cycles() {
+        uint8_t oldSREG = SREG; // saves interrupt state
+        cli();
+        uint16_t low = TCNT1; // lower 16 bits straight from the timer
+        uint16_t high = profileTimerOverflows; // upper 16 bits counted by the overflow ISR
+        if ((TIFR1 & _BV(TOV1)) && low < 0x8000) { // an overflow happened but its ISR has not run yet
+            high++;
+        }
+        SREG = oldSREG; // restores interrupt state
+        return ((uint32_t)high << 16) | low;
+    };
+
+    // Clears every probe's statistics.
+    void reset() {
+        memset(probes, 0, sizeof(probes));
+        for (uint8_t i = 0; i < PROBE_COUNT; i++) {
+            probes[i].minCycles = 0xFFFFFFFF; // so the first run always becomes the minimum
+        }
+    };
+
+    // Adds a single measured run of a probe to the table.
+    void record(uint8_t probe, uint32_t elapsed) {
+        ProbeStats& stats = probes[probe];
+        stats.count++;
+        stats.totalCycles += elapsed;
+        if (elapsed < stats.minCycles) stats.minCycles = elapsed;
+        if (elapsed > stats.maxCycles) stats.maxCycles = elapsed;
+
+        uint8_t bin = bucket(elapsed);
+        if (stats.histogram[bin] != 0xFFFF) { // saturates instead of wrapping
+            stats.histogram[bin]++;
+        }
+    };
+
+    // Returns the log2 histogram bucket for a run time in cycles.
+    static uint8_t bucket(uint32_t elapsed) {
+        uint8_t log2 = 0; // floor(log2(elapsed))
+        while (elapsed >>= 1) log2++;
+        if (log2 < PROFILE_HISTOGRAM_SHIFT) return 0;
+        log2 -= PROFILE_HISTOGRAM_SHIFT;
+        return log2 < PROFILE_HISTOGRAM_BINS ? log2 : PROFILE_HISTOGRAM_BINS - 1;
+    };
+
+    // Prints the name of a probe from flash.
+    static void print_name(uint8_t probe) {
+        if (probe >= PROBE_COUNT) {
+            Serial.print(F("n/a"));
+            return;
+        }
+        Serial.print((const __FlashStringHelper*)pgm_read_word(&probeNames[probe]));
+    };
+
+    // Prints the statistics table over serial: one line per probe followed by its histogram.
+    void dump() {
+        Serial.println(F("# probe count min max mean (cycles) | log2 histogram from 2^6"));
+        for (uint8_t i = 0; i < PROBE_COUNT; i++) {
+            ProbeStats snapshot;
+            uint8_t oldSREG = SREG; // copies the slot atomically so a probe firing from an ISR cannot tear it
+            cli();
+            snapshot = probes[i];
+            SREG = oldSREG;
+
+            print_name(i);
+            Serial.print(' ');
+            Serial.print(snapshot.count);
+            Serial.print(' ');
+            Serial.print(snapshot.count ? snapshot.minCycles : 0);
+            Serial.print(' ');
+            Serial.print(snapshot.maxCycles);
+            Serial.print(' ');
+            Serial.print(snapshot.count ? snapshot.totalCycles / snapshot.count : 0);
+            Serial.print(F(" |"));
+            for (uint8_t bin = 0; bin < PROFILE_HISTOGRAM_BINS; bin++) {
+                Serial.print(' ');
+                Serial.print(snapshot.histogram[bin]);
+            }
+            Serial.println();
+        }
+    };
+} profiler;
+
+class ProfileScope { // Times its own lifetime and records it into the profiler when it goes out of scope.
+    private:
+    uint8_t probe; // probe that owns this measurement
+    uint32_t start; // cycle count when the scope was entered
+
+    public:
+    ProfileScope(uint8_t probe) : probe(probe) {
+        profiler.lastProbe = probe;
+        start = Profiler::cycles();
+    };
+
+    ~ProfileScope() {
+        profiler.record(probe, Profiler::cycles() - start);
+    };
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(probe) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(probe)
+#define PROFILE_BEGIN() profiler.begin()
+#define PROFILE_DUMP() profiler.dump()
+#define PROFILE_RESET() profiler.reset()
+
+#else // MORSE_PROFILE
+
+#define PROFILE_SCOPE(probe)
+#define PROFILE_BEGIN()
+#define PROFILE_DUMP()
+#define PROFILE_RESET()
+
+#endif // MORSE_PROFILE
+
+#endif // PROFILE_H
\ No newline at end of file
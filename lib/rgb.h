@@ -1,21 +1,32 @@
 #ifndef RGB_H
 #define RGB_H
 
-class Light {
+#include "platform.h"
+#include "hal.h"
+
+template <typename Red, typename Green, typename Blue>
+class Light { // RGB light on three pins (pin policies from hal.h), one per lead.
     public: // Allows for objects in class to be used by other project files.
 
+    // Makes the three pins outputs.
+    void begin() {
+        Red::output();
+        Green::output();
+        Blue::output();
+    };
+
     // Turns off the RGB light indicator.
     void off() {
-        digitalWrite(pin.r, LOW);
-        digitalWrite(pin.g, LOW);
-        digitalWrite(pin.b, LOW);
+        Red::low();
+        Green::low();
+        Blue::low();
     };
 
     // Sets color of light indicator.
     void color(uint8_t R, uint8_t G, uint8_t B) {
-        digitalWrite(pin.r, R);
-        digitalWrite(pin.g, G);
-        digitalWrite(pin.b, B);
+        Red::write(R == HIGH);
+        Green::write(G == HIGH);
+        Blue::write(B == HIGH);
     };
 };
 
@@ -0,0 +1,182 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+/*
+Cooperative run-to-completion scheduler for the main loop.
+
+Tasks live in a fixed table (no allocation) and are identified by their slot, which is also their
+priority: slot 0 goes first. A task becomes ready when
+ * something posts it: 'post' from the main loop, 'post_from_isr' from an interrupt (e.g. the key's
+   pin change), or
+ * its deadline passes: 'post_at' arms a one-shot timer in millis() time.
+Every call to 'run_once' starts the highest priority ready task and lets it run to the end; nothing
+preempts a task but interrupts. How long each run takes is measured with micros(), and the longest
+run of every task (its measured worst-case execution time) bounds how late any other task can start:
+a ready task waits at most for the longest task that was already running.
+
+SCHEDULER_BUDGET_US is the recorded budget for that: no task may run longer. Debounced key edges are
+timed in the tick interrupt and wait in its queue, so a late key capture costs latency, not timing
+accuracy; within 4 ms (one debounce of DEBOUNCE_SAMPLES ticks) at most one more edge can queue up
+behind the one being waited for. The 's' report marks tasks whose worst run is over the budget, and
+simavr_bench measures every task's runs in cycles on the simulated Uno.
+*/
+
+#include "platform.h"
+
+#ifndef SCHEDULER_BUDGET_US
+#define SCHEDULER_BUDGET_US 4000 // longest a task may run (us): how late a ready task may start
+#endif
+
+const uint8_t SCHEDULER_MAX_TASKS = 8; // slots in the task table (one bit each in the ready mask)
+
+class Scheduler { // Runs statically registered tasks when they are posted or their deadline passes.
+    public: // Allows all objects in class to be used by other project files.
+
+    typedef void (*TaskFunction)(); // a task: does its work and returns
+
+    struct Task { // One slot of the task table.
+        TaskFunction run; // what the task does, NULL for an empty slot
+        const char* name; // name for the report, in flash
+        unsigned long deadline; // millis() at which the task becomes ready (if armed)
+        uint32_t runs; // times the task ran
+        uint16_t lastUs; // length of the most recent run (us, saturating)
+        uint16_t worstUs; // longest run seen (us, saturating): the task's measured WCET
+    };
+
+    Task tasks[SCHEDULER_MAX_TASKS] = {}; // task table, indexed by slot
+
+    // Puts 'run' into slot 'slot'; 'name' must be stored in flash (PSTR).
+    void add(uint8_t slot, TaskFunction run, const char* name) {
+        tasks[slot].run = run;
+        tasks[slot].name = name;
+    };
+
+    // Makes a task ready (from the main loop; see 'post_from_isr').
+    void post(uint8_t slot) {
+        noInterrupts(); // the ready mask is also written from ISRs
+        ready |= 1 << slot;
+        interrupts();
+    };
+
+    // Variant of 'post' for use inside an ISR, where interrupts are already disabled.
+    void post_from_isr(uint8_t slot) {
+        ready |= 1 << slot;
+    };
+
+    // Makes a task ready once millis() reaches 'time'. Replaces any deadline it already had.
+    void post_at(uint8_t slot, unsigned long time) {
+        tasks[slot].deadline = time;
+        armed |= 1 << slot;
+    };
+
+    // Makes a task ready 'delay' ms from now.
+    void post_in(uint8_t slot, unsigned long delay) {
+        post_at(slot, millis() + delay);
+    };
+
+    // Disarms the deadline of a task (a pending post still runs it).
+    void cancel(uint8_t slot) {
+        armed &= ~(1 << slot);
+    };
+
+    // Whether a deadline is armed for a task.
+    bool is_armed(uint8_t slot) {
+        return armed & (1 << slot);
+    };
+
+    // Runs the highest priority ready task, if any. Returns false if nothing was ready (the caller may idle).
+    bool run_once() {
+        unsigned long now = millis();
+        for (uint8_t slot = 0; slot < SCHEDULER_MAX_TASKS; slot++) { // expired deadlines become ready
+            if ((armed & (1 << slot)) && (long)(now - tasks[slot].deadline) >= 0) {
+                armed &= ~(1 << slot);
+                post(slot);
+            }
+        }
+        noInterrupts();
+        uint8_t waiting = ready;
+        uint8_t slot = 0;
+        while (slot < SCHEDULER_MAX_TASKS && !(waiting & (1 << slot))) {
+            slot++;
+        }
+        if (slot < SCHEDULER_MAX_TASKS) {
+            ready &= ~(1 << slot); // posts that arrive while it runs make it ready again
+        }
+        interrupts();
+        if (slot == SCHEDULER_MAX_TASKS || tasks[slot].run == NULL) {
+            return false;
+        }
+        Task& task = tasks[slot];
+        unsigned long start = micros();
+        task.run();
+        unsigned long took = micros() - start;
+        task.lastUs = took > 0xFFFF ? 0xFFFF : (uint16_t)took;
+        if (task.lastUs > task.worstUs) {
+            task.worstUs = task.lastUs;
+        }
+        task.runs++;
+        return true;
+    };
+
+    // Whether any task is ready to run now (posted, or its deadline has passed).
+    bool busy() {
+        return ready != 0 || (armed != 0 && (long)(millis() - next_deadline()) >= 0);
+    };
+
+    // Earliest armed deadline, or millis() + 0x7FFFFFFF if none is armed.
+    unsigned long next_deadline() {
+        unsigned long now = millis();
+        unsigned long earliest = now + 0x7FFFFFFF;
+        for (uint8_t slot = 0; slot < SCHEDULER_MAX_TASKS; slot++) {
+            if ((armed & (1 << slot)) && (long)(tasks[slot].deadline - earliest) < 0) {
+                earliest = tasks[slot].deadline;
+            }
+        }
+        return earliest;
+    };
+
+    // Prints runs, last and worst-case run time of every task over serial, marking those over the budget.
+    void report() {
+        Serial.print(F("# task runs last worst (us), ! over the budget of "));
+        Serial.println((uint32_t)SCHEDULER_BUDGET_US);
+        for (uint8_t slot = 0; slot < SCHEDULER_MAX_TASKS; slot++) {
+            if (tasks[slot].run == NULL) {
+                continue;
+            }
+            print_name(tasks[slot].name);
+            Serial.print(' ');
+            Serial.print(tasks[slot].runs);
+            Serial.print(' ');
+            Serial.print((unsigned int)tasks[slot].lastUs);
+            Serial.print(' ');
+            Serial.print((unsigned int)tasks[slot].worstUs);
+            if (tasks[slot].worstUs > SCHEDULER_BUDGET_US) {
+                Serial.print(F(" !"));
+            }
+            Serial.println();
+        }
+    };
+
+    // Clears the run counts and worst-case times.
+    void reset_stats() {
+        for (uint8_t slot = 0; slot < SCHEDULER_MAX_TASKS; slot++) {
+            tasks[slot].runs = 0;
+            tasks[slot].lastUs = 0;
+            tasks[slot].worstUs = 0;
+        }
+    };
+
+    private:
+    volatile uint8_t ready = 0; // one bit per posted task
+    uint8_t armed = 0; // one bit per task with a deadline
+
+    // Prints a name stored in flash.
+    static void print_name(const char* name) {
+        char c;
+        while ((c = pgm_read_byte(name++)) != '\0') {
+            Serial.print(c);
+        }
+    };
+};
+
+#endif // SCHEDULER_H
\ No newline at end of file
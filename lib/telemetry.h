@@ -0,0 +1,167 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/*
+Compact binary telemetry stream.
+
+Enabled by adding '-D MORSE_TELEMETRY' to 'build_flags' in platformio.ini. Replaces the per-event text
+printed by MorseCode (~40 bytes per decoded letter) with small framed binary events. Frames are only
+queued when the whole frame fits in the serial TX ring buffer (drained by the HardwareSerial UDRE
+interrupt); a frame that does not fit is dropped and counted instead of stalling the loop. The drop
+counter is sent as its own frame as soon as there is room again.
+
+Frame layout (little endian):
+  0xA5 | type | length | payload[length] | crc8(type, length, payload)
+
+Bytes outside a valid frame (e.g. diagnostic text dumps) are passed through as text by the host
+decoder, tools/telemetry_decode.py.
+*/
+
+#include "platform.h"
+
+const uint8_t TELEMETRY_SYNC = 0xA5; // first byte of every frame
+const uint8_t TELEMETRY_VERSION = 1; // sent in the boot frame; bump when frame layouts change
+
+enum TelemetryType : uint8_t { // Frame types. Payload layout is listed next to each type.
+    TELEMETRY_BOOT = 0x01, // u8 protocol version
+    TELEMETRY_EDGE = 0x02, // u8 level (1 = pressed), u32 time (ms)
+    TELEMETRY_CLASSIFY = 0x03, // u8 symbol ('0' short / '1' long), u16 press duration (ms)
+    TELEMETRY_PATTERN = 0x04, // u8 symbol, u8 accepted
+    TELEMETRY_DURATION = 0x05, // u16 duration (ms), u8 accepted
+    TELEMETRY_LETTER = 0x06, // u8 letter ('?' if unknown), u8 pattern length, u8 pattern bits (bit i set = element i long)
+    TELEMETRY_STATS = 0x07, // u16 avg press, u16 std press, u16 avg release, u16 std release (ms)
+    TELEMETRY_DROPS = 0x08 // u16 frames dropped since boot
+};
+
+#ifdef MORSE_TELEMETRY
+
+const uint8_t TELEMETRY_MAX_PAYLOAD = 8; // largest payload of any frame type
+
+class Telemetry { // Builds telemetry frames and queues them on the serial port without blocking.
+    public: // Allows all objects in class to be used by other project files.
+
+    uint16_t dropped = 0; // frames dropped since boot because the TX buffer was full
+    bool dropsPending = false; // 'dropped' changed and has not been reported yet
+
+    // Updates a CRC-8 (polynomial 0x07) with one byte.
+    static uint8_t crc8(uint8_t crc, uint8_t data) {
+        crc ^= data;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+        return crc;
+    };
+
+    // Queues one frame if it fits in the TX buffer, otherwise counts it as dropped. Never blocks.
+    bool send(uint8_t type, const uint8_t* payload, uint8_t length) {
+        if (dropsPending && Serial.availableForWrite() >= 2 * (TELEMETRY_MAX_PAYLOAD + 4)) { // room for the drop report and this frame
+            dropsPending = false;
+            uint8_t counter[2] = { (uint8_t)dropped, (uint8_t)(dropped >> 8) };
+            write_frame(TELEMETRY_DROPS, counter, sizeof(counter));
+        }
+        if (Serial.availableForWrite() < length + 4) { // sync + type + length + crc
+            dropped++;
+            dropsPending = true;
+            return false;
+        }
+        write_frame(type, payload, length);
+        return true;
+    };
+
+    // Announces a (re)start of the firmware and the protocol version.
+    void boot() {
+        uint8_t payload[1] = { TELEMETRY_VERSION };
+        send(TELEMETRY_BOOT, payload, sizeof(payload));
+    };
+
+    // Sends a key press/release edge with its millis() timestamp.
+    void edge(bool pressed, uint32_t time) {
+        uint8_t payload[5] = { pressed, (uint8_t)time, (uint8_t)(time >> 8), (uint8_t)(time >> 16), (uint8_t)(time >> 24) };
+        send(TELEMETRY_EDGE, payload, sizeof(payload));
+    };
+
+    // Sends the short/long decision made for a press.
+    void classify(char symbol, uint16_t duration) {
+        uint8_t payload[3] = { (uint8_t)symbol, (uint8_t)duration, (uint8_t)(duration >> 8) };
+        send(TELEMETRY_CLASSIFY, payload, sizeof(payload));
+    };
+
+    // Sends a symbol being added to the current pattern.
+    void pattern(char symbol, bool accepted) {
+        uint8_t payload[2] = { (uint8_t)symbol, accepted };
+        send(TELEMETRY_PATTERN, payload, sizeof(payload));
+    };
+
+    // Sends a duration being added to the statistics arrays.
+    void duration(uint16_t value, bool accepted) {
+        uint8_t payload[3] = { (uint8_t)value, (uint8_t)(value >> 8), accepted };
+        send(TELEMETRY_DURATION, payload, sizeof(payload));
+    };
+
+    // Sends a decoded letter along with the pattern ("0"/"1" string) it was decoded from.
+    void letter(char letter, const char* pattern) {
+        uint8_t length = 0; // number of elements in the pattern
+        uint8_t bits = 0; // elements packed as bits, bit i set for a long press
+        while (pattern[length] != '\0' && length < 8) {
+            if (pattern[length] == '1') bits |= (1 << length);
+            length++;
+        }
+        uint8_t payload[3] = { (uint8_t)letter, length, bits };
+        send(TELEMETRY_LETTER, payload, sizeof(payload));
+    };
+
+    // Sends the running press/release statistics used for classification.
+    void stats(float avgPress, float stdPress, float avgRelease, float stdRelease) {
+        uint16_t values[4] = { clamp(avgPress), clamp(stdPress), clamp(avgRelease), clamp(stdRelease) };
+        uint8_t payload[8];
+        for (uint8_t i = 0; i < 4; i++) {
+            payload[2 * i] = (uint8_t)values[i];
+            payload[2 * i + 1] = (uint8_t)(values[i] >> 8);
+        }
+        send(TELEMETRY_STATS, payload, sizeof(payload));
+    };
+
+    private:
+
+    // Converts a duration in ms to a u16 field, saturating instead of wrapping.
+    static uint16_t clamp(float value) {
+        if (value <= 0) return 0;
+        if (value >= 65535.) return 65535;
+        return (uint16_t)value;
+    };
+
+    // Writes a complete frame. The caller has already checked that it fits in the TX buffer.
+    void write_frame(uint8_t type, const uint8_t* payload, uint8_t length) {
+        uint8_t crc = crc8(crc8(0, type), length);
+        Serial.write(TELEMETRY_SYNC);
+        Serial.write(type);
+        Serial.write(length);
+        for (uint8_t i = 0; i < length; i++) {
+            Serial.write(payload[i]);
+            crc = crc8(crc, payload[i]);
+        }
+        Serial.write(crc);
+    };
+} telemetry;
+
+#define TELEMETRY_BOOT() telemetry.boot()
+#define TELEMETRY_EDGE(pressed, time) telemetry.edge(pressed, time)
+#define TELEMETRY_CLASSIFY(symbol, duration) telemetry.classify(symbol, duration)
+#define TELEMETRY_PATTERN(symbol, accepted) telemetry.pattern(symbol, accepted)
+#define TELEMETRY_DURATION(value, accepted) telemetry.duration(value, accepted)
+#define TELEMETRY_LETTER(decoded, elements) telemetry.letter(decoded, elements)
+#define TELEMETRY_STATS(avgPress, stdPress, avgRelease, stdRelease) telemetry.stats(avgPress, stdPress, avgRelease, stdRelease)
+
+#else // MORSE_TELEMETRY
+
+#define TELEMETRY_BOOT()
+#define TELEMETRY_EDGE(pressed, time)
+#define TELEMETRY_CLASSIFY(symbol, duration)
+#define TELEMETRY_PATTERN(symbol, accepted)
+#define TELEMETRY_DURATION(value, accepted)
+#define TELEMETRY_LETTER(decoded, elements)
+#define TELEMETRY_STATS(avgPress, stdPress, avgRelease, stdRelease)
+
+#endif // MORSE_TELEMETRY
+
+#endif // TELEMETRY_H
\ No newline at end of file
@@ -0,0 +1,179 @@
+#ifndef TIMING_STORE_H
+#define TIMING_STORE_H
+
+/*
+Keeps the learned keying rhythm (the classifier's windows of recent press and release durations) in
+EEPROM, so after a power cycle the classifier starts from the last session's rhythm instead of from
+nothing. The windows are saved as they are: averages and standard deviations alone do not tell the
+dits from the dahs or the element gaps from the letter gaps, which is what the classifier goes by.
+
+ * Wear-leveling: records go round-robin into TIMING_STORE_SLOTS slots, each with a sequence number;
+   at boot the valid record with the highest sequence number wins. Every slot sees 1/16 of the writes,
+   so the 100,000 cycles an EEPROM cell is rated for give 1.6 million saves: three years of non-stop
+   keying at the most one save per TIMING_STORE_INTERVAL_MS allows.
+ * Integrity: a CRC-16 (CCITT) over the record is written last. A record whose write was cut short by
+   a power loss fails its CRC and the previous one is used.
+ * Saving only on drift: 'offer' starts a save only when the average or standard deviation of the
+   presses or of the releases has moved by more than TIMING_STORE_DRIFT of its average since the last
+   save, and at most once every TIMING_STORE_INTERVAL_MS.
+ * No blocking: an EEPROM byte takes 3.4 ms to program, so 'write_step' writes one byte at a time and
+   only when the previous one is done; the caller runs it again until it returns false.
+*/
+
+#include "platform.h"
+#include "calculate.h"
+#include "classifier.h"
+
+#ifndef TIMING_STORE_DRIFT
+#define TIMING_STORE_DRIFT 0.15 // relative change of the statistics that is worth a save
+#endif
+#ifndef TIMING_STORE_INTERVAL_MS
+#define TIMING_STORE_INTERVAL_MS 60000 // shortest time between two saves (ms)
+#endif
+
+const uint8_t TIMING_STORE_SLOTS = 16; // records the writes are spread over
+const uint16_t TIMING_STORE_ADDRESS = 0; // first EEPROM byte used
+const uint8_t EEPROM_WRITE_MS = 4; // a byte takes 3.4 ms to program
+
+struct TimingSnapshot { // The durations that are saved (ms, oldest first, 0 where a window was not full).
+    int16_t presses[CLASSIFIER_WINDOW];
+    int16_t releases[CLASSIFIER_WINDOW];
+
+    // The current windows of a classifier.
+    static TimingSnapshot of(Classifier& classifier) {
+        TimingSnapshot timing;
+        classifier.copy_windows(timing.presses, timing.releases);
+        return timing;
+    };
+};
+
+class TimingStore { // Saves and restores the learned timing in wear-leveled, CRC-checked EEPROM records.
+    public: // Allows all objects in class to be used by other project files.
+
+    struct Record { // One slot in EEPROM; 'crc' comes last so it is written last.
+        TimingSnapshot timing;
+        uint16_t sequence; // higher is newer (compared with wrap-around)
+        uint16_t crc; // CRC-16 of everything before it
+    };
+
+    uint16_t saves = 0; // records written since boot
+
+    // Reads the newest valid record into 'timing'. Returns false if there is none (new board, or nothing saved yet). Call once at boot, before 'offer'.
+    bool load(TimingSnapshot& timing) {
+        bool found = false;
+        for (uint8_t i = 0; i < TIMING_STORE_SLOTS; i++) {
+            Record record;
+            read(i, record);
+            if (record.crc != crc16((const uint8_t*)&record, sizeof(record) - sizeof(record.crc))) {
+                continue; // never written, or cut short
+            }
+            if (!found || (int16_t)(record.sequence - pending.sequence) > 0) {
+                pending = record;
+                slot = i;
+                found = true;
+            }
+        }
+        if (found) {
+            timing = saved = pending.timing;
+            slot = (slot + 1) % TIMING_STORE_SLOTS; // the next save goes after the newest record
+        }
+        hasSaved = found;
+        return found;
+    };
+
+    // Starts saving 'timing' if it drifted far enough from what was saved last and the last save was long enough ago ('now' in ms). Returns true if a save was started; run 'write_step' until it returns false.
+    bool offer(const TimingSnapshot& timing, unsigned long now) {
+        if (busy() || (hasSaved && (now - savedAt < TIMING_STORE_INTERVAL_MS || !drifted(timing, saved)))) {
+            return false;
+        }
+        pending.timing = timing;
+        pending.sequence++;
+        pending.crc = crc16((const uint8_t*)&pending, sizeof(pending) - sizeof(pending.crc));
+        written = 0;
+        saved = timing;
+        savedAt = now;
+        hasSaved = true;
+        return true;
+    };
+
+    // Writes the next byte of a save in progress if the EEPROM is ready for it. Returns true while bytes remain.
+    bool write_step() {
+        if (!busy()) {
+            return false;
+        }
+        if (!eeprom_is_ready()) { // the previous byte is still being programmed
+            return true;
+        }
+        eeprom_update_byte(address(slot) + written, ((const uint8_t*)&pending)[written]); // unchanged bytes are not reprogrammed
+        written++;
+        if (!busy()) {
+            slot = (slot + 1) % TIMING_STORE_SLOTS;
+            saves++;
+        }
+        return busy();
+    };
+
+    // Whether a save is in progress.
+    bool busy() {
+        return written < sizeof(Record);
+    };
+
+    private:
+    Record pending = {}; // newest record: the one loaded, or the one being written
+    uint8_t written = sizeof(Record); // bytes of 'pending' written so far (all of them when idle)
+    uint8_t slot = 0; // slot the next save goes to
+    TimingSnapshot saved = {}; // durations of the last save (or load), for the drift check
+    unsigned long savedAt = 0; // millis() of the last save
+    bool hasSaved = false; // 'saved' is valid
+
+    // Whether the average or standard deviation of the presses or of the releases differs from the saved one by more than TIMING_STORE_DRIFT of its average.
+    static bool drifted(const TimingSnapshot& timing, const TimingSnapshot& saved) {
+        return drifted(timing.presses, saved.presses) || drifted(timing.releases, saved.releases);
+    };
+
+    // ... of one window.
+    static bool drifted(const int16_t* durations, const int16_t* savedDurations) {
+        Calculate calculate;
+        uint8_t count = used(durations), savedCount = used(savedDurations);
+        float avg = calculate.averageArray(durations, count), savedAvg = calculate.averageArray(savedDurations, savedCount);
+        float std = calculate.stdArray(durations, count, avg), savedStd = calculate.stdArray(savedDurations, savedCount, savedAvg);
+        float limit = TIMING_STORE_DRIFT * savedAvg;
+        return fabs(avg - savedAvg) > limit || fabs(std - savedStd) > limit;
+    };
+
+    // Durations before the first 0 in a saved window.
+    static uint8_t used(const int16_t* durations) {
+        uint8_t count = 0;
+        while (count < CLASSIFIER_WINDOW && durations[count] > 0) {
+            count++;
+        }
+        return count;
+    };
+
+    static uint8_t* address(uint8_t slot) {
+        return (uint8_t*)(TIMING_STORE_ADDRESS + slot * sizeof(Record));
+    };
+
+    static void read(uint8_t slot, Record& record) {
+        for (uint8_t i = 0; i < sizeof(Record); i++) {
+            ((uint8_t*)&record)[i] = eeprom_read_byte(address(slot) + i);
+        }
+    };
+
+    // CRC-16/CCITT (polynomial 0x1021, start 0xFFFF) of 'length' bytes.
+    static uint16_t crc16(const uint8_t* data, uint8_t length) {
+        uint16_t crc = 0xFFFF;
+        while (length--) {
+            crc ^= (uint16_t)*data++ << 8;
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+            }
+        }
+        return crc;
+    };
+};
+
+static_assert(sizeof(TimingStore::Record) < 256, "write_step counts the bytes of a record in a uint8_t");
+static_assert(TIMING_STORE_ADDRESS + TIMING_STORE_SLOTS * sizeof(TimingStore::Record) <= E2END + 1, "the timing records do not fit in the EEPROM");
+
+#endif // TIMING_STORE_H
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef TUNING_H
+#define TUNING_H
+
+/*
+Decoder constants, generated by the tuning sweep over a trace corpus (src/host/tune.cpp).
+Corpus:
+    pio run -e keygen && .pio/build/keygen/program tuning.ktr --sessions 300 --wpm 8-40 --jitter 0-0.2 --seed 1
+    .pio/build/keygen/program tuning_clean.ktr --sessions 100 --wpm 8-40 --jitter 0-0 --seed 2
+Sweep:
+    pio run -e tune && .pio/build/tune/program tuning.ktr --clean tuning_clean.ktr --holdout 4 --out lib/tuning.h
+Tuned on 225 sessions, 19155 characters: CER 0.23% (previous constants: 11.51%).
+Held out 75 sessions, 6359 characters: CER 0.20% (previous constants: 11.31%).
+Clean keying, 100 sessions, 8598 characters: CER 0.00% (previous constants: 10.51%).
+*/
+
+constexpr float TUNED_THRESHOLD_MULTIPLIER = 0.00f; // standard deviations above the average press that still count as short, once dits and dahs were seen
+constexpr int TUNED_SHORT_PRESS_CAP = 73; // ms, presses shorter than this are always short
+constexpr int TUNED_LONG_PRESS_CAP = 288; // ms, letter gap threshold before any press has been seen
+constexpr float TUNED_WORD_GAP_MULTIPLIER = 2.50f; // word gap threshold relative to the letter gap threshold
+
+#endif // TUNING_H
\ No newline at end of file
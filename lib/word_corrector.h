@@ -0,0 +1,224 @@
+#ifndef WORD_CORRECTOR_H
+#define WORD_CORRECTOR_H
+
+#include "platform.h"
+#include "morse_code.h"
+
+/*
+Proposes a dictionary word for a word that came out with an invalid pattern ('?') or that is not in
+the word list, using what was actually keyed: the press pattern of every letter. A candidate word
+costs
+    1 per press that has to be flipped, added or dropped to turn a keyed pattern into its letter
+    1 for two keyed patterns that together are one letter (a letter gap that was too long), or one
+      keyed pattern that is two letters (a letter gap too short to be seen)
+    3 per whole letter missing or extra
+The search walks the word list (a DAWG, see tools/build_word_list.py) with one row of an edit-distance
+table per letter and drops every branch that can no longer stay within the bound, so only a small part
+of the list is visited.
+*/
+
+const int MAX_WORD_LETTERS = 10; // longer words are left as they are
+const uint8_t CORRECTION_COST_INVALID = 2; // largest cost accepted for a word with an invalid pattern
+const uint8_t CORRECTION_COST_VALID = 1; // largest cost accepted for a word of valid letters that is not in the list
+const uint8_t LETTER_EDIT_COST = 3; // a whole letter missing or extra
+const uint8_t GAP_EDIT_COST = 1; // letters split or merged by a misjudged letter gap
+
+class WordCorrector { // Collects the letters of a word and, at the word gap, looks for the closest word in a flash word list.
+    private:
+    const uint8_t* words; // DAWG edges in flash
+    uint8_t patterns[MAX_WORD_LETTERS]; // keyed pattern of every letter, packed by pack_pattern
+    char letters[MAX_WORD_LETTERS + 1] = ""; // letters as decoded, '?' for invalid patterns
+    uint8_t count = 0; // letters collected
+    bool tooLong = false; // the word has more than MAX_WORD_LETTERS letters
+
+    public: // Allows all objects in class to be used by other project files.
+    unsigned int visited = 0; // word list edges looked at by the last 'correct' (to check the time it takes)
+
+    WordCorrector(const uint8_t* wordList) : words(wordList) {};
+
+    // Adds a decoded letter ('?' if the pattern matched none) with its packed pattern.
+    void add_letter(char letter, uint8_t pattern) {
+        if (count == MAX_WORD_LETTERS) {
+            tooLong = true;
+            return;
+        }
+        patterns[count] = pattern;
+        letters[count++] = letter;
+        letters[count] = '\0';
+    };
+
+    // Letters collected since the last reset, as decoded.
+    const char* word() {
+        return letters;
+    };
+
+    // Letters of the current word that were valid (the ones shown on the lcd).
+    int shown() {
+        int valid = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            valid += letters[i] != '?';
+        }
+        return valid;
+    };
+
+    // Forgets the current word.
+    void reset() {
+        count = 0;
+        letters[0] = '\0';
+        tooLong = false;
+    };
+
+    // Looks for a better word. Returns true and writes it to 'out' (MAX_WORD_LETTERS + 3 bytes) if one was found that differs from what was decoded.
+    bool correct(char* out) {
+        visited = 0;
+        if (count == 0 || tooLong) {
+            return false;
+        }
+        bool invalid = strchr(letters, '?') != NULL;
+        uint8_t bound = invalid ? CORRECTION_COST_INVALID : CORRECTION_COST_VALID;
+        const int depthLimit = MAX_WORD_LETTERS + 2; // each letter beyond the keyed ones costs at least GAP_EDIT_COST
+        uint8_t rows[depthLimit + 1][MAX_WORD_LETTERS + 1]; // rows[d][j]: cheapest way to turn the first j keyed patterns into the first d letters of the path
+        uint16_t edgeAt[depthLimit + 1]; // edge taken at every depth of the path
+        uint8_t letterAt[depthLimit + 1]; // packed letter pattern at every depth
+        uint8_t lowestAt[depthLimit + 1]; // smallest entry of every row
+        char path[depthLimit + 1];
+        uint8_t best = bound + 1;
+
+        for (int j = 0; j <= count; j++) {
+            rows[0][j] = j * LETTER_EDIT_COST;
+        }
+        lowestAt[0] = 0;
+        int depth = 1;
+        edgeAt[1] = 0;
+        while (depth > 0) {
+            uint16_t edge = edgeAt[depth];
+            uint8_t flags = pgm_read_byte(&words[edge * 3]);
+            uint16_t child = pgm_read_byte(&words[edge * 3 + 1]) | (uint16_t)pgm_read_byte(&words[edge * 3 + 2]) << 8;
+            visited++;
+            path[depth - 1] = 'A' + (flags & 0x1F);
+            letterAt[depth] = packed_letter(flags & 0x1F);
+            uint8_t lowest = lowestAt[depth] = fill_row(rows, letterAt, depth);
+            if ((flags & 0x20) && rows[depth][count] < best) { // a word ends here and is the closest so far
+                best = rows[depth][count];
+                memcpy(out, path, depth);
+                out[depth] = '\0';
+            }
+            bool reachable = lowest <= bound || lowestAt[depth - 1] + GAP_EDIT_COST <= bound; // the next letter may also come from the row above, with this one as the second half of a keyed pattern
+            if (child != 0 && reachable && depth < depthLimit) { // the branch can still stay within the bound
+                edgeAt[++depth] = child;
+                continue;
+            }
+            while (depth > 0) { // next sibling, or back up until there is one
+                if (!(pgm_read_byte(&words[edgeAt[depth] * 3]) & 0x40)) {
+                    edgeAt[depth]++;
+                    break;
+                }
+                depth--;
+            }
+        }
+        return best <= bound && best > 0 && strcmp(out, letters) != 0;
+    };
+
+    private:
+
+    // Fills rows[depth] for the letter 'letterAt[depth]' and returns its smallest entry.
+    uint8_t fill_row(uint8_t rows[][MAX_WORD_LETTERS + 1], const uint8_t* letterAt, int depth) {
+        const uint8_t* above = rows[depth - 1];
+        uint8_t* row = rows[depth];
+        uint8_t letter = letterAt[depth];
+        row[0] = saturate(above[0] + LETTER_EDIT_COST);
+        uint8_t lowest = row[0];
+        for (int j = 1; j <= count; j++) {
+            uint8_t cost = saturate(above[j - 1] + pattern_distance(patterns[j - 1], letter)); // keyed letter j read as this letter
+            cost = min_cost(cost, above[j] + LETTER_EDIT_COST); // this letter was not keyed
+            cost = min_cost(cost, row[j - 1] + LETTER_EDIT_COST); // keyed letter j is extra
+            if (j >= 2 && concatenate(patterns[j - 2], patterns[j - 1]) == letter) { // two keyed letters were one
+                cost = min_cost(cost, above[j - 2] + GAP_EDIT_COST);
+            }
+            if (depth >= 2 && concatenate(letterAt[depth - 1], letter) == patterns[j - 1]) { // one keyed letter was two
+                cost = min_cost(cost, rows[depth - 2][j - 1] + GAP_EDIT_COST);
+            }
+            row[j] = cost;
+            if (cost < lowest) {
+                lowest = cost;
+            }
+        }
+        return lowest;
+    };
+
+    // Presses to flip, add or drop to turn packed pattern 'a' into 'b' (edit distance over at most 4 presses).
+    static uint8_t pattern_distance(uint8_t a, uint8_t b) {
+        if (a == b) {
+            return 0;
+        }
+        uint8_t lengthA = pattern_length(a), lengthB = pattern_length(b);
+        uint8_t previous[MAX_PATTERN_SLOTS + 3], current[MAX_PATTERN_SLOTS + 3];
+        for (uint8_t j = 0; j <= lengthB; j++) {
+            previous[j] = j;
+        }
+        for (uint8_t i = 1; i <= lengthA; i++) {
+            current[0] = i;
+            bool pressA = (a >> (lengthA - i)) & 1;
+            for (uint8_t j = 1; j <= lengthB; j++) {
+                bool pressB = (b >> (lengthB - j)) & 1;
+                uint8_t cost = previous[j - 1] + (pressA != pressB);
+                cost = min_cost(cost, previous[j] + 1);
+                current[j] = min_cost(cost, current[j - 1] + 1);
+            }
+            memcpy(previous, current, lengthB + 1);
+        }
+        return previous[lengthB];
+    };
+
+    // Number of presses in a packed pattern.
+    static uint8_t pattern_length(uint8_t packed) {
+        uint8_t length = 0;
+        while (packed > 1) {
+            packed >>= 1;
+            length++;
+        }
+        return length;
+    };
+
+    // Packed pattern of 'a' followed by 'b', or 0 if it would not fit a letter (more than 4 presses).
+    static uint8_t concatenate(uint8_t a, uint8_t b) {
+        uint8_t lengthB = pattern_length(b);
+        if (pattern_length(a) + lengthB > MAX_PATTERN_SLOTS - 1) {
+            return 0;
+        }
+        return (a << lengthB) | (b & ((1 << lengthB) - 1));
+    };
+
+    static uint8_t min_cost(uint8_t a, int b) {
+        uint8_t c = saturate(b);
+        return c < a ? c : a;
+    };
+
+    static uint8_t saturate(int value) {
+        return value > 255 ? 255 : (uint8_t)value;
+    };
+};
+
+#ifdef MORSE_WORD_CORRECTION
+
+#include "word_list.h"
+
+WordCorrector wordCorrector(wordList); // the word being keyed, checked against the word list at the word gap
+
+#define WORD_CORRECTION_LETTER(letter, pattern) wordCorrector.add_letter(letter, pattern)
+#define WORD_CORRECTION_END(display) do { \
+    char corrected[MAX_WORD_LETTERS + 3]; \
+    if (wordCorrector.correct(corrected)) (display).replace_word(wordCorrector.shown(), corrected); \
+    wordCorrector.reset(); \
+} while (0)
+#define WORD_CORRECTION_RESET() wordCorrector.reset()
+
+#else // MORSE_WORD_CORRECTION
+
+#define WORD_CORRECTION_LETTER(letter, pattern)
+#define WORD_CORRECTION_END(display)
+#define WORD_CORRECTION_RESET()
+
+#endif // MORSE_WORD_CORRECTION
+
+#endif // WORD_CORRECTOR_H
\ No newline at end of file
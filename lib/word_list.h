@@ -0,0 +1,87 @@
+#ifndef WORD_LIST_H
+#define WORD_LIST_H
+
+/*
+Word list of the word corrector (word_corrector.h) as a DAWG in flash, 361 words in 578 edges (1734 bytes).
+Generated from tools/words.txt by tools/build_word_list.py, which also describes the layout.
+*/
+
+#include "platform.h"
+
+const uint8_t wordList[] PROGMEM = {
+    0x00, 0x1A, 0x00, 0x01, 0x25, 0x00, 0x02, 0x2D, 0x00, 0x03, 0x36, 0x00, 0x04, 0x3C, 0x00, 0x05, 0x43, 0x00, 0x06, 0x49, 0x00, 0x07, 0x50, 0x00,
+    0x08, 0x57, 0x00, 0x09, 0x5D, 0x00, 0x0A, 0x5F, 0x00, 0x0B, 0x63, 0x00, 0x0C, 0x67, 0x00, 0x0D, 0x6D, 0x00, 0x0E, 0x73, 0x00, 0x0F, 0x7E, 0x00,
+    0x10, 0x86, 0x00, 0x11, 0x8A, 0x00, 0x12, 0x91, 0x00, 0x13, 0x9D, 0x00, 0x14, 0xA7, 0x00, 0x15, 0xAB, 0x00, 0x16, 0xAD, 0x00, 0x17, 0xB4, 0x00,
+    0x18, 0xB5, 0x00, 0x59, 0xB8, 0x00, 0x01, 0xB9, 0x00, 0x03, 0xBB, 0x00, 0x05, 0xBC, 0x00, 0x06, 0xBD, 0x00, 0x08, 0xBF, 0x00, 0x0B, 0xC0, 0x00,
+    0x0D, 0xC5, 0x00, 0x31, 0xCB, 0x00, 0x32, 0xCD, 0x00, 0x33, 0x00, 0x00, 0x56, 0xCE, 0x00, 0x00, 0xCF, 0x00, 0x24, 0xD0, 0x00, 0x08, 0xD7, 0x00,
+    0x2A, 0x00, 0x00, 0x0E, 0xD8, 0x00, 0x11, 0xDB, 0x00, 0x14, 0xDC, 0x00, 0x78, 0x00, 0x00, 0x00, 0xDE, 0x00, 0x05, 0xE2, 0x00, 0x07, 0xE3, 0x00,
+    0x08, 0xE4, 0x00, 0x0B, 0xE5, 0x00, 0x0E, 0xE6, 0x00, 0x0F, 0xE8, 0x00, 0x30, 0x00, 0x00, 0x54, 0xE9, 0x00, 0x00, 0xE8, 0x00, 0x24, 0x00, 0x00,
+    0x08, 0xEB, 0x00, 0x2E, 0xED, 0x00, 0x31, 0x00, 0x00, 0x77, 0x00, 0x00, 0x00, 0xF0, 0x00, 0x0D, 0xF3, 0x00, 0x0E, 0xF5, 0x00, 0x32, 0x00, 0x00,
+    0x15, 0xF6, 0x00, 0x17, 0xF7, 0x00, 0x58, 0xF8, 0x00, 0x00, 0xF9, 0x00, 0x21, 0x00, 0x00, 0x04, 0xFD, 0x00, 0x08, 0x00, 0x01, 0x0E, 0x02, 0x01,
+    0x51, 0x07, 0x01, 0x20, 0x00, 0x00, 0x24, 0x08, 0x01, 0x08, 0x09, 0x01, 0x2C, 0x00, 0x00, 0x2D, 0x00, 0x00, 0x2E, 0x0B, 0x01, 0x51, 0x0D, 0x01,
+    0x00, 0x0F, 0x01, 0x24, 0x14, 0x01, 0x08, 0x17, 0x01, 0x0E, 0x1A, 0x01, 0x0F, 0xF8, 0x00, 0x31, 0x00, 0x00, 0x76, 0x00, 0x00, 0x03, 0x1D, 0x01,
+    0x25, 0x00, 0x00, 0x0C, 0x1E, 0x01, 0x2D, 0x1F, 0x01, 0x32, 0x00, 0x00, 0x73, 0x00, 0x00, 0x00, 0x21, 0x01, 0x54, 0x22, 0x01, 0x00, 0x24, 0x01,
+    0x04, 0x25, 0x01, 0x08, 0x26, 0x01, 0x6D, 0x27, 0x01, 0x00, 0x28, 0x01, 0x04, 0x2D, 0x01, 0x08, 0x30, 0x01, 0x4E, 0x37, 0x01, 0x00, 0x39, 0x01,
+    0x24, 0x3D, 0x01, 0x08, 0x3F, 0x01, 0x0E, 0x42, 0x01, 0x14, 0x47, 0x01, 0x78, 0x00, 0x00, 0x00, 0x49, 0x01, 0x04, 0x4A, 0x01, 0x08, 0x4F, 0x01,
+    0x2E, 0x50, 0x01, 0x31, 0x00, 0x00, 0x54, 0x52, 0x01, 0x25, 0x53, 0x01, 0x08, 0x55, 0x01, 0x0B, 0xBB, 0x00, 0x2C, 0x00, 0x00, 0x2D, 0x56, 0x01,
+    0x2F, 0x59, 0x01, 0x31, 0x00, 0x00, 0x13, 0x5A, 0x01, 0x14, 0x5B, 0x01, 0x15, 0x5D, 0x01, 0x56, 0x5E, 0x01, 0x00, 0x5F, 0x01, 0x04, 0x62, 0x01,
+    0x08, 0x63, 0x01, 0x0B, 0x64, 0x01, 0x0E, 0x65, 0x01, 0x12, 0xF8, 0x00, 0x14, 0x08, 0x01, 0x56, 0xBF, 0x00, 0x11, 0x66, 0x01, 0x12, 0x6D, 0x01,
+    0x13, 0x70, 0x01, 0x54, 0x71, 0x01, 0x02, 0x72, 0x01, 0x04, 0x73, 0x01, 0x08, 0x74, 0x01, 0x0F, 0x08, 0x01, 0x12, 0x08, 0x01, 0x14, 0x5E, 0x01,
+    0x77, 0x00, 0x00, 0x00, 0x76, 0x01, 0x02, 0x7A, 0x01, 0x04, 0x7B, 0x01, 0x07, 0x80, 0x01, 0x08, 0x82, 0x01, 0x2A, 0x00, 0x00, 0x0C, 0x84, 0x01,
+    0x2E, 0x85, 0x01, 0x0F, 0x89, 0x01, 0x11, 0x8A, 0x01, 0x13, 0x8B, 0x01, 0x54, 0x8F, 0x01, 0x00, 0x90, 0x01, 0x04, 0x92, 0x01, 0x07, 0x94, 0x01,
+    0x08, 0x49, 0x01, 0x0D, 0x99, 0x01, 0x2E, 0x9A, 0x01, 0x11, 0x9C, 0x01, 0x34, 0x9E, 0x01, 0x16, 0x9F, 0x01, 0x77, 0x00, 0x00, 0x0D, 0xA0, 0x01,
+    0x2F, 0x00, 0x00, 0x31, 0x00, 0x00, 0x72, 0xF8, 0x00, 0x04, 0xA2, 0x01, 0x78, 0x00, 0x00, 0x00, 0xA4, 0x01, 0x24, 0xA9, 0x01, 0x07, 0xAC, 0x01,
+    0x08, 0xB1, 0x01, 0x0E, 0xB3, 0x01, 0x11, 0xB5, 0x01, 0x77, 0x00, 0x00, 0x58, 0x55, 0x01, 0x04, 0xB6, 0x01, 0x2B, 0x00, 0x00, 0x4E, 0xB7, 0x01,
+    0x44, 0xB8, 0x01, 0x0E, 0xB9, 0x01, 0x73, 0x00, 0x00, 0x63, 0x00, 0x00, 0x53, 0x5D, 0x01, 0x00, 0xBB, 0x01, 0x6D, 0x00, 0x00, 0x71, 0x00, 0x00,
+    0x2B, 0x00, 0x00, 0x0C, 0xBC, 0x01, 0x0E, 0xBD, 0x01, 0x12, 0x9F, 0x01, 0x56, 0xBE, 0x01, 0x23, 0x00, 0x00, 0x08, 0xBF, 0x01, 0x0E, 0xC0, 0x01,
+    0x12, 0xC1, 0x01, 0x33, 0x00, 0x00, 0x78, 0x00, 0x00, 0x24, 0x00, 0x00, 0x4E, 0xC2, 0x01, 0x6A, 0x00, 0x00, 0x40, 0xE8, 0x00, 0x42, 0xCD, 0x00,
+    0x02, 0xC3, 0x01, 0x04, 0x5E, 0x01, 0x05, 0xC4, 0x01, 0x06, 0xC5, 0x01, 0x08, 0xBD, 0x01, 0x0B, 0x27, 0x01, 0x53, 0xC7, 0x01, 0x66, 0x00, 0x00,
+    0x0E, 0xCD, 0x00, 0x13, 0x70, 0x01, 0x78, 0x00, 0x00, 0x4E, 0xC8, 0x01, 0x11, 0x9F, 0x01, 0x73, 0x00, 0x00, 0x0B, 0x55, 0x01, 0x0C, 0xF8, 0x00,
+    0x2D, 0x00, 0x00, 0x71, 0xC9, 0x01, 0x6C, 0x00, 0x00, 0x40, 0xCA, 0x01, 0x53, 0xE8, 0x00, 0x4E, 0xCB, 0x01, 0x0C, 0xF8, 0x00, 0x54, 0xCC, 0x01,
+    0x78, 0x00, 0x00, 0x2B, 0x00, 0x00, 0x73, 0x00, 0x00, 0x23, 0x00, 0x00, 0x45, 0xCE, 0x01, 0x04, 0xCF, 0x01, 0x26, 0x00, 0x00, 0x56, 0x5E, 0x01,
+    0x02, 0x70, 0x01, 0x11, 0xD0, 0x01, 0x73, 0x00, 0x00, 0x23, 0x00, 0x00, 0x4E, 0xD1, 0x01, 0x65, 0x00, 0x00, 0x44, 0xD2, 0x01, 0x40, 0xD4, 0x01,
+    0x64, 0x00, 0x00, 0x02, 0xF8, 0x00, 0x0C, 0xD5, 0x01, 0x31, 0x00, 0x00, 0x53, 0x5A, 0x01, 0x04, 0x08, 0x01, 0x31, 0x00, 0x00, 0x76, 0x00, 0x00,
+    0x0D, 0xBB, 0x00, 0x51, 0xD6, 0x01, 0x0B, 0xD7, 0x01, 0x0E, 0xBB, 0x00, 0x31, 0xE2, 0x00, 0x14, 0xD8, 0x01, 0x77, 0x00, 0x00, 0x4E, 0xE2, 0x00,
+    0x73, 0x00, 0x00, 0x11, 0x55, 0x01, 0x55, 0xF8, 0x00, 0x0E, 0xBB, 0x00, 0x73, 0x00, 0x00, 0x04, 0xDA, 0x01, 0x4E, 0xDB, 0x01, 0x23, 0x00, 0x00,
+    0x0D, 0xBB, 0x00, 0x11, 0xBB, 0x00, 0x32, 0x00, 0x00, 0x55, 0xF8, 0x00, 0x00, 0xDD, 0x01, 0x0B, 0xDF, 0x01, 0x71, 0xF8, 0x00, 0x06, 0x70, 0x01,
+    0x2C, 0x00, 0x00, 0x72, 0x00, 0x00, 0x0C, 0xF8, 0x00, 0x14, 0xCB, 0x01, 0x76, 0x00, 0x00, 0x44, 0xE0, 0x01, 0x4F, 0xE1, 0x01, 0x05, 0x9F, 0x01,
+    0x53, 0x9F, 0x01, 0x59, 0xE2, 0x01, 0x0C, 0xE3, 0x01, 0x52, 0x08, 0x01, 0x58, 0xE4, 0x01, 0x44, 0xDF, 0x01, 0x4D, 0xBB, 0x00, 0x4E, 0xE5, 0x01,
+    0x0D, 0xBB, 0x00, 0x11, 0xE6, 0x01, 0x12, 0x08, 0x01, 0x13, 0x5D, 0x01, 0x59, 0xE8, 0x00, 0x00, 0xE7, 0x01, 0x05, 0x08, 0x01, 0x73, 0xBC, 0x00,
+    0x05, 0xF8, 0x00, 0x06, 0xE9, 0x01, 0x0A, 0xF8, 0x00, 0x0D, 0xF8, 0x00, 0x12, 0x08, 0x01, 0x13, 0xEA, 0x01, 0x55, 0xF8, 0x00, 0x0D, 0xD7, 0x00,
+    0x4E, 0xCD, 0x00, 0x03, 0xF8, 0x00, 0x0A, 0xF8, 0x00, 0x2D, 0xE8, 0x00, 0x78, 0x00, 0x00, 0x00, 0x5E, 0x01, 0x6D, 0x00, 0x00, 0x06, 0xE9, 0x01,
+    0x0B, 0xF8, 0x00, 0x52, 0xCF, 0x01, 0x11, 0xF8, 0x00, 0x12, 0x08, 0x01, 0x13, 0x5A, 0x01, 0x14, 0xEB, 0x01, 0x55, 0xF8, 0x00, 0x02, 0x70, 0x01,
+    0x52, 0x08, 0x01, 0x4C, 0xF8, 0x00, 0x00, 0xBF, 0x00, 0x04, 0xBB, 0x00, 0x15, 0x5D, 0x01, 0x36, 0x00, 0x00, 0x57, 0x08, 0x01, 0x46, 0xE9, 0x01,
+    0x33, 0x00, 0x00, 0x76, 0x00, 0x00, 0x4C, 0xEC, 0x01, 0x25, 0x00, 0x00, 0x53, 0x59, 0x01, 0x6B, 0x00, 0x00, 0x02, 0xF8, 0x00, 0x24, 0x00, 0x00,
+    0x4B, 0xE8, 0x00, 0x44, 0x5E, 0x01, 0x47, 0x5D, 0x01, 0x31, 0x00, 0x00, 0x73, 0x00, 0x00, 0x44, 0xBF, 0x00, 0x6D, 0x00, 0x00, 0x06, 0xF8, 0x00,
+    0x0F, 0x5D, 0x01, 0x51, 0x08, 0x01, 0x4E, 0xED, 0x01, 0x42, 0xEE, 0x01, 0x40, 0xEF, 0x01, 0x48, 0xF2, 0x01, 0x2C, 0x00, 0x00, 0x2D, 0x00, 0x00,
+    0x2F, 0x00, 0x00, 0x30, 0x00, 0x00, 0x32, 0x00, 0x00, 0x33, 0x00, 0x00, 0x79, 0x00, 0x00, 0x21, 0x00, 0x00, 0x2B, 0x00, 0x00, 0x6E, 0x00, 0x00,
+    0x67, 0x00, 0x00, 0x48, 0xF3, 0x01, 0x55, 0xBF, 0x00, 0x40, 0xF5, 0x01, 0x26, 0xE9, 0x01, 0x55, 0x5D, 0x01, 0x08, 0xBB, 0x00, 0x0C, 0xF8, 0x00,
+    0x36, 0x00, 0x00, 0x78, 0x00, 0x00, 0x47, 0xF7, 0x01, 0x20, 0x00, 0x00, 0x02, 0xF8, 0x01, 0x24, 0xE2, 0x00, 0x0D, 0xF9, 0x01, 0x73, 0x00, 0x00,
+    0x24, 0x00, 0x00, 0x4E, 0xFA, 0x01, 0x03, 0xF8, 0x00, 0x66, 0x00, 0x00, 0x40, 0xFC, 0x01, 0x0C, 0xFD, 0x01, 0x0D, 0xD7, 0x00, 0x0E, 0x5E, 0x01,
+    0x54, 0x26, 0x01, 0x44, 0xFC, 0x01, 0x68, 0x00, 0x00, 0x00, 0xFE, 0x01, 0x08, 0xFC, 0x01, 0x0E, 0x00, 0x02, 0x54, 0x02, 0x02, 0x42, 0x70, 0x01,
+    0x0A, 0xF8, 0x00, 0x4B, 0xCD, 0x00, 0x0B, 0x55, 0x01, 0x52, 0x08, 0x01, 0x00, 0x03, 0x02, 0x24, 0x05, 0x02, 0x08, 0x0B, 0x02, 0x0E, 0x0D, 0x02,
+    0x51, 0x0F, 0x02, 0x77, 0x00, 0x00, 0x06, 0x11, 0x02, 0x6E, 0xCD, 0x00, 0x04, 0xF8, 0x00, 0x78, 0x00, 0x00, 0x51, 0x5E, 0x01, 0x6E, 0x00, 0x00,
+    0x03, 0x5D, 0x01, 0x53, 0x12, 0x02, 0x11, 0xE8, 0x00, 0x77, 0x00, 0x00, 0x0B, 0xCD, 0x00, 0x0D, 0x08, 0x01, 0x32, 0x00, 0x00, 0x13, 0x13, 0x02,
+    0x78, 0x00, 0x00, 0x0B, 0x55, 0x01, 0x0D, 0x08, 0x01, 0x51, 0xF8, 0x00, 0x00, 0x08, 0x01, 0x04, 0x15, 0x02, 0x08, 0x17, 0x02, 0x2E, 0x00, 0x00,
+    0x78, 0x00, 0x00, 0x0B, 0x55, 0x01, 0x53, 0x1A, 0x02, 0x11, 0x1B, 0x02, 0x54, 0x1E, 0x02, 0x48, 0x1F, 0x02, 0x40, 0xBF, 0x00, 0x74, 0x20, 0x02,
+    0x51, 0x9F, 0x01, 0x14, 0x08, 0x01, 0x55, 0xF8, 0x00, 0x48, 0x5E, 0x01, 0x4E, 0xD6, 0x01, 0x4D, 0xD7, 0x00, 0x40, 0x22, 0x02, 0x4C, 0x23, 0x02,
+    0x53, 0x5A, 0x01, 0x56, 0x5D, 0x01, 0x54, 0x26, 0x01, 0x40, 0x24, 0x02, 0x4E, 0x25, 0x02, 0x00, 0x5E, 0x01, 0x48, 0x5E, 0x01, 0x56, 0x26, 0x02,
+    0x56, 0x5E, 0x01, 0x51, 0xE8, 0x00, 0x4D, 0xE6, 0x01, 0x52, 0xF8, 0x00, 0x0B, 0xBB, 0x00, 0x4D, 0x27, 0x02, 0x45, 0x28, 0x02, 0x72, 0x00, 0x00,
+    0x53, 0x70, 0x01, 0x54, 0x29, 0x02, 0x2D, 0x00, 0x00, 0x51, 0xE8, 0x00, 0x4C, 0xED, 0x01, 0x48, 0x2A, 0x02, 0x52, 0x08, 0x01, 0x4B, 0x27, 0x01,
+    0x0D, 0xBB, 0x00, 0x71, 0x00, 0x00, 0x40, 0x08, 0x01, 0x14, 0xDF, 0x01, 0x76, 0x00, 0x00, 0x23, 0x00, 0x00, 0x71, 0x00, 0x00, 0x6F, 0x00, 0x00,
+    0x60, 0x00, 0x00, 0x4E, 0x2B, 0x02, 0x79, 0x00, 0x00, 0x4F, 0xCF, 0x01, 0x40, 0xCD, 0x00, 0x76, 0x00, 0x00, 0x46, 0xF8, 0x00, 0x11, 0x5E, 0x01,
+    0x55, 0xF8, 0x00, 0x47, 0x08, 0x01, 0x53, 0x2C, 0x02, 0x4D, 0x2D, 0x02, 0x41, 0x5D, 0x01, 0x4F, 0x2C, 0x02, 0x53, 0x2E, 0x02, 0x02, 0xF8, 0x00,
+    0x0D, 0x08, 0x01, 0x78, 0x00, 0x00, 0x4D, 0x08, 0x01, 0x02, 0xCD, 0x00, 0x79, 0x00, 0x00, 0x23, 0x00, 0x00, 0x6B, 0x00, 0x00, 0x4E, 0x2F, 0x02,
+    0x4E, 0x26, 0x01, 0x53, 0x30, 0x02, 0x14, 0x1E, 0x02, 0x76, 0x00, 0x00, 0x4B, 0x55, 0x01, 0x64, 0x31, 0x02, 0x11, 0x08, 0x01, 0x53, 0xF8, 0x00,
+    0x2F, 0x00, 0x00, 0x51, 0xE8, 0x00, 0x43, 0xE8, 0x00, 0x2D, 0x00, 0x00, 0x73, 0x00, 0x00, 0x08, 0xBF, 0x00, 0x2C, 0x00, 0x00, 0x2D, 0x00, 0x00,
+    0x11, 0xF8, 0x00, 0x12, 0xF8, 0x00, 0x78, 0x00, 0x00, 0x0D, 0x32, 0x02, 0x72, 0x00, 0x00, 0x12, 0xF8, 0x00, 0x54, 0x4F, 0x01, 0x04, 0xF8, 0x00,
+    0x4E, 0xD1, 0x01, 0x44, 0xC0, 0x01, 0x48, 0x55, 0x01, 0x02, 0x70, 0x01, 0x44, 0xBF, 0x00, 0x2D, 0x00, 0x00, 0x51, 0xF8, 0x00, 0x02, 0x70, 0x01,
+    0x0B, 0xF8, 0x00, 0x53, 0xF8, 0x00, 0x67, 0x34, 0x02, 0x23, 0x00, 0x00, 0x2A, 0x00, 0x00, 0x4B, 0xBB, 0x00, 0x4B, 0xBB, 0x00, 0x53, 0xF8, 0x00,
+    0x0D, 0xD7, 0x00, 0x71, 0x00, 0x00, 0x58, 0xCF, 0x01, 0x40, 0x55, 0x01, 0x54, 0xCB, 0x01, 0x51, 0xF8, 0x00, 0x44, 0x59, 0x01, 0x53, 0xC9, 0x01,
+    0x44, 0x35, 0x02, 0x46, 0x70, 0x01, 0x4B, 0xE8, 0x00, 0x51, 0x36, 0x02, 0x4B, 0xF8, 0x00, 0x53, 0x37, 0x02, 0x54, 0x25, 0x02, 0x4E, 0x55, 0x01,
+    0x44, 0x38, 0x02, 0x53, 0x39, 0x02, 0x26, 0x00, 0x00, 0x6A, 0x00, 0x00, 0x4E, 0x3B, 0x02, 0x51, 0x3C, 0x02, 0x53, 0x3D, 0x02, 0x40, 0xBB, 0x01,
+    0x4D, 0x3E, 0x02, 0x07, 0x3F, 0x02, 0x48, 0x40, 0x02, 0x54, 0x08, 0x01, 0x44, 0xF2, 0x01, 0x40, 0xF2, 0x01, 0x42, 0xF8, 0x00, 0x48, 0xBD, 0x01,
+    0x4C, 0x41, 0x02, 0x44, 0xCF, 0x01,
+};
+
+#endif // WORD_LIST_H
\ No newline at end of file
@@ -0,0 +1,141 @@
+/*
+Offline Morse decoder for recorded CW audio, built for the host by the 'audio' environment:
+    pio run -e audio && .pio/build/audio/program recording.wav
+    sox in.mp3 -t raw -r 8000 -e signed -b 16 -c 1 - | .pio/build/audio/program - --raw --rate 8000
+
+A Goertzel filter bank (goertzel.h) measures the tone power in short blocks, ToneKey turns it into key
+up/down, and the key edges drive the same Button -> Decoder path as the firmware through the
+virtual-clock simulation (simulation.h). Decoded text is printed as it is produced; the input is
+streamed a block at a time, so memory use is fixed however long the recording is.
+
+Options:
+    --raw                headerless PCM instead of WAV (little endian)
+    --rate N             sample rate of raw input (default 8000)
+    --channels N         channels of raw input (default 1)
+    --format F           raw sample format: u8, s16, s24, s32, f32 (default s16)
+    --tone HZ            listen on a single frequency instead of searching the band
+    --band LOW HIGH      band the filter bank covers (default 300 1200 Hz)
+    --filters N          filters in the bank (default 16)
+    --block-ms N         analysis block length, the timing resolution (default 4 ms)
+    --threshold K        classifier threshold multiplier (default: the firmware's)
+    --expect TEXT        ground truth; prints the character error rate at the end
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "goertzel.h"
+#include "metrics.h"
+#include "pcm_reader.h"
+#include "simulation.h"
+
+const uint64_t TAIL_MS = 3000; // silence appended at the end so the last letter and word finish
+
+void usage(const char* program) {
+    fprintf(stderr, "usage: %s FILE|- [--raw --rate N --channels N --format u8|s16|s24|s32|f32] [--tone HZ | --band LOW HIGH --filters N] [--block-ms N] [--threshold K] [--expect TEXT]\n", program);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    bool raw = false;
+    PcmFormat rawFormat;
+    float lowHz = 300, highHz = 1200, toneHz = 0;
+    int filters = 16;
+    double blockMs = 4;
+    float threshold = -1; // < 0 keeps the firmware's thresholdMultiplier
+    std::string expected;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool more = i + 1 < argc;
+        if (arg == "--raw") raw = true;
+        else if (arg == "--rate" && more) rawFormat.sampleRate = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--channels" && more) rawFormat.channels = (uint16_t)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--format" && more) {
+            std::string name = argv[++i];
+            if (name == "u8") rawFormat.encoding = PCM_U8;
+            else if (name == "s16") rawFormat.encoding = PCM_S16;
+            else if (name == "s24") rawFormat.encoding = PCM_S24;
+            else if (name == "s32") rawFormat.encoding = PCM_S32;
+            else if (name == "f32") rawFormat.encoding = PCM_F32;
+            else usage(argv[0]);
+        }
+        else if (arg == "--tone" && more) toneHz = atof(argv[++i]);
+        else if (arg == "--band" && i + 2 < argc) {
+            lowHz = atof(argv[++i]);
+            highHz = atof(argv[++i]);
+        }
+        else if (arg == "--filters" && more) filters = atoi(argv[++i]);
+        else if (arg == "--block-ms" && more) blockMs = atof(argv[++i]);
+        else if (arg == "--threshold" && more) threshold = atof(argv[++i]);
+        else if (arg == "--expect" && more) expected = argv[++i];
+        else if (arg[0] != '-' || arg == "-") path = argv[i];
+        else usage(argv[0]);
+    }
+    if (!path || blockMs <= 0 || rawFormat.channels == 0 || rawFormat.sampleRate == 0) usage(argv[0]);
+
+    PcmReader reader;
+    if (!reader.open(path, raw, rawFormat)) {
+        fprintf(stderr, "%s: %s\n", path, reader.error.c_str());
+        return 1;
+    }
+    const PcmFormat& format = reader.format;
+
+    GoertzelBank bank;
+    if (toneHz > 0) bank.configure(format.sampleRate, 1, toneHz, toneHz);
+    else bank.configure(format.sampleRate, filters, lowHz, highHz);
+    ToneKey key;
+    key.decay = (float)(blockMs / 2000); // trackers settle over ~2 s
+
+    size_t blockSamples = (size_t)(format.sampleRate * blockMs / 1000);
+    if (blockSamples == 0) blockSamples = 1;
+    std::vector<float> block(blockSamples); // the only sample buffer; its size is fixed by the block length
+
+    Simulation simulation;
+    if (threshold >= 0) simulation.decoder.classifier.thresholdMultiplier = threshold;
+    std::string decoded; // kept only to score against --expect
+    uint64_t samples = 0;
+    uint64_t edges = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    size_t got;
+    while ((got = reader.read(block.data(), blockSamples)) > 0) {
+        bank.process(block.data(), got);
+        samples += got;
+        if (key.update(bank)) {
+            simulation.key(samples * 1000 / format.sampleRate, key.down); // edge at the end of the block that showed it
+            edges++;
+        }
+        if (!simulation.decoded.empty()) { // prints letters as soon as they are decoded
+            fputs(simulation.decoded.c_str(), stdout);
+            fflush(stdout);
+            if (!expected.empty()) decoded += simulation.decoded;
+            simulation.decoded.clear();
+        }
+    }
+    uint64_t audioMs = samples * 1000 / format.sampleRate;
+    if (key.down) simulation.key(audioMs, false); // the recording ended mid-tone
+    simulation.advance_to(audioMs + TAIL_MS);
+    fputs(simulation.decoded.c_str(), stdout);
+    putchar('\n');
+    fflush(stdout);
+    decoded += simulation.decoded;
+
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "audio      %.1f s at %u Hz, %d filters x %zu samples/block (%d lanes)\n", audioMs / 1000.0,
+            format.sampleRate, bank.count, blockSamples, GOERTZEL_LANES);
+    fprintf(stderr, "tone       %.0f Hz, %llu key edges, %llu invalid patterns\n", bank.frequency[key.lockedFilter < 0 ? 0 : key.lockedFilter],
+            (unsigned long long)edges, (unsigned long long)simulation.invalid);
+    fprintf(stderr, "speed      %.1f ms wall, %.0fx real time\n", wallMs, audioMs / (wallMs > 0 ? wallMs : 1e-3));
+    if (!expected.empty()) {
+        for (char& c : expected) c = toupper(c);
+        while (!decoded.empty() && decoded.back() == ' ') decoded.pop_back();
+        size_t errors = edit_distance(expected, decoded);
+        fprintf(stderr, "accuracy   %zu edits, CER %.2f%%\n", errors, 100.0 * errors / expected.size());
+    }
+    return 0;
+}
\ No newline at end of file
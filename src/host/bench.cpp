@@ -0,0 +1,205 @@
+/*
+Microbenchmarks of the decoder core, built for the host by the 'native' environment:
+    pio run -e native && .pio/build/native/program [--min-ms 200] [--worst-trace worst.trace]
+
+Measures the time per pattern lookup (MorseCode::get_letter), per press classification (Classifier),
+per lcd scroll (DisplayText::scroll) and per word correction (WordCorrector::correct) on the input
+that visits the most edges of the shipped word list. Each benchmark is calibrated to run for at least
+--min-ms and repeated; the best and median ns/op of the repetitions are reported. --worst-trace
+writes that input as a text trace (text_trace.h) at 20 WPM, to time it on the firmware under simavr.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../lib/classifier.h"
+#include "../../lib/display_text.h"
+#include "../../lib/morse_code.h"
+#include "../../lib/word_corrector.h"
+#include "../../lib/word_list.h"
+
+const int REPETITIONS = 7; // timed runs per benchmark; the median is reported alongside the best
+
+// Keeps the compiler from optimising away a value computed by a benchmark.
+template <typename T> inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchResult { // ns per operation of a benchmark.
+    double best;
+    double median;
+};
+
+// Times 'body(iterations)' and returns ns per iteration.
+template <typename Body> double time_once(Body& body, uint64_t iterations) {
+    auto start = std::chrono::steady_clock::now();
+    body(iterations);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+// Calibrates the iteration count to at least 'minMs' and returns the best/median of the repetitions.
+template <typename Body> BenchResult run(Body body, double minMs) {
+    uint64_t iterations = 1;
+    while (time_once(body, iterations) * iterations < minMs * 1e6) { // grows until a run takes long enough
+        iterations *= 2;
+    }
+    std::vector<double> samples;
+    for (int i = 0; i < REPETITIONS; i++) samples.push_back(time_once(body, iterations));
+    std::sort(samples.begin(), samples.end());
+    return { samples.front(), samples[samples.size() / 2] };
+}
+
+void report(const char* name, BenchResult result) {
+    printf("%-34s %10.2f ns/op best %10.2f ns/op median\n", name, result.best, result.median);
+}
+
+// Letter of a packed pattern, '?' if it is none (as the decoder hands it to the word corrector).
+char letter_of(uint8_t packed) {
+    for (int i = 0; i < 26; i++) {
+        if (packed_letter(i) == packed) return 'A' + i;
+    }
+    return '?';
+}
+
+// Keys the letters of 'word' into 'corrector' and looks for a correction; returns the edges visited.
+unsigned int correct(WordCorrector& corrector, const std::vector<uint8_t>& word) {
+    char corrected[MAX_WORD_LETTERS + 3];
+    corrector.reset();
+    for (uint8_t pattern : word) corrector.add_letter(letter_of(pattern), pattern);
+    keep(corrector.correct(corrected));
+    return corrector.visited;
+}
+
+// Writes 'word' as a text trace at 20 WPM (dit 60 ms), followed by a word gap.
+void write_trace(const char* path, const std::vector<uint8_t>& word) {
+    std::ofstream out(path);
+    out << "# input with the longest word correction search in bench.cpp, 20 WPM\n";
+    for (uint8_t pattern : word) {
+        uint8_t length = 0;
+        while (pattern >> (length + 1)) length++;
+        for (int i = length - 1; i >= 0; i--) {
+            out << "press " << ((pattern >> i) & 1 ? 180 : 60) << "\n";
+            out << "gap " << (i ? 60 : 180) << "\n";
+        }
+    }
+    out << "gap 1500\n";
+}
+
+int main(int argc, char** argv) {
+    double minMs = 200; // minimum duration of one timed run
+    const char* worstTrace = nullptr; // where to write the worst word correction input
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--min-ms" && i + 1 < argc) minMs = atof(argv[++i]);
+        else if (arg == "--worst-trace" && i + 1 < argc) worstTrace = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--min-ms N] [--worst-trace FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Pattern lookups: every letter plus patterns that match nothing (the slowest case, a full scan).
+    MorseCode morse;
+    std::vector<std::string> patterns;
+    for (int i = 0; i < 26; i++) patterns.push_back(validPatterns[i]);
+    std::vector<std::string> invalid = { "1111", "0011", "0101", "1110" };
+
+    report("get_letter (A-Z)", run([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) keep(morse.get_letter(&patterns[i % patterns.size()][0]));
+    }, minMs));
+    report("get_letter (no match)", run([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) keep(morse.get_letter(&invalid[i % invalid.size()][0]));
+    }, minMs));
+
+    // Press classification on a realistic mix of dits (~80 ms) and dahs (~240 ms) with jitter.
+    std::mt19937 random(12345);
+    std::normal_distribution<double> jitter(0, 12);
+    std::vector<unsigned long> durations(4096);
+    for (auto& duration : durations) duration = (unsigned long)std::max(10.0, (random() % 3 ? 80 : 240) + jitter(random));
+
+    Durations::ButtonProperties properties;
+    Classifier classifier(properties);
+    for (unsigned long duration : durations) classifier.add_press(duration); // warm statistics
+    report("classify_press", run([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) keep(classifier.classify_press(durations[i & 4095]));
+    }, minMs));
+    report("classify_press + add_press", run([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            keep(classifier.classify_press(durations[i & 4095]));
+            classifier.add_press(durations[i & 4095]);
+        }
+    }, minMs));
+
+    // Scrolling on a full display (the steady state once 32 letters have been typed).
+    DisplayText text;
+    for (int i = 0; i < 32; i++) text.scroll('A' + i % 26);
+    report("scroll (full display)", run([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) text.scroll('A' + i % 26);
+        keep(text.lines);
+    }, minMs));
+    report("scroll (from empty, 16 letters)", run([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            if (i % 16 == 0) text.clear();
+            text.scroll('A' + i % 26);
+        }
+        keep(text.lines);
+    }, minMs));
+
+    // Word correction on the input that visits the most word list edges: the worst of every word of up to
+    // 3 letters of 1-4 presses (valid letters or not) and of random words of 4 to MAX_WORD_LETTERS letters,
+    // then changed a letter at a time for as long as that makes the search longer.
+    std::vector<uint8_t> keyable; // packed patterns of 1-4 presses
+    for (int length = 1; length <= 4; length++) {
+        for (int bits = 0; bits < (1 << length); bits++) keyable.push_back((1 << length) | bits);
+    }
+    WordCorrector corrector(wordList);
+    std::vector<uint8_t> worst;
+    unsigned int worstVisited = 0;
+    auto consider = [&](const std::vector<uint8_t>& word) {
+        unsigned int visited = correct(corrector, word);
+        if (visited > worstVisited) {
+            worstVisited = visited;
+            worst = word;
+        }
+    };
+    size_t k = keyable.size();
+    for (size_t i = 0; i < k; i++) {
+        consider({ keyable[i] });
+        for (size_t j = 0; j < k; j++) {
+            consider({ keyable[i], keyable[j] });
+            for (size_t l = 0; l < k; l++) consider({ keyable[i], keyable[j], keyable[l] });
+        }
+    }
+    for (int i = 0; i < 20000; i++) {
+        std::vector<uint8_t> word(4 + random() % (MAX_WORD_LETTERS - 3));
+        for (auto& pattern : word) pattern = keyable[random() % k];
+        consider(word);
+    }
+    for (unsigned int before = 0; before != worstVisited;) {
+        before = worstVisited;
+        for (size_t position = 0; position < worst.size(); position++) {
+            std::vector<uint8_t> word = worst;
+            for (uint8_t pattern : keyable) {
+                word[position] = pattern;
+                consider(word);
+            }
+        }
+    }
+    std::string keyed;
+    for (uint8_t pattern : worst) keyed.push_back(letter_of(pattern));
+    char name[64];
+    snprintf(name, sizeof(name), "correct (worst: %s, %u edges)", keyed.c_str(), worstVisited);
+    report(name, run([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) keep(correct(corrector, worst));
+    }, minMs));
+    if (worstTrace) write_trace(worstTrace, worst);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,229 @@
+/*
+Decodes a corpus of recorded key traces on every core and reports how well the firmware's decoder
+does, built for the host by the 'corpus' environment:
+    pio run -e corpus && .pio/build/corpus/program traces/ [more files or directories] [--threshold K]
+
+Inputs are binary key traces (.ktr, key_trace.h) and text traces (.trace, text_trace.h); directories
+are searched recursively. Every session with ground-truth text is decoded by its own KeyDecoder
+(key_decoder.h), i.e. the same Button, Classifier and MorseCode code as the firmware, in batches on a
+work-stealing pool. Reported: overall character error rate, decode throughput in edges/s, accuracy
+per WPM bucket and the worst sessions.
+
+Sessions without a WPM in their metadata get one estimated from the ground truth: the text's length
+in standard Morse units (dit 1, dah 3, gaps 1/3/7) over the keyed time.
+
+Options:
+    --threshold K       classifier threshold multiplier (default: the firmware's)
+    --word-gap K        word gap multiplier of the decoder (default: the firmware's)
+    --bucket N          width of the WPM buckets (default 5)
+    --threads N         worker threads including the main one (default: one per core)
+    --worst N           sessions listed with the highest error rate (default 5)
+    --viterbi           decode with the soft-decision decoder (viterbi_decoder.h) instead of the firmware's
+    --beam N            states the soft-decision decoder keeps (default 64)
+    --letter-model FILE train its bigram letter model on this text instead of the built-in sample
+    --correct           correct words at the word gap as the firmware does with MORSE_WORD_CORRECTION
+    --words FILE        word list for --correct, raw edges from tools/build_word_list.py --binary
+                        (default: the firmware's lib/word_list.h)
+    --warm              seed every session's classifier with the statistics the previous session ended on,
+                        as the device does from EEPROM after a power cycle (timing_store.h), and compare
+                        with cold starts, over whole sessions and their first START_CHARACTERS characters
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../../lib/word_list.h"
+#include "corpus.h"
+#include "work_pool.h"
+
+const int SESSIONS_PER_TASK = 32; // sessions decoded by one pool task
+const size_t START_CHARACTERS = 12; // characters at the start of a session that --warm reports separately
+
+void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s PATH... [--threshold K] [--word-gap K] [--bucket N] [--threads N] [--worst N]\n"
+            "       [--viterbi] [--beam N] [--letter-model FILE] [--correct [--words FILE]] [--warm]\n",
+            program);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    float threshold = -1, wordGap = -1;
+    double bucketWidth = 5;
+    unsigned threads = 0;
+    size_t worst = 5;
+    bool viterbi = false;
+    ViterbiSettings viterbiSettings;
+    std::string letterModelFile;
+    bool correct = false;
+    std::string wordsFile;
+    bool warm = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool more = i + 1 < argc;
+        if (arg == "--threshold" && more) threshold = atof(argv[++i]);
+        else if (arg == "--word-gap" && more) wordGap = atof(argv[++i]);
+        else if (arg == "--bucket" && more) bucketWidth = atof(argv[++i]);
+        else if (arg == "--threads" && more) threads = (unsigned)atoi(argv[++i]);
+        else if (arg == "--worst" && more) worst = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--viterbi") viterbi = true;
+        else if (arg == "--beam" && more) viterbiSettings.beam = atoi(argv[++i]);
+        else if (arg == "--letter-model" && more) letterModelFile = argv[++i];
+        else if (arg == "--correct") correct = true;
+        else if (arg == "--words" && more) wordsFile = argv[++i];
+        else if (arg == "--warm") warm = true;
+        else if (arg[0] == '-') usage(argv[0]);
+        else paths.push_back(arg);
+    }
+    if (paths.empty() || bucketWidth <= 0 || viterbiSettings.beam < 1 || (warm && viterbi)) usage(argv[0]);
+    LetterModel letterModel;
+    if (!letterModelFile.empty()) {
+        std::ifstream file(letterModelFile);
+        if (!file) {
+            fprintf(stderr, "cannot open %s\n", letterModelFile.c_str());
+            return 1;
+        }
+        letterModel.train(std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()));
+    }
+    std::vector<uint8_t> words; // a word list loaded with --words
+    if (!wordsFile.empty()) {
+        std::ifstream file(wordsFile, std::ios::binary);
+        words.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (words.size() < 3 || words.size() % 3 != 0) {
+            fprintf(stderr, "%s is not a word list from tools/build_word_list.py --binary\n", wordsFile.c_str());
+            return 1;
+        }
+    }
+
+    // Gather sessions. Binary files stay mapped; text traces are small and parsed up front.
+    Corpus corpus;
+    for (const std::string& path : paths) {
+        if (!corpus.add(path)) {
+            fprintf(stderr, "%s\n", corpus.error.c_str());
+            return 1;
+        }
+    }
+    const std::vector<CorpusSession>& sessions = corpus.sessions;
+    if (sessions.empty()) {
+        fprintf(stderr, "no sessions with ground truth text found\n");
+        return 1;
+    }
+    DecoderParameters parameters;
+    if (threshold >= 0) parameters.thresholdMultiplier = threshold;
+    if (wordGap >= 0) parameters.wordGapMultiplier = wordGap;
+    if (correct) parameters.wordList = words.empty() ? wordList : words.data();
+
+    // Decode everything in batches of sessions; each task writes only its own results.
+    std::vector<SessionResult> results(sessions.size());
+    WorkPool pool(threads);
+    std::vector<WorkPool::Task> tasks;
+    for (size_t first = 0; first < sessions.size(); first += SESSIONS_PER_TASK) {
+        size_t last = std::min(sessions.size(), first + SESSIONS_PER_TASK);
+        tasks.push_back([&, first, last] {
+            for (size_t i = first; i < last; i++) results[i] = viterbi ? decode_session_viterbi(sessions[i], viterbiSettings, letterModel) : decode_session(sessions[i], parameters);
+        });
+    }
+    auto start = std::chrono::steady_clock::now();
+    pool.run(tasks);
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // With --warm, decode again from the statistics the previous session ended on. A settled classifier's windows hold
+    // only real keying, so they are the same whatever it was seeded with, and the cold results serve as the previous
+    // sessions. The cold results are kept for comparison.
+    std::vector<SessionResult> cold;
+    size_t seeded = 0;
+    if (warm) {
+        cold.swap(results);
+        results.resize(sessions.size());
+        tasks.clear();
+        for (size_t first = 0; first < sessions.size(); first += SESSIONS_PER_TASK) {
+            size_t last = std::min(sessions.size(), first + SESSIONS_PER_TASK);
+            tasks.push_back([&, first, last] {
+                for (size_t i = first; i < last; i++) {
+                    bool saved = i > 0 && cold[i - 1].settled; // the device only saves statistics of real keying
+                    results[i] = decode_session(sessions[i], parameters, saved ? &cold[i - 1].timing : nullptr);
+                }
+            });
+        }
+        pool.run(tasks);
+        for (size_t i = 1; i < sessions.size(); i++) seeded += cold[i - 1].settled;
+    }
+
+    // Totals and WPM buckets.
+    struct Bucket {
+        size_t sessions = 0, characters = 0, edits = 0;
+        uint64_t edges = 0;
+    };
+    uint64_t corrections = 0;
+    unsigned int mostVisited = 0;
+    std::map<int, Bucket> buckets; // lower edge of the bucket, -1 for unknown speed
+    Bucket total;
+    double keyedMs = 0;
+    for (size_t i = 0; i < sessions.size(); i++) {
+        const SessionResult& result = results[i];
+        double wpm = sessions[i].wpm;
+        if (wpm <= 0 && result.keyedMs > 0) { // estimated from the text's length in units
+            double units = morse_units(sessions[i].expected);
+            if (units > 0) wpm = 1200.0 * units / result.keyedMs;
+        }
+        int bucket = wpm > 0 ? (int)(wpm / bucketWidth) * (int)bucketWidth : -1;
+        for (Bucket* b : { &buckets[bucket], &total }) {
+            b->sessions++;
+            b->characters += sessions[i].expected.size();
+            b->edits += result.edits;
+            b->edges += result.edges;
+        }
+        keyedMs += result.keyedMs;
+        corrections += result.corrections;
+        mostVisited = std::max(mostVisited, result.mostVisited);
+    }
+
+    printf("corpus     %zu files, %zu sessions (%zu without ground truth skipped), %.1f h of keying\n", corpus.inputs.size(),
+           sessions.size(), corpus.skipped, keyedMs / 3.6e6);
+    printf("decode     %.1f ms on %u threads, %.2f M edges/s, %.0fx real time, %llu tasks stolen\n", wallMs, pool.threads(),
+           total.edges / (wallMs * 1e3), keyedMs / wallMs, (unsigned long long)pool.steals());
+    printf("accuracy   %zu edits over %zu characters, CER %.2f%%\n", total.edits, total.characters, 100.0 * total.edits / total.characters);
+    if (correct) printf("correct    %llu words replaced, at most %u word list edges visited per word\n", (unsigned long long)corrections, mostVisited);
+    if (warm) {
+        size_t coldEdits = 0, startEdits[2] = {}, startCharacters = 0; // [0] cold, [1] warm
+        for (size_t i = 0; i < sessions.size(); i++) {
+            coldEdits += cold[i].edits;
+            std::string expected = sessions[i].expected.substr(0, START_CHARACTERS);
+            startCharacters += expected.size();
+            startEdits[0] += edit_distance(expected, cold[i].decoded.substr(0, START_CHARACTERS));
+            startEdits[1] += edit_distance(expected, results[i].decoded.substr(0, START_CHARACTERS));
+        }
+        printf("warm start %zu sessions seeded, CER %.2f%% (cold %.2f%%), first %zu characters %.2f%% (cold %.2f%%)\n", seeded,
+               100.0 * total.edits / total.characters, 100.0 * coldEdits / total.characters, START_CHARACTERS,
+               100.0 * startEdits[1] / startCharacters, 100.0 * startEdits[0] / startCharacters);
+    }
+    printf("\n");
+    printf("%-11s %8s %10s %8s\n", "WPM", "sessions", "characters", "CER");
+    for (const auto& entry : buckets) {
+        char label[32];
+        if (entry.first < 0) snprintf(label, sizeof(label), "unknown");
+        else snprintf(label, sizeof(label), "%d-%d", entry.first, entry.first + (int)bucketWidth);
+        const Bucket& b = entry.second;
+        printf("%-11s %8zu %10zu %7.2f%%\n", label, b.sessions, b.characters, 100.0 * b.edits / b.characters);
+    }
+
+    std::vector<size_t> order(sessions.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    auto rate = [&](size_t i) { return (double)results[i].edits / sessions[i].expected.size(); };
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return rate(a) > rate(b); });
+    if (worst > 0 && results[order[0]].edits > 0) printf("\nworst sessions\n");
+    for (size_t i = 0; i < std::min(worst, order.size()) && results[order[i]].edits > 0; i++) {
+        size_t s = order[i];
+        printf("  %6.1f%%  %s\n           expected \"%.60s\"\n           decoded  \"%.60s\"\n", 100 * rate(s), sessions[s].name.c_str(),
+               sessions[s].expected.c_str(), results[s].decoded.c_str());
+    }
+    return 0;
+}
\ No newline at end of file
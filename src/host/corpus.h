@@ -0,0 +1,248 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+/*
+A corpus of recorded keying for the host tools that measure the decoders against ground truth
+(corpus.cpp, tune.cpp): every session with an expected text from a set of .ktr (key_trace.h) and
+.trace (text_trace.h) files or directories of them.
+
+Binary sessions are decoded straight from the file mapping; cache() parses them into memory once
+for tools that replay the same sessions many times.
+*/
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "key_decoder.h"
+#include "key_trace.h"
+#include "../../lib/timing_store.h"
+#include "metrics.h"
+#include "text_trace.h"
+#include "viterbi_decoder.h"
+
+const uint64_t CORPUS_TAIL_MS = 3000; // quiet time after the last edge so the last letter and word finish
+
+struct DecoderParameters { // The decoder's tunable constants; defaults are the firmware's.
+    float thresholdMultiplier = TUNED_THRESHOLD_MULTIPLIER;
+    int shortPressCap = TUNED_SHORT_PRESS_CAP;
+    int longPressCap = TUNED_LONG_PRESS_CAP;
+    float wordGapMultiplier = TUNED_WORD_GAP_MULTIPLIER;
+    const uint8_t* wordList = nullptr; // if set, words are corrected against this DAWG (word_corrector.h)
+
+    void apply(KeyDecoder& decoder) const {
+        Durations::ButtonProperties& properties = decoder.button.properties();
+        decoder.decoder.classifier.thresholdMultiplier = thresholdMultiplier;
+        properties.shortPressCap = shortPressCap;
+        properties.longPressCap = longPressCap;
+        decoder.decoder.wordGapMultiplier = wordGapMultiplier;
+    }
+};
+
+struct CorpusSession { // A session to decode: where its edges come from, and what it should decode to.
+    const KeyTraceFile* file = nullptr; // binary session: its file and index
+    uint32_t index = 0;
+    const Trace* trace = nullptr; // text session
+    std::vector<TraceEdge> cached; // edges parsed by Corpus::cache(), used instead of the above
+    std::string name; // file (and session number) for reports
+    std::string expected;
+    double wpm = 0; // from the metadata, 0 if unknown
+};
+
+struct SessionResult {
+    size_t edits = 0; // edit distance between the expected and the decoded text
+    uint64_t edges = 0;
+    double keyedMs = 0; // first to last edge
+    uint64_t corrections = 0; // words replaced by the word corrector
+    unsigned int mostVisited = 0; // most word list edges one correction looked at
+    TimingSnapshot timing = {}; // windows the classifier ended on
+    bool settled = false; // 'timing' comes from real keying only, i.e. the device would have saved it (timing_store.h)
+    std::string decoded;
+};
+
+class Corpus {
+    public:
+    std::vector<CorpusSession> sessions;
+    std::vector<std::string> inputs; // files the sessions came from
+    size_t skipped = 0; // sessions without ground truth
+    size_t characters = 0; // total length of the expected texts
+    std::string error;
+
+    // Adds the sessions of a .ktr or .trace file, or of all such files under a directory.
+    bool add(const std::string& path) {
+        struct stat status;
+        if (stat(path.c_str(), &status) != 0) {
+            error = "cannot open " + path;
+            return false;
+        }
+        if (S_ISDIR(status.st_mode)) return add_directory(path);
+        inputs.push_back(path);
+        if (ends_with(path, ".trace")) {
+            texts.emplace_back(new Trace(load_trace(path.c_str(), 0)));
+            CorpusSession session;
+            session.trace = texts.back().get();
+            session.name = path;
+            session.expected = session.trace->expected;
+            keep(session);
+            return true;
+        }
+        files.emplace_back(new KeyTraceFile());
+        KeyTraceFile& file = *files.back();
+        if (!file.open(path.c_str())) {
+            error = path + ": " + file.error;
+            return false;
+        }
+        for (uint32_t i = 0; i < file.sessionCount; i++) {
+            KeyTraceSession s = file.session(i);
+            CorpusSession session;
+            session.file = &file;
+            session.index = i;
+            session.name = path + "#" + std::to_string(i);
+            session.expected = s.get("text");
+            for (char& c : session.expected) c = toupper(c);
+            session.wpm = s.wpm();
+            keep(session);
+        }
+        return true;
+    }
+
+    // Parses the edges of every binary session into memory.
+    void cache() {
+        for (CorpusSession& session : sessions) {
+            if (!session.file || !session.cached.empty()) continue;
+            KeyEdgeCursor cursor = session.file->session(session.index).edges();
+            KeyEdge edge;
+            while (cursor.next(edge)) session.cached.push_back({ (uint64_t)session.file->ms(edge.time), edge.pressed });
+        }
+    }
+
+    private:
+    std::vector<std::unique_ptr<KeyTraceFile>> files; // kept mapped for the sessions
+    std::vector<std::unique_ptr<Trace>> texts;
+
+    static bool ends_with(const std::string& text, const char* suffix) {
+        size_t n = strlen(suffix);
+        return text.size() > n && text.compare(text.size() - n, n, suffix) == 0;
+    }
+
+    bool add_directory(const std::string& path) {
+        DIR* dir = opendir(path.c_str());
+        if (!dir) {
+            error = "cannot read " + path;
+            return false;
+        }
+        std::vector<std::string> names;
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name[0] != '.') names.push_back(name);
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end()); // same order on every run
+        for (const std::string& name : names) {
+            std::string child = path + "/" + name;
+            struct stat status;
+            bool isDir = stat(child.c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+            if ((isDir || ends_with(name, ".ktr") || ends_with(name, ".trace")) && !add(child)) return false;
+        }
+        return true;
+    }
+
+    void keep(const CorpusSession& session) {
+        if (session.expected.empty()) {
+            skipped++;
+            return;
+        }
+        characters += session.expected.size();
+        sessions.push_back(session);
+    }
+};
+
+// Calls 'f(timeMs, pressed)' for every edge of a session, in order.
+template <typename F> void for_each_edge(const CorpusSession& session, F f) {
+    if (!session.cached.empty() || !session.file) {
+        for (const TraceEdge& edge : session.file ? session.cached : session.trace->edges) f(edge.timeMs, edge.pressed);
+        return;
+    }
+    KeyEdgeCursor cursor = session.file->session(session.index).edges();
+    KeyEdge edge;
+    while (cursor.next(edge)) f((uint64_t)session.file->ms(edge.time), edge.pressed);
+}
+
+// Fills in the result from the decoded text.
+inline void score_session(const CorpusSession& session, const std::string& decoded, SessionResult& result) {
+    result.decoded = decoded;
+    while (!result.decoded.empty() && result.decoded.back() == ' ') result.decoded.pop_back();
+    result.edits = edit_distance(session.expected, result.decoded);
+}
+
+// Decodes one session with a fresh decoder set up with 'parameters', its classifier seeded with 'seed' if given (as the device seeds it from EEPROM at boot).
+inline SessionResult decode_session(const CorpusSession& session, const DecoderParameters& parameters, const TimingSnapshot* seed = nullptr) {
+    KeyDecoder decoder;
+    parameters.apply(decoder);
+    if (seed) decoder.decoder.classifier.seed(seed->presses, seed->releases);
+    std::unique_ptr<WordCorrector> corrector;
+    if (parameters.wordList) {
+        corrector.reset(new WordCorrector(parameters.wordList));
+        decoder.corrector = corrector.get();
+    }
+    SessionResult result;
+    uint64_t first = 0, last = 0;
+    for_each_edge(session, [&](uint64_t time, bool pressed) {
+        last = time;
+        if (result.edges++ == 0) first = time;
+        decoder.key(time, pressed);
+    });
+    decoder.finish(last, CORPUS_TAIL_MS);
+    result.keyedMs = (double)(last - first);
+    result.corrections = decoder.corrections;
+    result.mostVisited = decoder.mostVisited;
+    result.timing = TimingSnapshot::of(decoder.decoder.classifier);
+    result.settled = decoder.decoder.classifier.settled();
+    score_session(session, decoder.text, result);
+    return result;
+}
+
+// Decodes one session with a fresh soft-decision decoder (viterbi_decoder.h).
+inline SessionResult decode_session_viterbi(const CorpusSession& session, const ViterbiSettings& settings, const LetterModel& model) {
+    ViterbiDecoder decoder(settings);
+    decoder.model = model;
+    SessionResult result;
+    uint64_t first = 0, last = 0;
+    for_each_edge(session, [&](uint64_t time, bool pressed) {
+        last = time;
+        if (result.edges++ == 0) first = time;
+        decoder.key(time, pressed);
+    });
+    decoder.finish(last);
+    result.keyedMs = (double)(last - first);
+    score_session(session, decoder.text(), result);
+    return result;
+}
+
+// Standard length of a text in Morse units (dit 1, dah 3, gaps 1/3/7), 0 if it has characters the table does not know.
+inline double morse_units(const std::string& text) {
+    double units = 0;
+    bool letterBefore = false; // whether the previous character was a letter (needs a letter gap)
+    for (char c : text) {
+        if (c == ' ') {
+            if (letterBefore) units += 7;
+            letterBefore = false;
+            continue;
+        }
+        if (c < 'A' || c > 'Z') return 0;
+        if (letterBefore) units += 3;
+        const char* pattern = validPatterns[c - 'A'];
+        for (int i = 0; pattern[i]; i++) units += (pattern[i] == '1' ? 3 : 1) + (i ? 1 : 0);
+        letterBefore = true;
+    }
+    return units;
+}
+
+#endif // CORPUS_H
\ No newline at end of file
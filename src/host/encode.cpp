@@ -0,0 +1,215 @@
+/*
+Encodes text to clean Morse for training material and test fixtures, built for the host by the
+'encode' environment:
+    pio run -e encode && .pio/build/encode/program book.txt book.wav --wpm 25 --farnsworth 15
+    .pio/build/encode/program book.txt - --format pcm | aplay -f S16_LE -r 8000
+    .pio/build/encode/program phrases.txt fixtures.ktr --wpm 20
+
+Text goes through MorseEncoder (morse_encoder.h), which uses the firmware's packed letter table.
+The output format follows the extension of OUT unless --format is given:
+    .wav        keyed tone (tone_synth.h) as a WAV file
+    pcm         the same as headerless little endian PCM (any other extension, or stdout)
+    .trace      a text trace (text_trace.h) of the whole input, with the text as 'expect'
+    .ktr        a binary key trace (key_trace.h) with one session per non-empty input line, the line
+                as its ground truth text
+Audio and .ktr output stream: input is read and written a block (or a line) at a time, so corpora of
+any size go through in fixed memory at disk speed. A .trace holds its ground truth until the end.
+
+Options:
+    --format F          wav, pcm, trace or ktr
+    --wpm N             character speed (default 20)
+    --farnsworth N      overall speed with stretched letter and word gaps (default none)
+    --tone HZ           tone frequency (default 600)
+    --rate N            sample rate (default 8000)
+    --amplitude X       peak level, 1 for full scale (default 0.5)
+    --rise-ms X         raised-cosine ramp length, at most a dit (default 5)
+    --float             32-bit float samples instead of 16-bit integers
+    --lead-ms N         silence (key up) before the first letter (default 500)
+    --tail-ms N         silence after the last letter (default 1000)
+    --tick-us N         .ktr time resolution in microseconds (default 1000, the firmware's millis())
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "key_trace.h"
+#include "morse_encoder.h"
+#include "pcm_writer.h"
+#include "tone_synth.h"
+
+const size_t READ_CHUNK = 1 << 16; // bytes of text read at a time
+
+void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s IN|- OUT|- [--format wav|pcm|trace|ktr] [--wpm N] [--farnsworth N] [--tone HZ] [--rate N]\n"
+            "       [--amplitude X] [--rise-ms X] [--float] [--lead-ms N] [--tail-ms N] [--tick-us N]\n",
+            program);
+    exit(2);
+}
+
+bool ends_with(const std::string& text, const char* suffix) {
+    size_t n = strlen(suffix);
+    return text.size() >= n && text.compare(text.size() - n, n, suffix) == 0;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    std::string format;
+    double wpm = 20, farnsworth = 0, tone = 600, amplitude = 0.5, riseMs = 5, leadMs = 500, tailMs = 1000;
+    uint32_t rate = 8000, tickUs = 1000;
+    bool floatSamples = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool more = i + 1 < argc;
+        if (arg == "--format" && more) format = argv[++i];
+        else if (arg == "--wpm" && more) wpm = atof(argv[++i]);
+        else if (arg == "--farnsworth" && more) farnsworth = atof(argv[++i]);
+        else if (arg == "--tone" && more) tone = atof(argv[++i]);
+        else if (arg == "--rate" && more) rate = (uint32_t)atol(argv[++i]);
+        else if (arg == "--amplitude" && more) amplitude = atof(argv[++i]);
+        else if (arg == "--rise-ms" && more) riseMs = atof(argv[++i]);
+        else if (arg == "--float") floatSamples = true;
+        else if (arg == "--lead-ms" && more) leadMs = atof(argv[++i]);
+        else if (arg == "--tail-ms" && more) tailMs = atof(argv[++i]);
+        else if (arg == "--tick-us" && more) tickUs = (uint32_t)atol(argv[++i]);
+        else if (arg[0] == '-' && arg != "-") usage(argv[0]);
+        else paths.push_back(arg);
+    }
+    if (paths.size() != 2 || wpm <= 0 || rate == 0 || tickUs == 0 || tone <= 0 || tone >= rate / 2.0 || leadMs < 0 || tailMs < 0) usage(argv[0]);
+    const std::string& out = paths[1];
+    if (format.empty()) format = ends_with(out, ".wav") ? "wav" : ends_with(out, ".trace") ? "trace" : ends_with(out, ".ktr") ? "ktr" : "pcm";
+    if (format != "wav" && format != "pcm" && format != "trace" && format != "ktr") usage(argv[0]);
+    if (format == "ktr" && out == "-") usage(argv[0]); // the index is written at the end, so .ktr needs a file
+
+    FILE* in = paths[0] == "-" ? stdin : fopen(paths[0].c_str(), "rb");
+    if (!in) {
+        fprintf(stderr, "cannot open %s\n", paths[0].c_str());
+        return 1;
+    }
+    MorseTiming timing = MorseTiming::at(wpm, farnsworth);
+    MorseEncoder encoder(timing);
+    std::vector<char> chunk(READ_CHUNK);
+    double keyedMs = 0;
+    uint64_t bytesIn = 0, marks = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    if (format == "wav" || format == "pcm") {
+        PcmFormat pcm;
+        pcm.encoding = floatSamples ? PCM_F32 : PCM_S16;
+        pcm.sampleRate = rate;
+        PcmWriter writer;
+        if (!writer.open(out.c_str(), format == "pcm", pcm)) {
+            fprintf(stderr, "%s\n", writer.error.c_str());
+            return 1;
+        }
+        ToneSynth synth(rate, tone, amplitude, std::min(riseMs, timing.dit));
+        auto sink = [&](const float* samples, size_t n) { writer.write(samples, n); };
+        auto element = [&](bool down, double ms) {
+            synth.key(down, ms, sink);
+            marks += down;
+            keyedMs += ms;
+        };
+        synth.key(false, leadMs, sink);
+        while (size_t got = fread(chunk.data(), 1, chunk.size(), in)) {
+            bytesIn += got;
+            encoder.encode(chunk.data(), got, element);
+            if (!writer.error.empty()) break;
+        }
+        synth.key(false, tailMs, sink);
+        synth.flush(sink);
+        if (!writer.close()) {
+            fprintf(stderr, "%s: %s\n", out.c_str(), writer.error.c_str());
+            return 1;
+        }
+        fprintf(stderr, "%llu samples at %u Hz (%.1f MB)\n", (unsigned long long)writer.frames, rate,
+                writer.frames * pcm.bytes_per_sample() / 1e6);
+    } else if (format == "trace") {
+        FILE* file = out == "-" ? stdout : fopen(out.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "cannot create %s\n", out.c_str());
+            return 1;
+        }
+        std::string text;
+        encoder.text = &text;
+        double endMs = 0; // keyed so far; lines are whole ms rounded from the running total, so they do not drift
+        uint64_t written = 0;
+        auto element = [&](bool down, double ms) {
+            endMs += ms;
+            uint64_t end = (uint64_t)llround(endMs);
+            fprintf(file, "%s %llu\n", down ? "press" : "gap", (unsigned long long)(end - written));
+            written = end;
+            marks += down;
+            keyedMs += ms;
+        };
+        fprintf(file, "# %s at %.1f WPM%s\n", paths[0].c_str(), wpm, farnsworth > 0 && farnsworth < wpm ? " (Farnsworth)" : "");
+        element(false, leadMs);
+        while (size_t got = fread(chunk.data(), 1, chunk.size(), in)) {
+            bytesIn += got;
+            encoder.encode(chunk.data(), got, element);
+        }
+        element(false, tailMs);
+        fprintf(file, "expect %s\n", text.c_str());
+        if ((file == stdout ? fflush(file) : fclose(file)) != 0) {
+            fprintf(stderr, "%s: write failed\n", out.c_str());
+            return 1;
+        }
+    } else {
+        KeyTraceWriter writer;
+        if (!writer.open(out.c_str(), tickUs)) {
+            fprintf(stderr, "%s\n", writer.error.c_str());
+            return 1;
+        }
+        std::string line, text, meta;
+        std::vector<uint64_t> edges;
+        char header[96];
+        snprintf(header, sizeof(header), "operator=encode\nwpm=%.1f\n", wpm);
+        uint64_t sessions = 0;
+        auto add_line = [&]() { // one session per line with letters in it
+            text.clear();
+            edges.clear();
+            encoder.reset();
+            encoder.text = &text;
+            double time = leadMs * 1000; // µs
+            encoder.encode(line.data(), line.size(), [&](bool down, double ms) {
+                if (down) edges.push_back((uint64_t)llround(time / tickUs));
+                time += ms * 1000;
+                if (down) edges.push_back((uint64_t)llround(time / tickUs));
+                marks += down;
+                keyedMs += ms;
+            });
+            line.clear();
+            if (text.empty()) return true;
+            meta = header;
+            if (farnsworth > 0 && farnsworth < wpm) meta += "farnsworth=" + std::to_string(farnsworth) + "\n";
+            meta += "text=" + text + "\n";
+            sessions++;
+            return writer.add_session(meta, edges, wpm);
+        };
+        bool good = true;
+        while (size_t got = fread(chunk.data(), 1, chunk.size(), in)) {
+            bytesIn += got;
+            for (size_t i = 0; i < got && good; i++) {
+                if (chunk[i] == '\n') good = add_line();
+                else line += chunk[i];
+            }
+        }
+        good = good && add_line() && writer.close();
+        if (!good) {
+            fprintf(stderr, "%s: %s\n", out.c_str(), writer.error.c_str());
+            return 1;
+        }
+        fprintf(stderr, "%llu sessions\n", (unsigned long long)sessions);
+    }
+    if (in != stdin) fclose(in);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "%llu letters, %llu marks, %llu characters skipped, %.1f h of keying\n", (unsigned long long)encoder.letters,
+            (unsigned long long)marks, (unsigned long long)encoder.skipped, keyedMs / 3.6e6);
+    fprintf(stderr, "%.2f s, %.1f MB/s of text, %.0fx real time\n", seconds, bytesIn / seconds / 1e6, keyedMs / 1000 / seconds);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef FFT_H
+#define FFT_H
+
+/*
+Iterative radix-2 complex FFT for the host tools. Twiddles and the bit-reversal permutation are
+computed once per size; 'forward' works in place and does no allocation, so one Fft can be shared
+read-only by many threads as long as each brings its own buffer.
+*/
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+class Fft { // Forward transform of a fixed power-of-two size.
+    public:
+    int size = 0;
+
+    // Sets the transform size, which must be a power of two.
+    explicit Fft(int n) : size(n), twiddle(n / 2), reversed(n) {
+        int bits = 0;
+        while ((1 << bits) < n) bits++;
+        for (int i = 0; i < n; i++) {
+            uint32_t r = 0;
+            for (int b = 0; b < bits; b++) r |= ((i >> b) & 1u) << (bits - 1 - b);
+            reversed[i] = r;
+        }
+        for (int k = 0; k < n / 2; k++) twiddle[k] = std::polar(1.0f, -2 * (float)M_PI * k / n);
+    }
+
+    static bool is_power_of_two(int n) {
+        return n > 1 && (n & (n - 1)) == 0;
+    }
+
+    // Replaces 'data' (size() values) by its discrete Fourier transform.
+    void forward(std::complex<float>* data) const {
+        for (int i = 0; i < size; i++) {
+            if ((int)reversed[i] > i) std::swap(data[i], data[reversed[i]]);
+        }
+        for (int half = 1, step = size / 2; half < size; half *= 2, step /= 2) {
+            for (int start = 0; start < size; start += 2 * half) {
+                for (int k = 0; k < half; k++) {
+                    std::complex<float> w = twiddle[k * step], x = data[start + k + half];
+                    std::complex<float> odd(w.real() * x.real() - w.imag() * x.imag(), w.real() * x.imag() + w.imag() * x.real()); // written out: operator* checks for NaN/inf
+                    data[start + k + half] = data[start + k] - odd;
+                    data[start + k] += odd;
+                }
+            }
+        }
+    }
+
+    private:
+    std::vector<std::complex<float>> twiddle; // e^(-2 pi i k / n) for k < n/2
+    std::vector<uint32_t> reversed; // bit-reversed index of every position
+};
+
+#endif // FFT_H
\ No newline at end of file
@@ -0,0 +1,138 @@
+#ifndef GOERTZEL_H
+#define GOERTZEL_H
+
+/*
+Goertzel filter bank: the power of a set of tone frequencies over a block of samples.
+
+The filters run side by side, one vector lane per filter, so every sample costs one multiply-add per
+lane group rather than per filter: 8 filters per instruction with AVX, 4 with SSE, with a scalar
+fallback elsewhere. The lane width is chosen at compile time (-mavx / -march=native).
+*/
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define GOERTZEL_LANES 8
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define GOERTZEL_LANES 4
+#else
+#define GOERTZEL_LANES 1
+#endif
+
+const int GOERTZEL_MAX_FILTERS = 64; // largest bank (a multiple of every lane width)
+
+class GoertzelBank { // Measures the power of up to GOERTZEL_MAX_FILTERS frequencies over blocks of samples.
+    public:
+    int count = 0; // filters in use
+    int padded = 0; // 'count' rounded up to a whole number of lanes
+    float frequency[GOERTZEL_MAX_FILTERS] = {}; // centre frequency of each filter (Hz)
+    alignas(32) float power[GOERTZEL_MAX_FILTERS] = {}; // result of the last block, normalised so a full scale tone gives ~0.25
+
+    // Spreads 'filters' filters evenly from 'lowHz' to 'highHz' (one filter sits at 'lowHz' if there is just one).
+    void configure(float sampleRate, int filters, float lowHz, float highHz) {
+        count = filters < 1 ? 1 : (filters > GOERTZEL_MAX_FILTERS ? GOERTZEL_MAX_FILTERS : filters);
+        padded = (count + GOERTZEL_LANES - 1) / GOERTZEL_LANES * GOERTZEL_LANES;
+        for (int i = 0; i < GOERTZEL_MAX_FILTERS; i++) {
+            float hz = count == 1 ? lowHz : lowHz + (highHz - lowHz) * i / (count - 1);
+            frequency[i] = i < count ? hz : 0;
+            coeff[i] = i < count ? 2 * cosf(2 * (float)M_PI * hz / sampleRate) : 0; // padding lanes stay at zero
+        }
+    }
+
+    // Runs every filter over a block of 'n' samples and stores the power of each in 'power'.
+    void process(const float* samples, size_t n) {
+#if GOERTZEL_LANES == 8
+        for (int f = 0; f < padded; f += 8) {
+            __m256 c = _mm256_load_ps(coeff + f);
+            __m256 s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps();
+            for (size_t i = 0; i < n; i++) {
+                __m256 s0 = _mm256_sub_ps(_mm256_add_ps(_mm256_set1_ps(samples[i]), _mm256_mul_ps(c, s1)), s2);
+                s2 = s1;
+                s1 = s0;
+            }
+            __m256 p = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(s1, s1), _mm256_mul_ps(s2, s2)), _mm256_mul_ps(c, _mm256_mul_ps(s1, s2)));
+            _mm256_store_ps(power + f, p);
+        }
+#elif GOERTZEL_LANES == 4
+        for (int f = 0; f < padded; f += 4) {
+            __m128 c = _mm_load_ps(coeff + f);
+            __m128 s1 = _mm_setzero_ps(), s2 = _mm_setzero_ps();
+            for (size_t i = 0; i < n; i++) {
+                __m128 s0 = _mm_sub_ps(_mm_add_ps(_mm_set1_ps(samples[i]), _mm_mul_ps(c, s1)), s2);
+                s2 = s1;
+                s1 = s0;
+            }
+            __m128 p = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(s1, s1), _mm_mul_ps(s2, s2)), _mm_mul_ps(c, _mm_mul_ps(s1, s2)));
+            _mm_store_ps(power + f, p);
+        }
+#else
+        for (int f = 0; f < padded; f++) {
+            float s1 = 0, s2 = 0;
+            for (size_t i = 0; i < n; i++) {
+                float s0 = samples[i] + coeff[f] * s1 - s2;
+                s2 = s1;
+                s1 = s0;
+            }
+            power[f] = s1 * s1 + s2 * s2 - coeff[f] * s1 * s2;
+        }
+#endif
+        float scale = n ? 1.0f / ((float)n * n) : 0; // independent of the block length
+        for (int f = 0; f < padded; f++) power[f] *= scale;
+    }
+
+    private:
+    alignas(32) float coeff[GOERTZEL_MAX_FILTERS] = {}; // 2cos(2 pi f / fs) of each filter
+};
+
+class ToneKey { // Turns the filter bank's output into key up/down with an adaptive threshold, following the strongest tone.
+    public:
+    bool down = false; // current key state
+    int lockedFilter = -1; // filter the tone was found in, -1 until one stands out
+    float level = 0; // magnitude of the tone in the last block
+    float peak = 0; // recent tone level (follows rises at once, decays slowly)
+    float floor = -1; // average level while the key is up (noise), -1 before the first block
+    float decay = 0.002f; // fraction the trackers move per block (set from the block length)
+    float minimumSnr = 3; // peak/floor ratio below which everything is treated as noise
+    int holdBlocks = 2; // blocks a new state has to last before it is reported (drops noise spikes and fades; every edge is delayed alike)
+
+    // Updates the key state from one block of filter powers. Returns true if the state changed.
+    bool update(const GoertzelBank& bank) {
+        return update(bank.power, bank.count);
+    }
+
+    // Same for the powers of any 'count' (<= GOERTZEL_MAX_FILTERS) neighbouring frequencies, e.g. FFT bins.
+    bool update(const float* power, int count) {
+        for (int f = 0; f < count; f++) { // slow average per filter, to find the tone without jumping to noise bursts
+            average[f] += (power[f] - average[f]) * decay * 4;
+            if (lockedFilter < 0 || average[f] > average[lockedFilter]) lockedFilter = f;
+        }
+        level = sqrtf(power[lockedFilter]);
+        peak = level > peak ? level : peak + (level - peak) * decay;
+        if (floor < 0) floor = level;
+        else if (!raw) floor += (level - floor) * decay * 8; // noise is only measured between elements
+
+        float span = peak - floor;
+        bool tone = raw; // level after hysteresis: on at 50%, off at 35% of the way from noise to peak
+        if (peak < floor * minimumSnr) tone = false; // no tone to speak of
+        else if (!raw && level > floor + 0.5f * span) tone = true;
+        else if (raw && level < floor + 0.35f * span) tone = false;
+        if (tone != raw) {
+            raw = tone;
+            held = 0;
+        }
+        if (raw == down || ++held < holdBlocks) return false;
+        down = raw;
+        return true;
+    }
+
+    private:
+    bool raw = false; // state before the hold-off
+    int held = 0; // blocks 'raw' has kept its current value
+    float average[GOERTZEL_MAX_FILTERS] = {}; // long-term power per filter
+};
+
+#endif // GOERTZEL_H
\ No newline at end of file
@@ -0,0 +1,133 @@
+#ifndef KEY_DECODER_H
+#define KEY_DECODER_H
+
+/*
+The firmware's Button -> Decoder path driven by timestamped key levels instead of millis() and
+digitalRead(). Unlike Simulation (simulation.h) it touches no global state, so any number of them
+can run side by side on different threads: one per channel in the skimmer, one per session in the
+corpus tools.
+
+Key levels go through the firmware's tick debouncer (tick_debouncer.h) before the button sees
+them. Between calls it runs the decoder at the moments the firmware would have noticed something
+(debouncer ticks and decoder deadlines), so the result matches the firmware ticked every ms.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include "../../lib/button.h"
+#include "../../lib/decoder.h"
+#include "../../lib/word_corrector.h"
+#include "tick_debouncer.h"
+
+class KeyDecoder { // Decodes a stream of key levels with its own button and decoder.
+    public:
+    Button button;
+    Decoder decoder;
+    std::string text; // letters and word gaps decoded so far (emptied when the display would be cleared)
+    uint64_t edges = 0; // edges accepted by the button
+    uint64_t letters = 0;
+    uint64_t invalid = 0; // patterns that matched no letter
+    uint64_t now = 0; // time of the last call (ms)
+    WordCorrector* corrector = nullptr; // if set, words are corrected at the word gap as on the device with MORSE_WORD_CORRECTION
+    uint64_t corrections = 0; // words the corrector replaced
+    unsigned int mostVisited = 0; // most word list edges one correction looked at
+
+    KeyDecoder() : decoder(button.properties()), debouncer(1) {}
+
+    // The key is at 'pressed' from 'time' (ms, not before the previous call) on.
+    void key(uint64_t time, bool pressed) {
+        advance_to(time);
+        debouncer.set(time, pressed ? 1 : 0);
+    }
+
+    // Runs everything that falls due before 'time' without a change of the key.
+    void advance_to(uint64_t time) {
+        uint64_t next;
+        while (next_wakeup(next) && next < time) {
+            now = next;
+            wake();
+        }
+        now = time;
+    }
+
+    // Releases the key at 'time' and lets the last letter and word finish within 'tailMs'.
+    void finish(uint64_t time, uint64_t tailMs) {
+        key(time, false);
+        advance_to(time + tailMs);
+    }
+
+    private:
+    TickDebouncer debouncer; // the key on line 0
+    size_t wordStart = 0; // where the current word starts in 'text'
+
+    // Replaces the word just finished by the corrector's proposal, if it has one.
+    void end_word() {
+        char corrected[MAX_WORD_LETTERS + 3];
+        if (corrector->correct(corrected)) {
+            text.replace(wordStart, std::string::npos, corrected);
+            corrections++;
+        }
+        mostVisited = std::max(mostVisited, corrector->visited);
+        corrector->reset();
+    }
+
+    // Hands the button's edge (or none) to the decoder and collects what it decoded.
+    void step(ButtonEdge edge) {
+        if (edge != EDGE_NONE) edges++;
+        decoder.update(edge, now);
+        DecoderEvent event;
+        while (decoder.next_event(event)) {
+            switch (event.type) {
+                case DECODED_LETTER:
+                    letters++;
+                    text += event.letter;
+                    if (corrector) corrector->add_letter(event.letter, event.pattern);
+                    break;
+                case DECODED_WORD_GAP:
+                    if (corrector) end_word();
+                    text += event.letter;
+                    wordStart = text.size();
+                    break;
+                case DECODED_INVALID:
+                    invalid++;
+                    if (corrector) corrector->add_letter('?', event.pattern);
+                    break;
+                case DECODED_CLEAR:
+                    text.clear();
+                    wordStart = 0;
+                    if (corrector) corrector->reset();
+                    break;
+            }
+        }
+    }
+
+    // Runs the tick due at 'now', if any, and hands its edge (or none) to the decoder.
+    void wake() {
+        bool stepped = false;
+        if (debouncer.pending() && debouncer.next_tick() == now) {
+            debouncer.tick();
+            PortEdge edge;
+            while (debouncer.port.edges.pop(edge)) { // as key capture: the edge keeps the time the key settled
+                step(button.check_press((edge.levels & 1) != 0, edge.time));
+                stepped = true;
+            }
+        }
+        if (!stepped) step(EDGE_NONE);
+    }
+
+    // Sets 'next' to the next time from 'now' on at which the firmware would see a change. Returns false if nothing is pending.
+    bool next_wakeup(uint64_t& next) {
+        uint64_t deadline = decoder.next_deadline();
+        bool found = deadline > now;
+        next = deadline;
+        if (debouncer.pending() && (!found || debouncer.next_tick() < next)) {
+            next = debouncer.next_tick();
+            found = true;
+        }
+        return found;
+    }
+};
+
+#endif // KEY_DECODER_H
\ No newline at end of file
@@ -0,0 +1,342 @@
+#ifndef KEY_TRACE_H
+#define KEY_TRACE_H
+
+/*
+Binary key-timing trace files (.ktr): many recorded sessions of key edges with their metadata.
+
+All integers are little endian. Layout:
+
+    header (32 bytes)
+        0  char[4] magic "KTRC"
+        4  u16     version (1)
+        6  u16     header size (32)
+        8  u32     tick length in microseconds (1000 for the firmware's millis())
+        12 u32     session count
+        16 u64     offset of the index
+        24 u64     reserved (0)
+    sessions, each:
+        metadata   "key=value\n" lines (operator, wpm, text, source, ...), UTF-8
+        edges      one unsigned LEB128 varint per edge: ticks since the previous edge (the first
+                   counts from the start of the session). Edges alternate, starting with a press.
+    index (48 bytes per session)
+        0  u64     metadata offset
+        8  u32     metadata bytes
+        12 u32     edge count
+        16 u64     edges offset
+        24 u64     edges bytes
+        32 u64     duration (ticks up to the last edge)
+        40 u16     WPM x 10 (0 if unknown), copied from the metadata for quick bucketing
+        42 u16     flags (0)
+        44 u32     reserved (0)
+
+Typical keying needs 1-2 bytes per edge. KeyTraceFile maps the file read-only and hands out
+sessions whose edges are decoded straight from the mapping, so nothing is copied or parsed ahead.
+tools/key_trace.py reads and writes the same format.
+*/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+const char KEY_TRACE_MAGIC[4] = { 'K', 'T', 'R', 'C' };
+const uint16_t KEY_TRACE_VERSION = 1;
+const uint32_t KEY_TRACE_HEADER_SIZE = 32;
+const uint32_t KEY_TRACE_INDEX_ENTRY_SIZE = 48;
+
+struct KeyEdge { // A single edge of a session.
+    uint64_t time; // ticks since the start of the session
+    bool pressed; // level of the key after the edge
+};
+
+struct KeyTraceSessionInfo { // Index entry of a session.
+    uint64_t metaOffset;
+    uint32_t metaBytes;
+    uint32_t edgeCount;
+    uint64_t edgesOffset;
+    uint64_t edgesBytes;
+    uint64_t durationTicks;
+    uint16_t wpmTenths;
+};
+
+inline uint64_t key_trace_read_le(const uint8_t* p, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) value = value << 8 | p[i];
+    return value;
+}
+
+inline void key_trace_write_le(std::vector<uint8_t>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out.push_back((uint8_t)(value >> (8 * i)));
+}
+
+inline void key_trace_write_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+class KeyEdgeCursor { // Iterates the edges of a session straight from the mapped file.
+    public:
+    KeyEdgeCursor(const uint8_t* data, const uint8_t* end, uint32_t count) : data(data), end(end), left(count) {}
+
+    // Decodes the next edge into 'edge'. Returns false after the last one (or on a truncated stream).
+    bool next(KeyEdge& edge) {
+        if (left == 0) return false;
+        uint64_t delta = 0;
+        int shift = 0;
+        while (true) {
+            if (data == end || shift > 63) return false;
+            uint8_t byte = *data++;
+            delta |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+            shift += 7;
+        }
+        time += delta;
+        edge.time = time;
+        edge.pressed = pressed;
+        pressed = !pressed;
+        left--;
+        return true;
+    }
+
+    private:
+    const uint8_t* data; // next varint
+    const uint8_t* end; // end of the session's edge bytes
+    uint32_t left; // edges not decoded yet
+    uint64_t time = 0;
+    bool pressed = true; // level of the next edge
+};
+
+class KeyTraceSession { // View of one session inside a mapped file.
+    public:
+    KeyTraceSessionInfo info;
+    const char* meta = nullptr; // metadata text (not NUL terminated)
+    const uint8_t* edgeData = nullptr;
+
+    KeyEdgeCursor edges() const {
+        return KeyEdgeCursor(edgeData, edgeData + info.edgesBytes, info.edgeCount);
+    }
+
+    // Value of a metadata key, or 'fallback' if it is not there.
+    std::string get(const char* key, const char* fallback = "") const {
+        size_t keyLength = strlen(key);
+        const char* p = meta;
+        const char* end = meta + info.metaBytes;
+        while (p < end) {
+            const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+            if (!lineEnd) lineEnd = end;
+            if ((size_t)(lineEnd - p) > keyLength && memcmp(p, key, keyLength) == 0 && p[keyLength] == '=') {
+                return std::string(p + keyLength + 1, lineEnd);
+            }
+            p = lineEnd + 1;
+        }
+        return fallback;
+    }
+
+    double wpm() const {
+        return info.wpmTenths / 10.0;
+    }
+};
+
+class KeyTraceFile { // A .ktr file mapped read-only.
+    public:
+    std::string error; // why 'open' failed
+    uint32_t tickUs = 1000;
+    uint32_t sessionCount = 0;
+    size_t size = 0; // bytes mapped
+
+    ~KeyTraceFile() {
+        close();
+    }
+
+    bool open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return fail(std::string("cannot open ") + path);
+        struct stat status;
+        if (fstat(fd, &status) != 0 || status.st_size < (off_t)KEY_TRACE_HEADER_SIZE) {
+            ::close(fd);
+            return fail("file too short for a header");
+        }
+        size = (size_t)status.st_size;
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping stays valid
+        if (mapped == MAP_FAILED) {
+            size = 0;
+            return fail("mmap failed");
+        }
+        data = (const uint8_t*)mapped;
+        madvise(mapped, size, MADV_SEQUENTIAL);
+
+        if (memcmp(data, KEY_TRACE_MAGIC, 4) != 0) return fail("not a key trace file");
+        if (key_trace_read_le(data + 4, 2) != KEY_TRACE_VERSION) return fail("unsupported key trace version");
+        uint32_t headerSize = (uint32_t)key_trace_read_le(data + 6, 2);
+        tickUs = (uint32_t)key_trace_read_le(data + 8, 4);
+        sessionCount = (uint32_t)key_trace_read_le(data + 12, 4);
+        indexOffset = key_trace_read_le(data + 16, 8);
+        if (headerSize < KEY_TRACE_HEADER_SIZE || tickUs == 0 || indexOffset > size ||
+            (size - indexOffset) / KEY_TRACE_INDEX_ENTRY_SIZE < sessionCount) {
+            return fail("corrupt header");
+        }
+        for (uint32_t i = 0; i < sessionCount; i++) { // checks every session lies inside the file
+            KeyTraceSessionInfo s = info(i);
+            if (s.metaOffset > size || s.metaBytes > size - s.metaOffset || s.edgesOffset > size || s.edgesBytes > size - s.edgesOffset) {
+                return fail("session " + std::to_string(i) + " points outside the file");
+            }
+        }
+        return true;
+    }
+
+    void close() {
+        if (data) munmap((void*)data, size);
+        data = nullptr;
+        size = 0;
+        sessionCount = 0;
+    }
+
+    KeyTraceSession session(uint32_t i) const {
+        KeyTraceSession s;
+        s.info = info(i);
+        s.meta = (const char*)data + s.info.metaOffset;
+        s.edgeData = data + s.info.edgesOffset;
+        return s;
+    }
+
+    // Converts ticks to milliseconds.
+    double ms(uint64_t ticks) const {
+        return ticks * (tickUs / 1000.0);
+    }
+
+    private:
+    const uint8_t* data = nullptr;
+    uint64_t indexOffset = 0;
+
+    KeyTraceSessionInfo info(uint32_t i) const {
+        const uint8_t* p = data + indexOffset + (uint64_t)i * KEY_TRACE_INDEX_ENTRY_SIZE;
+        KeyTraceSessionInfo s;
+        s.metaOffset = key_trace_read_le(p, 8);
+        s.metaBytes = (uint32_t)key_trace_read_le(p + 8, 4);
+        s.edgeCount = (uint32_t)key_trace_read_le(p + 12, 4);
+        s.edgesOffset = key_trace_read_le(p + 16, 8);
+        s.edgesBytes = key_trace_read_le(p + 24, 8);
+        s.durationTicks = key_trace_read_le(p + 32, 8);
+        s.wpmTenths = (uint16_t)key_trace_read_le(p + 40, 2);
+        return s;
+    }
+
+    bool fail(const std::string& reason) {
+        error = reason;
+        close();
+        return false;
+    }
+};
+
+class KeyTraceWriter { // Writes a .ktr file one session at a time; the index is written by 'close'.
+    public:
+    std::string error;
+
+    ~KeyTraceWriter() {
+        close();
+    }
+
+    bool open(const char* path, uint32_t tickUs = 1000) {
+        file = fopen(path, "wb");
+        if (!file) {
+            error = std::string("cannot create ") + path;
+            return false;
+        }
+        this->tickUs = tickUs;
+        offset = 0;
+        index.clear();
+        write_header(0); // rewritten with the real index offset at the end
+        return true;
+    }
+
+    // Appends a session. 'meta' holds "key=value\n" lines; 'wpm' (0 if unknown) goes into the index as well.
+    // Edge times are in ticks, ascending, alternating press/release starting with a press.
+    bool add_session(const std::string& meta, const std::vector<uint64_t>& edgeTimes, double wpm) {
+        std::vector<uint8_t> edges;
+        edges.reserve(edgeTimes.size() * 2);
+        uint64_t previous = 0;
+        for (uint64_t time : edgeTimes) {
+            if (time < previous) {
+                error = "edge times go backwards";
+                return false;
+            }
+            key_trace_write_varint(edges, time - previous);
+            previous = time;
+        }
+        KeyTraceSessionInfo s;
+        s.metaOffset = offset;
+        s.metaBytes = (uint32_t)meta.size();
+        s.edgeCount = (uint32_t)edgeTimes.size();
+        s.edgesOffset = offset + meta.size();
+        s.edgesBytes = edges.size();
+        s.durationTicks = previous;
+        s.wpmTenths = (uint16_t)(wpm > 0 ? wpm * 10 + 0.5 : 0);
+        write(meta.data(), meta.size());
+        write(edges.data(), edges.size());
+        index.push_back(s);
+        return true;
+    }
+
+    // Writes the index and the final header. Returns false if anything failed to write.
+    bool close() {
+        if (!file) return error.empty();
+        uint64_t indexOffset = offset;
+        std::vector<uint8_t> out;
+        for (const KeyTraceSessionInfo& s : index) {
+            key_trace_write_le(out, s.metaOffset, 8);
+            key_trace_write_le(out, s.metaBytes, 4);
+            key_trace_write_le(out, s.edgeCount, 4);
+            key_trace_write_le(out, s.edgesOffset, 8);
+            key_trace_write_le(out, s.edgesBytes, 8);
+            key_trace_write_le(out, s.durationTicks, 8);
+            key_trace_write_le(out, s.wpmTenths, 2);
+            key_trace_write_le(out, 0, 2);
+            key_trace_write_le(out, 0, 4);
+        }
+        write(out.data(), out.size());
+        fseek(file, 0, SEEK_SET);
+        write_header(indexOffset);
+        bool ok = fclose(file) == 0 && !failed;
+        file = nullptr;
+        if (!ok && error.empty()) error = "write failed";
+        return ok;
+    }
+
+    private:
+    FILE* file = nullptr;
+    uint32_t tickUs = 1000;
+    uint64_t offset = 0; // bytes written so far
+    bool failed = false;
+    std::vector<KeyTraceSessionInfo> index;
+
+    void write(const void* bytes, size_t count) {
+        if (count && fwrite(bytes, 1, count, file) != count) failed = true;
+        offset += count;
+    }
+
+    void write_header(uint64_t indexOffset) {
+        std::vector<uint8_t> header(KEY_TRACE_MAGIC, KEY_TRACE_MAGIC + 4);
+        key_trace_write_le(header, KEY_TRACE_VERSION, 2);
+        key_trace_write_le(header, KEY_TRACE_HEADER_SIZE, 2);
+        key_trace_write_le(header, tickUs, 4);
+        key_trace_write_le(header, index.size(), 4);
+        key_trace_write_le(header, indexOffset, 8);
+        key_trace_write_le(header, 0, 8);
+        if (fwrite(header.data(), 1, header.size(), file) != header.size()) failed = true;
+        if (indexOffset == 0) offset = header.size();
+    }
+};
+
+#endif // KEY_TRACE_H
\ No newline at end of file
@@ -0,0 +1,201 @@
+/*
+Generates synthetic keying as a binary key trace file (key_trace.h), built for the host by the
+'keygen' environment:
+    pio run -e keygen && .pio/build/keygen/program synthetic.ktr --sessions 1000 --wpm 15-40 --jitter 0.05-0.3
+
+Every session is one operator (a KeyingStyle, keying_model.h) sending random words, or the --text
+given, with its ground truth in the metadata, so the output feeds the corpus report, the tuning sweep
+and 'traces replay' directly. Options that take A-B draw a value per session uniformly from that
+range; a single number fixes it.
+
+Options:
+    --sessions N        sessions to write (default 100)
+    --words N           words per session (default 20)
+    --text TEXT         send this text in every session instead of random words
+    --text-file FILE    draw the random words from this file instead of the built-in list
+    --wpm A-B           character speed (default 20)
+    --farnsworth A-B    overall speed with stretched letter and word gaps (default none)
+    --dah A-B           dah length in units (default 3)
+    --gap A-B           element gap in units (default 1)
+    --jitter A-B        timing jitter in units, standard deviation (default 0.1)
+    --heavy             Student-t jitter instead of Gaussian
+    --drift X           speed drift per letter, standard deviation relative to the speed (default 0)
+    --bounce P          probability that an edge bounces (default 0)
+    --bounce-ms X       bounces end this long after the edge (default 3)
+    --tick-us N         trace resolution in microseconds (default 1000, the firmware's millis())
+    --seed N            random seed (default 1)
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "key_trace.h"
+#include "keying_model.h"
+
+const double LEAD_IN_MS = 500; // key up before the first edge of a session
+
+const char* DEFAULT_WORDS = // plain-language and on-air words, every letter represented
+    "THE OF AND TO IN IS YOU THAT IT HE WAS FOR ON ARE AS WITH HIS THEY AT BE THIS HAVE FROM OR ONE HAD BY WORD "
+    "BUT NOT WHAT ALL WERE WE WHEN YOUR CAN SAID THERE USE EACH WHICH SHE DO HOW THEIR IF WILL UP OTHER ABOUT OUT "
+    "MANY THEN THEM THESE SO SOME HER WOULD MAKE LIKE HIM INTO TIME HAS LOOK TWO MORE WRITE GO SEE NUMBER NO WAY "
+    "COULD PEOPLE MY THAN FIRST WATER BEEN CALL WHO OIL NOW FIND LONG DOWN DAY DID GET COME MADE MAY PART QUICK "
+    "BROWN FOX JUMPS OVER LAZY DOG CQ DE QTH QSL QRZ QRM QSB RST NAME RIG ANT WX HR TNX FER PSE KN SK GM GE ES "
+    "OM YL BK AGN ZERO JAZZ QUIZ KAYAK VEX";
+
+struct Range { // A per-session parameter: fixed or drawn uniformly from [low, high].
+    double low, high;
+
+    double draw(KeyingRandom& random) const {
+        return low + (high - low) * random.uniform();
+    }
+};
+
+Range parse_range(const char* text) {
+    Range range;
+    char* end;
+    range.low = range.high = strtod(text, &end);
+    if (*end == '-') range.high = strtod(end + 1, &end);
+    if (*end || range.high < range.low) {
+        fprintf(stderr, "bad range '%s' (use N or A-B)\n", text);
+        exit(2);
+    }
+    return range;
+}
+
+std::vector<std::string> split_words(const std::string& text) {
+    std::vector<std::string> words;
+    std::string word;
+    for (char c : text + " ") {
+        if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+        if (c >= 'A' && c <= 'Z') word += c;
+        else if (!word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+    return words;
+}
+
+void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s OUT.ktr [--sessions N] [--words N] [--text TEXT | --text-file FILE] [--wpm A-B] [--farnsworth A-B]\n"
+            "       [--dah A-B] [--gap A-B] [--jitter A-B] [--heavy] [--drift X] [--bounce P] [--bounce-ms X] [--tick-us N] [--seed N]\n",
+            program);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    const char* out = nullptr;
+    long sessions = 100, wordsPerSession = 20;
+    std::string text, textFile;
+    Range wpm = { 20, 20 }, farnsworth = { 0, 0 }, dah = { 3, 3 }, gap = { 1, 1 }, jitter = { 0.1, 0.1 };
+    KeyingStyle base;
+    uint32_t tickUs = 1000;
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool more = i + 1 < argc;
+        if (arg == "--sessions" && more) sessions = atol(argv[++i]);
+        else if (arg == "--words" && more) wordsPerSession = atol(argv[++i]);
+        else if (arg == "--text" && more) text = argv[++i];
+        else if (arg == "--text-file" && more) textFile = argv[++i];
+        else if (arg == "--wpm" && more) wpm = parse_range(argv[++i]);
+        else if (arg == "--farnsworth" && more) farnsworth = parse_range(argv[++i]);
+        else if (arg == "--dah" && more) dah = parse_range(argv[++i]);
+        else if (arg == "--gap" && more) gap = parse_range(argv[++i]);
+        else if (arg == "--jitter" && more) jitter = parse_range(argv[++i]);
+        else if (arg == "--heavy") base.heavyTails = true;
+        else if (arg == "--drift" && more) base.drift = atof(argv[++i]);
+        else if (arg == "--bounce" && more) base.bounceProbability = atof(argv[++i]);
+        else if (arg == "--bounce-ms" && more) base.bounceMs = atof(argv[++i]);
+        else if (arg == "--tick-us" && more) tickUs = (uint32_t)atol(argv[++i]);
+        else if (arg == "--seed" && more) seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg[0] == '-') usage(argv[0]);
+        else if (!out) out = argv[i];
+        else usage(argv[0]);
+    }
+    if (!out || sessions <= 0 || wordsPerSession <= 0 || wpm.low <= 0 || tickUs == 0) usage(argv[0]);
+
+    std::vector<std::string> words;
+    if (!textFile.empty()) {
+        std::ifstream file(textFile);
+        if (!file) {
+            fprintf(stderr, "cannot open %s\n", textFile.c_str());
+            return 1;
+        }
+        std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        words = split_words(content);
+    } else {
+        words = split_words(DEFAULT_WORDS);
+    }
+    if (words.empty() && split_words(text).empty()) {
+        fprintf(stderr, "no words to send\n");
+        return 1;
+    }
+    std::string fixedText; // --text normalised the way the decoder prints it
+    for (const std::string& word : split_words(text)) fixedText += (fixedText.empty() ? "" : " ") + word;
+
+    KeyTraceWriter writer;
+    if (!writer.open(out, tickUs)) {
+        fprintf(stderr, "%s\n", writer.error.c_str());
+        return 1;
+    }
+    KeyingRandom random(seed); // draws the operators and their words
+    KeyingModel model(base, seed ^ 0x5DEECE66Dull); // draws the timing
+    std::vector<uint64_t> edges;
+    std::string sent, meta;
+    uint64_t characters = 0, edgeCount = 0;
+    double keyedUs = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long s = 0; s < sessions; s++) {
+        KeyingStyle& style = model.style;
+        style.wpm = wpm.draw(random);
+        style.farnsworthWpm = farnsworth.draw(random);
+        style.dahUnits = dah.draw(random);
+        style.elementGapUnits = gap.draw(random);
+        style.jitter = jitter.draw(random);
+
+        sent = fixedText;
+        if (sent.empty()) {
+            for (long w = 0; w < wordsPerSession; w++) {
+                if (w) sent += ' ';
+                sent += words[(size_t)(random.uniform() * words.size())];
+            }
+        }
+        edges.clear();
+        double endUs = model.send(sent, edges, LEAD_IN_MS * 1000);
+        for (uint64_t& edge : edges) edge /= tickUs;
+
+        char line[160];
+        snprintf(line, sizeof(line), "operator=keygen-%ld\nwpm=%.1f\ndah=%.2f\ngap=%.2f\njitter=%.3f%s\n", s, style.wpm, style.dahUnits,
+                 style.elementGapUnits, style.jitter, style.heavyTails ? " student-t" : "");
+        meta = line;
+        if (style.farnsworthWpm > 0 && style.farnsworthWpm < style.wpm) {
+            snprintf(line, sizeof(line), "farnsworth=%.1f\n", style.farnsworthWpm);
+            meta += line;
+        }
+        meta += "text=" + sent + "\n";
+        if (!writer.add_session(meta, edges, style.wpm)) {
+            fprintf(stderr, "%s\n", writer.error.c_str());
+            return 1;
+        }
+        characters += sent.size();
+        edgeCount += edges.size();
+        keyedUs += endUs;
+    }
+    if (!writer.close()) {
+        fprintf(stderr, "%s: %s\n", out, writer.error.c_str());
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("wrote %ld sessions to %s: %llu characters, %llu edges, %.1f h of keying\n", sessions, out, (unsigned long long)characters,
+           (unsigned long long)edgeCount, keyedUs / 3.6e9);
+    printf("%.2f s, %.2f M characters/s, %.1f M edges/s\n", seconds, characters / seconds / 1e6, edgeCount / seconds / 1e6);
+    return 0;
+}
\ No newline at end of file
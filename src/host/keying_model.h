@@ -0,0 +1,191 @@
+#ifndef KEYING_MODEL_H
+#define KEYING_MODEL_H
+
+/*
+Synthetic straight-key keying: turns text into key edge times the way a human operator would send
+it, for load and accuracy tests where recorded keying is missing (high speeds, sloppy fists).
+
+Timing starts from the standard units (dit 1, dah 3, element gap 1, letter gap 3, word gap 7 at
+1200/WPM ms per unit) and is then bent per operator and per element:
+    Farnsworth      letters at the character speed, letter and word gaps stretched to an overall
+                    slower speed (ARRL formula)
+    weighting       the operator's dah length and element gap in units (e.g. a heavy fist keys
+                    dahs at 3.5 and closes gaps to 0.8)
+    jitter          added to every element and gap, in units: Gaussian, or Student-t with 3 degrees
+                    of freedom for the occasional badly timed element (same variance)
+    drift           the speed wanders from letter to letter, a random walk pulled back to the base
+    bounce          extra short open/close pairs right after an edge, as a worn contact produces
+
+Letters come from the firmware's pattern table (lib/morse_code.h); characters it does not have are
+skipped. Edge times are in microseconds from the start of the session.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../../lib/morse_code.h"
+
+class KeyingRandom { // xoshiro256** with Gaussian and Student-t draws; fast enough to never be the bottleneck.
+    public:
+    explicit KeyingRandom(uint64_t seed) {
+        for (uint64_t& word : state) { // splitmix64 spreads the seed over the state
+            seed += 0x9E3779B97F4A7C15ull;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotate(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotate(state[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, 1).
+    double uniform() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Standard normal (Marsaglia's polar method, the second value is kept for the next call).
+    double gaussian() {
+        if (haveSpare) {
+            haveSpare = false;
+            return spare;
+        }
+        double u, v, s;
+        do {
+            u = 2 * uniform() - 1;
+            v = 2 * uniform() - 1;
+            s = u * u + v * v;
+        } while (s >= 1 || s == 0);
+        double scale = std::sqrt(-2 * std::log(s) / s);
+        spare = v * scale;
+        haveSpare = true;
+        return u * scale;
+    }
+
+    // Student-t with 3 degrees of freedom, scaled to unit variance.
+    double heavy() {
+        double z = gaussian();
+        double chi = 0;
+        for (int i = 0; i < 3; i++) {
+            double g = gaussian();
+            chi += g * g;
+        }
+        return z / std::sqrt(chi / 3) / std::sqrt(3.0);
+    }
+
+    private:
+    uint64_t state[4];
+    double spare = 0;
+    bool haveSpare = false;
+
+    static uint64_t rotate(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+struct KeyingStyle { // How one operator sends.
+    double wpm = 20; // character speed
+    double farnsworthWpm = 0; // overall speed with stretched gaps, 0 (or >= wpm) for none
+    double dahUnits = 3; // length of a dah
+    double elementGapUnits = 1; // gap between the elements of a letter
+    double jitter = 0.1; // standard deviation added to every element and gap, in units
+    bool heavyTails = false; // Student-t instead of Gaussian jitter
+    double drift = 0; // standard deviation of the speed's step per letter, as a fraction of the base speed
+    double bounceProbability = 0; // chance that an edge bounces
+    double bounceMs = 3; // bounces end this long after the edge
+};
+
+class KeyingModel { // Sends text with a KeyingStyle; one instance per thread.
+    public:
+    KeyingStyle style;
+
+    KeyingModel(const KeyingStyle& style, uint64_t seed) : style(style), random(seed) {
+        for (int i = 0; i < 26; i++) { // element lengths in units, straight from the firmware's table
+            for (int j = 0; validPatterns[i][j]; j++) elements[i].push_back(validPatterns[i][j] == '1');
+        }
+    }
+
+    // Appends the edges of 'text' to 'edges' (µs, alternating press/release starting with a press), starting at 'startUs'. Returns the end time.
+    double send(const std::string& text, std::vector<uint64_t>& edges, double startUs = 0) {
+        double unit = 1.2e6 / style.wpm; // µs
+        double letterGap = 3 * unit, wordGap = 7 * unit;
+        if (style.farnsworthWpm > 0 && style.farnsworthWpm < style.wpm) {
+            double c = style.wpm, s = style.farnsworthWpm;
+            double delay = (60 * c - 37.2 * s) / (s * c) * 1e6; // µs of extra spacing per word, spread over 19 units
+            letterGap = 3 * delay / 19;
+            wordGap = 7 * delay / 19;
+        }
+        double speed = 1; // drift factor on the unit
+        double time = startUs;
+        bool first = true; // no gap before the first letter
+        bool space = false; // a word gap is due before the next letter
+        for (char c : text) {
+            if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+            if (c == ' ') {
+                space = !first;
+                continue;
+            }
+            if (c < 'A' || c > 'Z') continue;
+            if (style.drift > 0) { // random walk of the speed, pulled back towards the base speed
+                speed += style.drift * random.gaussian() - 0.1 * (speed - 1);
+                if (speed < 0.5) speed = 0.5;
+                if (speed > 2) speed = 2;
+            }
+            double u = unit * speed;
+            if (!first) time += duration(space ? wordGap * speed : letterGap * speed, u);
+            first = space = false;
+            const std::vector<bool>& pattern = elements[c - 'A'];
+            for (size_t i = 0; i < pattern.size(); i++) {
+                if (i) time += duration(style.elementGapUnits * u, u);
+                double length = duration((pattern[i] ? style.dahUnits : 1) * u, u);
+                edge(edges, time, u);
+                time += length;
+                edge(edges, time, u);
+            }
+        }
+        return time;
+    }
+
+    private:
+    KeyingRandom random;
+    std::vector<bool> elements[26]; // true for a dah
+
+    // A nominal duration with jitter, never shorter than a quarter unit.
+    double duration(double nominal, double unit) {
+        double noise = style.jitter > 0 ? style.jitter * (style.heavyTails ? random.heavy() : random.gaussian()) : 0;
+        double value = nominal + noise * unit;
+        return value < unit / 4 ? unit / 4 : value;
+    }
+
+    // Appends an edge, followed by bounces if the contact chatters. They stay within an eighth of a unit, well before the next edge.
+    void edge(std::vector<uint64_t>& edges, double time, double unit) {
+        edges.push_back((uint64_t)time);
+        if (style.bounceProbability <= 0 || random.uniform() >= style.bounceProbability) return;
+        double window = std::min(style.bounceMs * 1000, unit / 8);
+        int bounces = 1 + (int)(random.uniform() * 3); // 1-3 open/close pairs
+        double t = time;
+        for (int i = 0; i < bounces; i++) {
+            double a = t + random.uniform() * (time + window - t) / 2;
+            double b = a + random.uniform() * (time + window - a) / 2;
+            if ((uint64_t)a <= edges.back() || (uint64_t)b <= (uint64_t)a) break; // no room left at this resolution
+            edges.push_back((uint64_t)a);
+            edges.push_back((uint64_t)b);
+            t = b;
+        }
+    }
+};
+
+#endif // KEYING_MODEL_H
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Levenshtein distance between the expected and the decoded text (insertions, deletions and
+// substitutions all cost 1). Divided by the expected length this is the character error rate.
+inline size_t edit_distance(const std::string& expected, const std::string& decoded) {
+    std::vector<size_t> row(decoded.size() + 1); // distances for the previous prefix of 'expected'
+    for (size_t j = 0; j <= decoded.size(); j++) row[j] = j;
+    for (size_t i = 1; i <= expected.size(); i++) {
+        size_t diagonal = row[0]; // row[i-1][j-1]
+        row[0] = i;
+        for (size_t j = 1; j <= decoded.size(); j++) {
+            size_t above = row[j]; // row[i-1][j]
+            size_t substitution = diagonal + (expected[i - 1] != decoded[j - 1]);
+            row[j] = std::min({ above + 1, row[j - 1] + 1, substitution });
+            diagonal = above;
+        }
+    }
+    return row[decoded.size()];
+}
+
+#endif // METRICS_H
@@ -0,0 +1,89 @@
+#ifndef MORSE_ENCODER_H
+#define MORSE_ENCODER_H
+
+/*
+Clean, machine-timed Morse for training material and test fixtures: text in, key-down / key-up
+durations out. Unlike KeyingModel (keying_model.h) there is no operator in the loop, so the same
+text always gives the same schedule.
+
+Letters are looked up in the firmware's packed pattern table (packed_letter, lib/morse_code.h), so
+the encoder and the device agree on every letter. Whitespace separates words; characters the table
+does not have are skipped and counted. Text can be fed in pieces of any size and nothing is kept
+between calls but a few flags, so corpora of any length stream through in fixed memory.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "../../lib/morse_code.h"
+
+struct MorseTiming { // Lengths of the elements and gaps in ms.
+    double dit, dah, elementGap, letterGap, wordGap;
+
+    // Standard (PARIS) timing at 'wpm'; with 'farnsworthWpm' below it, letter and word gaps are stretched to that overall speed (ARRL formula).
+    static MorseTiming at(double wpm, double farnsworthWpm = 0) {
+        double unit = 1200 / wpm;
+        MorseTiming timing = { unit, 3 * unit, unit, 3 * unit, 7 * unit };
+        if (farnsworthWpm > 0 && farnsworthWpm < wpm) {
+            double delay = (60 * wpm - 37.2 * farnsworthWpm) / (farnsworthWpm * wpm) * 1000; // ms of spacing per word, spread over 19 units
+            timing.letterGap = 3 * delay / 19;
+            timing.wordGap = 7 * delay / 19;
+        }
+        return timing;
+    }
+};
+
+class MorseEncoder { // Turns a stream of text into marks and spaces.
+    public:
+    MorseTiming timing;
+    std::string* text = nullptr; // if set, the text as it is sent (upper case, single spaces) is appended here
+    uint64_t letters = 0; // letters encoded
+    uint64_t skipped = 0; // characters the table has no pattern for
+
+    MorseEncoder(const MorseTiming& timing) : timing(timing) {
+        for (int i = 0; i < 26; i++) {
+            packed[i] = packed_letter(i);
+        }
+    }
+
+    // Encodes 'n' characters, calling 'f(down, ms)' for every mark (down) and the space before it. No space precedes the first letter.
+    template <typename F> void encode(const char* chars, size_t n, F f) {
+        for (size_t i = 0; i < n; i++) {
+            char c = chars[i];
+            if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+            if (c < 'A' || c > 'Z') {
+                if (c == ' ' || c == '\t' || c == '\n' || c == '\r') wordBreak = started;
+                else skipped++;
+                continue;
+            }
+            if (started) {
+                f(false, wordBreak ? timing.wordGap : timing.letterGap);
+                if (text) *text += wordBreak ? " " : "";
+            }
+            if (text) *text += c;
+            started = true;
+            wordBreak = false;
+            letters++;
+            uint8_t pattern = packed[c - 'A'];
+            int presses = 0;
+            while (pattern >> (presses + 1)) presses++; // bits below the leading 1
+            for (int bit = presses - 1; bit >= 0; bit--) {
+                if (bit != presses - 1) f(false, timing.elementGap);
+                f(true, (pattern >> bit) & 1 ? timing.dah : timing.dit);
+            }
+        }
+    }
+
+    // Starts over: the next letter has no space before it.
+    void reset() {
+        started = wordBreak = false;
+    }
+
+    private:
+    uint8_t packed[26]; // the firmware's table, packed by packed_letter
+    bool started = false; // a letter has been sent (the next one needs a gap first)
+    bool wordBreak = false; // whitespace came after the last letter
+};
+
+#endif // MORSE_ENCODER_H
\ No newline at end of file
@@ -0,0 +1,162 @@
+#ifndef PCM_READER_H
+#define PCM_READER_H
+
+/*
+Streaming reader for WAV files and headerless PCM. Samples are handed out as mono floats in [-1, 1]
+(channels are averaged) a block at a time, so memory use does not depend on the length of the input.
+
+Supported encodings: unsigned 8-bit, signed 16/24/32-bit integer and 32-bit float, little endian.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+enum PcmEncoding { PCM_U8, PCM_S16, PCM_S24, PCM_S32, PCM_F32 };
+
+struct PcmFormat { // Layout of the samples in the input.
+    PcmEncoding encoding = PCM_S16;
+    uint32_t sampleRate = 8000; // samples per second per channel
+    uint16_t channels = 1;
+
+    int bytes_per_sample() const {
+        switch (encoding) {
+            case PCM_U8: return 1;
+            case PCM_S16: return 2;
+            case PCM_S24: return 3;
+            default: return 4;
+        }
+    }
+};
+
+class PcmReader { // Reads samples from a WAV file, raw PCM file or stdin ("-").
+    public:
+    PcmFormat format;
+    std::string error; // reason 'open' failed
+
+    ~PcmReader() {
+        if (file && file != stdin) fclose(file);
+    }
+
+    // Opens the input. WAV headers are parsed when 'raw' is false; otherwise 'rawFormat' describes the data.
+    bool open(const char* path, bool raw, const PcmFormat& rawFormat) {
+        file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+        if (!file) {
+            error = std::string("cannot open ") + path;
+            return false;
+        }
+        format = rawFormat;
+        remaining = UINT64_MAX;
+        return raw || read_wav_header();
+    }
+
+    // Reads up to 'count' mono samples into 'out'. Returns the number read, 0 at the end of the input.
+    size_t read(float* out, size_t count) {
+        size_t got = read_frames(count);
+        const uint8_t* bytes = buffer.data();
+        float scale = 1.0f / format.channels;
+        for (size_t i = 0; i < got; i++) {
+            float sum = 0;
+            for (uint16_t c = 0; c < format.channels; c++) {
+                sum += decode(bytes);
+                bytes += format.bytes_per_sample();
+            }
+            out[i] = sum * scale;
+        }
+        return got;
+    }
+
+    // Reads up to 'count' frames with every channel kept, interleaved ('count' * channels floats). Returns the frames read.
+    size_t read_interleaved(float* out, size_t count) {
+        size_t got = read_frames(count);
+        const uint8_t* bytes = buffer.data();
+        for (size_t i = 0; i < got * format.channels; i++) {
+            out[i] = decode(bytes);
+            bytes += format.bytes_per_sample();
+        }
+        return got;
+    }
+
+    private:
+    FILE* file = nullptr;
+    uint64_t remaining = UINT64_MAX; // bytes left in the data chunk (unbounded for raw input)
+    std::vector<uint8_t> buffer; // raw bytes of one block
+
+    // Reads the raw bytes of up to 'count' frames into 'buffer'. Returns the frames read.
+    size_t read_frames(size_t count) {
+        size_t frameBytes = (size_t)format.bytes_per_sample() * format.channels;
+        uint64_t frames = std::min<uint64_t>(count, remaining / frameBytes);
+        buffer.resize(frames * frameBytes);
+        size_t got = fread(buffer.data(), frameBytes, frames, file);
+        if (remaining != UINT64_MAX) remaining -= got * frameBytes;
+        return got;
+    }
+
+    // Converts one little endian sample to a float.
+    float decode(const uint8_t* p) const {
+        switch (format.encoding) {
+            case PCM_U8: return (p[0] - 128) / 128.0f;
+            case PCM_S16: return (int16_t)(p[0] | p[1] << 8) / 32768.0f;
+            case PCM_S24: return (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) / 2147483648.0f;
+            case PCM_S32: return (int32_t)((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24) / 2147483648.0f;
+            case PCM_F32: {
+                float value;
+                memcpy(&value, p, sizeof(value));
+                return value;
+            }
+        }
+        return 0;
+    }
+
+    static uint32_t le32(const uint8_t* p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+    static uint16_t le16(const uint8_t* p) { return p[0] | p[1] << 8; }
+
+    // Walks the RIFF chunks up to 'data', taking the sample layout from 'fmt '.
+    bool read_wav_header() {
+        uint8_t riff[12];
+        if (fread(riff, 1, 12, file) != 12 || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+            error = "not a RIFF/WAVE file";
+            return false;
+        }
+        bool haveFormat = false;
+        uint8_t chunk[8];
+        while (fread(chunk, 1, 8, file) == 8) {
+            uint32_t size = le32(chunk + 4);
+            if (memcmp(chunk, "fmt ", 4) == 0) {
+                std::vector<uint8_t> fmt(size);
+                if (size < 16 || fread(fmt.data(), 1, size, file) != size) break;
+                uint16_t tag = le16(&fmt[0]);
+                uint16_t bits = le16(&fmt[14]);
+                if (tag == 0xFFFE && size >= 26) tag = le16(&fmt[24]); // WAVE_FORMAT_EXTENSIBLE: the sub-format GUID starts with the tag
+                format.channels = le16(&fmt[2]);
+                format.sampleRate = le32(&fmt[4]);
+                if (tag == 1 && bits == 8) format.encoding = PCM_U8;
+                else if (tag == 1 && bits == 16) format.encoding = PCM_S16;
+                else if (tag == 1 && bits == 24) format.encoding = PCM_S24;
+                else if (tag == 1 && bits == 32) format.encoding = PCM_S32;
+                else if (tag == 3 && bits == 32) format.encoding = PCM_F32;
+                else {
+                    error = "unsupported WAV encoding (tag " + std::to_string(tag) + ", " + std::to_string(bits) + " bits)";
+                    return false;
+                }
+                if (size & 1) fgetc(file); // chunks are padded to an even size
+                haveFormat = true;
+            } else if (memcmp(chunk, "data", 4) == 0) {
+                if (!haveFormat || format.channels == 0 || format.sampleRate == 0) break;
+                remaining = size == 0xFFFFFFFF ? UINT64_MAX : size; // streamed WAVs leave the size unset
+                return true;
+            } else {
+                for (uint64_t skip = size + (size & 1); skip > 0; skip--) {
+                    if (fgetc(file) == EOF) break;
+                }
+            }
+        }
+        error = "WAV file has no usable fmt/data chunks";
+        return false;
+    }
+};
+
+#endif // PCM_READER_H
\ No newline at end of file
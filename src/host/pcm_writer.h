@@ -0,0 +1,150 @@
+#ifndef PCM_WRITER_H
+#define PCM_WRITER_H
+
+/*
+Streaming writer for WAV files and headerless PCM, the counterpart of pcm_reader.h. Mono float
+samples in [-1, 1] are converted a block at a time and written through a large stdio buffer, so
+output runs at disk speed and memory use does not depend on the length of the audio.
+
+Supported encodings: signed 16-bit integer (converted 8 samples per instruction with SSE2) and 32-bit
+float, little endian. The WAV sizes are filled in by 'close' if the output can seek; on a pipe they
+are left at 0xFFFFFFFF, which pcm_reader.h and most players read as "until the end of the stream".
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "pcm_reader.h"
+
+const size_t PCM_WRITE_BUFFER = 1 << 20; // stdio buffer of the output
+
+class PcmWriter { // Writes mono samples to a WAV file, raw PCM file or stdout ("-").
+    public:
+    PcmFormat format;
+    std::string error; // reason 'open', 'write' or 'close' failed
+    uint64_t frames = 0; // samples written
+
+    ~PcmWriter() {
+        close();
+    }
+
+    // Creates the output. A WAV header is written unless 'raw'; the format's channels are ignored (always mono).
+    bool open(const char* path, bool raw, const PcmFormat& pcmFormat) {
+        format = pcmFormat;
+        format.channels = 1;
+        if (format.encoding != PCM_S16 && format.encoding != PCM_F32) {
+            error = "only s16 and f32 output are supported";
+            return false;
+        }
+        file = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+        if (!file) {
+            error = std::string("cannot create ") + path;
+            return false;
+        }
+        setvbuf(file, nullptr, _IOFBF, PCM_WRITE_BUFFER);
+        wav = !raw;
+        frames = 0;
+        if (wav) write_wav_header(0xFFFFFFFF);
+        return ok();
+    }
+
+    // Converts and writes 'n' samples.
+    bool write(const float* samples, size_t n) {
+        if (format.encoding == PCM_F32) {
+            fwrite(samples, sizeof(float), n, file); // the host is little endian
+        } else {
+            buffer.resize(n);
+            to_s16(samples, buffer.data(), n);
+            fwrite(buffer.data(), sizeof(int16_t), n, file);
+        }
+        frames += n;
+        return ok();
+    }
+
+    // Fills in the WAV sizes (if the output can seek) and closes it. Returns false if anything failed to write.
+    bool close() {
+        if (!file) return error.empty();
+        bool good = ok();
+        uint64_t bytes = frames * format.bytes_per_sample();
+        if (good && wav && file != stdout && bytes <= 0xFFFFFFFF - 36 && fseek(file, 0, SEEK_SET) == 0) {
+            write_wav_header((uint32_t)bytes);
+            good = ok();
+        }
+        if (file == stdout) good = fflush(file) == 0 && good;
+        else good = fclose(file) == 0 && good;
+        file = nullptr;
+        if (!good && error.empty()) error = "write failed";
+        return good;
+    }
+
+    private:
+    FILE* file = nullptr;
+    bool wav = false;
+    std::vector<int16_t> buffer; // one block converted to 16 bits
+
+    bool ok() {
+        if (ferror(file)) {
+            error = "write failed";
+            return false;
+        }
+        return true;
+    }
+
+    static void put16(uint8_t* p, uint16_t v) {
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+    }
+
+    static void put32(uint8_t* p, uint32_t v) {
+        put16(p, v & 0xFFFF);
+        put16(p + 2, v >> 16);
+    }
+
+    // The 44-byte canonical header; 'dataBytes' 0xFFFFFFFF for a stream of unknown length.
+    void write_wav_header(uint32_t dataBytes) {
+        uint8_t h[44];
+        int bytes = format.bytes_per_sample();
+        memcpy(h, "RIFF", 4);
+        put32(h + 4, dataBytes == 0xFFFFFFFF ? dataBytes : dataBytes + 36);
+        memcpy(h + 8, "WAVEfmt ", 8);
+        put32(h + 16, 16);
+        put16(h + 20, format.encoding == PCM_F32 ? 3 : 1); // format tag: float or integer PCM
+        put16(h + 22, 1);
+        put32(h + 24, format.sampleRate);
+        put32(h + 28, format.sampleRate * bytes);
+        put16(h + 32, bytes);
+        put16(h + 34, bytes * 8);
+        memcpy(h + 36, "data", 4);
+        put32(h + 40, dataBytes);
+        fwrite(h, 1, sizeof(h), file);
+    }
+
+    // Scales to 16 bits with rounding and clipping.
+    static void to_s16(const float* in, int16_t* out, size_t n) {
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128 scale = _mm_set1_ps(32767.0f), low = _mm_set1_ps(-1.0f), high = _mm_set1_ps(1.0f);
+        for (; i + 8 <= n; i += 8) {
+            __m128 a = _mm_min_ps(high, _mm_max_ps(low, _mm_loadu_ps(in + i)));
+            __m128 b = _mm_min_ps(high, _mm_max_ps(low, _mm_loadu_ps(in + i + 4)));
+            __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(a, scale)), _mm_cvtps_epi32(_mm_mul_ps(b, scale))); // rounds to nearest
+            _mm_storeu_si128((__m128i*)(out + i), packed);
+        }
+#endif
+        for (; i < n; i++) {
+            float v = std::min(1.0f, std::max(-1.0f, in[i])) * 32767.0f;
+            out[i] = (int16_t)lrintf(v);
+        }
+    }
+};
+
+#endif // PCM_WRITER_H
\ No newline at end of file
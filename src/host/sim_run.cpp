@@ -0,0 +1,76 @@
+/*
+Runs key traces through the virtual-clock simulation of the firmware (see simulation.h), built for the
+host by the 'sim' environment:
+    pio run -e sim && .pio/build/sim/program tools/traces/sos.trace [--repeat N] [--loop-ms N]
+
+Prints, per trace, the decoded and expected text, the character error rate, and how much simulated
+time was covered per second of wall time. '--repeat' replays the trace back to back (e.g. to cover
+hours of keying); '--loop-ms' runs loop() at a fixed period instead of jumping between events.
+Exits with status 1 if any trace decodes with errors, so it can gate a build.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "metrics.h"
+#include "simulation.h"
+#include "text_trace.h"
+
+const uint64_t TRACE_SPACING_MS = 3000; // idle time between repeats, long enough to end the last word
+
+int main(int argc, char** argv) {
+    std::vector<const char*> paths;
+    uint64_t repeat = 1; // times each trace is replayed
+    unsigned long loopMs = 0; // fixed loop() period, 0 = event driven
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) repeat = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--loop-ms" && i + 1 < argc) loopMs = strtoul(argv[++i], nullptr, 10);
+        else if (arg[0] != '-') paths.push_back(argv[i]);
+        else {
+            fprintf(stderr, "usage: %s TRACE... [--repeat N] [--loop-ms N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (paths.empty() || repeat == 0) {
+        fprintf(stderr, "usage: %s TRACE... [--repeat N] [--loop-ms N]\n", argv[0]);
+        return 2;
+    }
+
+    int failures = 0;
+    for (const char* path : paths) {
+        Trace trace = load_trace(path, 0);
+        Simulation simulation;
+        simulation.loopPeriodMs = loopMs;
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t period = trace.lengthMs + TRACE_SPACING_MS; // one replay plus the idle time after it
+        for (uint64_t i = 0; i < repeat; i++) {
+            simulation.run(trace, i * period, TRACE_SPACING_MS);
+        }
+        double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::string expected; // the ground truth of every replay, separated by word gaps
+        for (uint64_t i = 0; i < repeat; i++) expected += (i ? " " : "") + trace.expected;
+        std::string decoded = simulation.decoded;
+        while (!decoded.empty() && decoded.back() == ' ') decoded.pop_back(); // the final word gap has nothing after it
+
+        double simulatedMs = (double)hostPlatform.now;
+        printf("trace      %s x%llu (%llu edges, %llu loops)\n", path, (unsigned long long)repeat,
+               (unsigned long long)simulation.edges, (unsigned long long)simulation.loops);
+        printf("decoded    \"%.64s\"%s\n", decoded.c_str(), decoded.size() > 64 ? "..." : "");
+        printf("time       %.1f s simulated in %.2f ms (%.0fx real time)\n", simulatedMs / 1000, wallMs,
+               simulatedMs / (wallMs > 0 ? wallMs : 1e-3));
+        if (!trace.expected.empty()) {
+            size_t errors = edit_distance(expected, decoded);
+            printf("expected   \"%.64s\"%s\n", expected.c_str(), expected.size() > 64 ? "..." : "");
+            printf("accuracy   %zu edits, CER %.2f%%, %llu invalid patterns\n", errors, 100.0 * errors / expected.size(),
+                   (unsigned long long)simulation.invalid);
+            if (errors) failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,389 @@
+/*
+simavr benchmark harness - runs the real firmware headless on a simulated ATmega328P.
+
+Drives the key pin (digital pin 7 / PD7) from a scripted timing trace, decodes the LCD bus traffic
+(HD44780 in 4-bit mode: RS=PB4, EN=PB3, D4..D7=PD5..PD2) and captures the serial output. Reports
+cycles per key event, loop() period and stalls, key release -> LCD latency, decode accuracy and the
+cycles of every scheduler task run (lib/scheduler.h) against the task budget.
+
+Build and run (Linux, needs libsimavr and libelf):
+    pio run -e uno_sim                     # firmware without LTO so loop() keeps its own symbol
+    pio run -e simavr
+    .pio/build/simavr/program tools/traces/sos.trace --elf .pio/build/uno_sim/firmware.elf
+
+The trace format is described in text_trace.h.
+*/
+
+#include <fcntl.h>
+#include <gelf.h>
+#include <libelf.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "avr_ioport.h"
+#include "avr_uart.h"
+#include "sim_avr.h"
+#include "sim_elf.h"
+
+#include "metrics.h"
+#include "text_trace.h"
+
+const uint32_t CPU_FREQUENCY = 16000000; // Uno clock (Hz)
+const uint64_t CYCLES_PER_MS = CPU_FREQUENCY / 1000;
+
+// Finds the address of a function symbol in the firmware's ELF file, 0 if it is not there.
+uint32_t find_symbol(const char* path, const char* name) {
+    elf_version(EV_CURRENT);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    Elf* elf = elf_begin(fd, ELF_C_READ, nullptr);
+    uint32_t address = 0;
+    Elf_Scn* section = nullptr;
+    while (elf && address == 0 && (section = elf_nextscn(elf, section)) != nullptr) {
+        GElf_Shdr header;
+        gelf_getshdr(section, &header);
+        if (header.sh_type != SHT_SYMTAB) continue;
+        Elf_Data* data = elf_getdata(section, nullptr);
+        size_t count = header.sh_size / header.sh_entsize;
+        for (size_t i = 0; i < count; i++) {
+            GElf_Sym symbol;
+            gelf_getsym(data, i, &symbol);
+            const char* symbolName = elf_strptr(elf, header.sh_link, symbol.st_name);
+            if (symbolName && strcmp(symbolName, name) == 0 && GELF_ST_TYPE(symbol.st_info) == STT_FUNC) {
+                address = symbol.st_value;
+                break;
+            }
+        }
+    }
+    if (elf) elf_end(elf);
+    close(fd);
+    return address;
+}
+
+class LcdBus { // Decodes HD44780 4-bit bus traffic into display memory.
+    public:
+    char ddram[0x80]; // display data RAM; row 0 starts at 0x00, row 1 at 0x40
+    uint8_t address = 0; // DDRAM address counter
+    bool fourBit = false; // the controller starts in 8-bit mode until told otherwise
+    bool highNibble = true; // next 4-bit transfer is the high half of a byte
+    uint8_t pending = 0; // high nibble waiting for its low half
+    uint8_t pins[6] = {}; // current levels of RS, EN, D4, D5, D6, D7
+    uint64_t dataWrites = 0; // characters written
+    uint64_t commands = 0; // instructions written
+    std::vector<std::pair<uint64_t, char>> newCharacters; // (cycle, char) of every write to column 0, row 0
+
+    avr_t* avr = nullptr;
+
+    LcdBus() {
+        memset(ddram, ' ', sizeof(ddram));
+    };
+
+    // Called on every EN falling edge: the controller latches RS and D4..D7.
+    void latch() {
+        uint8_t nibble = pins[2] | (pins[3] << 1) | (pins[4] << 2) | (pins[5] << 3);
+        bool data = pins[0];
+        if (!fourBit) { // 8-bit mode: a single transfer is a whole byte, low data lines unconnected
+            uint8_t value = nibble << 4;
+            if (!data && (value & 0xF0) == 0x20) { // function set selecting the 4-bit interface
+                fourBit = true;
+                highNibble = true;
+            }
+            return;
+        }
+        if (highNibble) {
+            pending = nibble << 4;
+            highNibble = false;
+            return;
+        }
+        highNibble = true;
+        byte(data, pending | nibble);
+    };
+
+    // Applies one complete byte to the controller model.
+    void byte(bool data, uint8_t value) {
+        if (data) {
+            dataWrites++;
+            if (address == 0x00) newCharacters.push_back({ avr->cycle, (char)value });
+            ddram[address & 0x7F] = (char)value;
+            address = (address + 1) & 0x7F;
+            return;
+        }
+        commands++;
+        if (value & 0x80) { // set DDRAM address
+            address = value & 0x7F;
+        } else if (value == 0x01) { // clear display
+            memset(ddram, ' ', sizeof(ddram));
+            address = 0;
+        } else if ((value & 0xFE) == 0x02) { // return home
+            address = 0;
+        }
+    };
+
+    // Returns one 16-character row of the display.
+    std::string row(int index) const {
+        return std::string(ddram + (index ? 0x40 : 0x00), 16);
+    };
+
+    static void on_pin(struct avr_irq_t* irq, uint32_t value, void* param) {
+        (void)irq;
+        LcdPin* pin = (LcdPin*)param;
+        uint8_t previous = pin->bus->pins[pin->index];
+        pin->bus->pins[pin->index] = value ? 1 : 0;
+        if (pin->index == 1 && previous && !value) { // EN falling edge
+            pin->bus->latch();
+        }
+    };
+
+    struct LcdPin { // Binds a port pin IRQ to one of the bus lines.
+        LcdBus* bus;
+        uint8_t index;
+    } lines[6];
+
+    // Hooks the bus lines of the simulated MCU.
+    void attach(avr_t* target) {
+        avr = target;
+        const char ports[6] = { 'B', 'B', 'D', 'D', 'D', 'D' }; // RS, EN, D4, D5, D6, D7
+        const int bits[6] = { 4, 3, 5, 4, 3, 2 };
+        for (int i = 0; i < 6; i++) {
+            lines[i] = { this, (uint8_t)i };
+            avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(ports[i]), bits[i]), on_pin, &lines[i]);
+        }
+    };
+};
+
+struct SerialCapture { // Collects everything the firmware writes to USART0.
+    std::string bytes;
+
+    static void on_byte(struct avr_irq_t* irq, uint32_t value, void* param) {
+        (void)irq;
+        ((SerialCapture*)param)->bytes.push_back((char)value);
+    };
+};
+
+struct CycleStats { // min/mean/max of a series of cycle counts.
+    uint64_t count = 0, total = 0, min = UINT64_MAX, max = 0;
+
+    void add(uint64_t cycles) {
+        count++;
+        total += cycles;
+        min = std::min(min, cycles);
+        max = std::max(max, cycles);
+    };
+
+    void print(const char* name) const {
+        if (count == 0) {
+            printf("%-26s n=0\n", name);
+            return;
+        }
+        printf("%-26s n=%-8llu min=%-10llu mean=%-10llu max=%-10llu (max %.1f us)\n", name, (unsigned long long)count,
+            (unsigned long long)min, (unsigned long long)(total / count), (unsigned long long)max, max * 1e6 / CPU_FREQUENCY);
+    };
+};
+
+// Scheduler tasks of src/main.cpp, timed from their entry until they return.
+const char* const TASK_FUNCTIONS[] = { "key_capture_task", "classify_task", "paddle_task", "gap_timer_task",
+    "display_task", "led_task", "store_task", "telemetry_task" };
+
+struct TaskTimer { // Runs of one task: entered at 'address', over once the stack is back above 'sp'.
+    const char* name;
+    uint32_t address;
+    CycleStats runs;
+};
+
+// Stack pointer of the simulated MCU.
+uint16_t stack_pointer(avr_t* avr) {
+    return avr->data[R_SPL] | (avr->data[R_SPH] << 8);
+}
+
+int main(int argc, char** argv) {
+    const char* tracePath = nullptr;
+    const char* elfPath = ".pio/build/uno_sim/firmware.elf";
+    const char* serialPath = nullptr; // where to save the captured serial output
+    uint64_t settleMs = 500; // time given to setup() before the trace starts
+    uint64_t tailMs = 2000; // time simulated after the last edge so the last letter can finish
+    double stallUs = 5000; // loop periods longer than this count as stalls
+    double budgetUs = 4000; // task runs longer than this are over the budget (SCHEDULER_BUDGET_US)
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--elf" && i + 1 < argc) elfPath = argv[++i];
+        else if (arg == "--serial" && i + 1 < argc) serialPath = argv[++i];
+        else if (arg == "--settle-ms" && i + 1 < argc) settleMs = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--tail-ms" && i + 1 < argc) tailMs = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--stall-us" && i + 1 < argc) stallUs = atof(argv[++i]);
+        else if (arg == "--budget-us" && i + 1 < argc) budgetUs = atof(argv[++i]);
+        else if (arg[0] != '-' && !tracePath) tracePath = argv[i];
+        else {
+            fprintf(stderr, "usage: %s TRACE [--elf firmware.elf] [--serial out.txt] [--settle-ms N] [--tail-ms N] [--stall-us N] [--budget-us N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!tracePath) {
+        fprintf(stderr, "no trace given\n");
+        return 2;
+    }
+
+    Trace trace = load_trace(tracePath, settleMs);
+
+    elf_firmware_t firmware = {};
+    if (elf_read_firmware(elfPath, &firmware) != 0) {
+        fprintf(stderr, "cannot read firmware %s\n", elfPath);
+        return 1;
+    }
+    avr_t* avr = avr_make_mcu_by_name(firmware.mmcu[0] ? firmware.mmcu : "atmega328p");
+    if (!avr) {
+        fprintf(stderr, "unknown mcu\n");
+        return 1;
+    }
+    avr_init(avr);
+    avr_load_firmware(avr, &firmware);
+    if (avr->frequency == 0) avr->frequency = CPU_FREQUENCY;
+
+    LcdBus lcd;
+    lcd.attach(avr);
+
+    SerialCapture serial;
+    uint32_t uartFlags = 0; // stop simavr echoing the UART to its own stdout
+    avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &uartFlags);
+    uartFlags &= ~AVR_UART_FLAG_STDIO;
+    avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &uartFlags);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT), SerialCapture::on_byte, &serial);
+
+    avr_irq_t* keyPin = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), 7);
+    avr_raise_irq(keyPin, 0); // key starts released
+
+    uint32_t loopAddress = find_symbol(elfPath, "loop");
+    if (loopAddress == 0) loopAddress = find_symbol(elfPath, "_Z4loopv");
+    if (loopAddress == 0) {
+        fprintf(stderr, "warning: no loop() symbol in %s (inlined by LTO?); loop statistics disabled\n", elfPath);
+    }
+
+    std::vector<TaskTimer> tasks;
+    for (const char* name : TASK_FUNCTIONS) {
+        std::string mangled = "_Z" + std::to_string(strlen(name)) + name + "v";
+        uint32_t address = find_symbol(elfPath, mangled.c_str());
+        if (address) tasks.push_back({ name, address, {} }); // paddle_task only exists with MORSE_PADDLE
+    }
+    if (tasks.empty()) {
+        fprintf(stderr, "warning: no task functions in %s; task statistics disabled\n", elfPath);
+    }
+    TaskTimer* running = nullptr; // task being timed
+    uint16_t runningSp = 0; // stack pointer on its entry, with the return address pushed
+    uint64_t runningStart = 0;
+
+    CycleStats loopPeriod, pressEvents, releaseEvents, releaseToLcd;
+    uint64_t stalls = 0;
+    uint64_t stallCycles = (uint64_t)(stallUs * CPU_FREQUENCY / 1e6);
+    uint64_t lastLoop = 0; // cycle of the previous loop() entry
+    uint64_t lastEdge = 0; // cycle of the most recent key edge
+    bool lastEdgePressed = false;
+    bool edgePending = false; // an edge happened and the loop iteration handling it has not finished yet
+    bool edgeLoopStarted = false; // loop() has been entered since the pending edge
+    uint64_t releaseCycle = 0; // cycle of the last release, for release -> LCD latency
+    bool releasePending = false;
+    size_t charactersSeen = 0;
+
+    size_t nextEdge = 0;
+    uint64_t endCycle = (trace.lengthMs + tailMs) * CYCLES_PER_MS;
+    int state = cpu_Running;
+    while (avr->cycle < endCycle && state != cpu_Done && state != cpu_Crashed) {
+        while (nextEdge < trace.edges.size() && avr->cycle >= trace.edges[nextEdge].timeMs * CYCLES_PER_MS) {
+            const TraceEdge& edge = trace.edges[nextEdge++];
+            avr_raise_irq(keyPin, edge.pressed ? 1 : 0);
+            lastEdge = avr->cycle;
+            lastEdgePressed = edge.pressed;
+            edgePending = true;
+            edgeLoopStarted = false;
+            if (!edge.pressed) {
+                releaseCycle = avr->cycle;
+                releasePending = true;
+            }
+        }
+
+        state = avr_run(avr);
+
+        if (running) { // its ret pops the return address; interrupts during the run only go deeper
+            if (stack_pointer(avr) > runningSp) {
+                running->runs.add(avr->cycle - runningStart);
+                running = nullptr;
+            }
+        } else {
+            for (TaskTimer& task : tasks) {
+                if (avr->pc == task.address) {
+                    running = &task;
+                    runningSp = stack_pointer(avr);
+                    runningStart = avr->cycle;
+                    break;
+                }
+            }
+        }
+
+        if (loopAddress && avr->pc == loopAddress) { // entering loop()
+            if (lastLoop != 0) {
+                uint64_t period = avr->cycle - lastLoop;
+                loopPeriod.add(period);
+                if (period > stallCycles) stalls++;
+            }
+            lastLoop = avr->cycle;
+            if (edgePending) { // the iteration after the edge has completed once loop() is entered twice
+                if (edgeLoopStarted) {
+                    (lastEdgePressed ? pressEvents : releaseEvents).add(avr->cycle - lastEdge);
+                    edgePending = false;
+                } else {
+                    edgeLoopStarted = true;
+                }
+            }
+        }
+
+        if (lcd.newCharacters.size() != charactersSeen) {
+            charactersSeen = lcd.newCharacters.size();
+            if (releasePending) {
+                releaseToLcd.add(lcd.newCharacters.back().first - releaseCycle);
+                releasePending = false;
+            }
+        }
+    }
+
+    std::string decoded;
+    for (auto& written : lcd.newCharacters) decoded.push_back(written.second);
+
+    printf("firmware   %s\n", elfPath);
+    printf("trace      %s (%zu edges, %.1f s simulated, %llu cycles)\n", tracePath, trace.edges.size(),
+        avr->cycle / (double)CPU_FREQUENCY, (unsigned long long)avr->cycle);
+    if (state == cpu_Crashed) printf("CPU CRASHED at pc=0x%04x\n", avr->pc);
+    loopPeriod.print("loop period (cycles)");
+    printf("%-26s %llu (> %.0f us)\n", "loop stalls", (unsigned long long)stalls, stallUs);
+    pressEvents.print("press edge -> handled");
+    releaseEvents.print("release edge -> handled");
+    releaseToLcd.print("release -> lcd char");
+    uint64_t budgetCycles = (uint64_t)(budgetUs * CPU_FREQUENCY / 1e6);
+    size_t overBudget = 0;
+    for (const TaskTimer& task : tasks) {
+        std::string label = std::string("task ") + task.name + " (cycles)";
+        task.runs.print(label.c_str());
+        if (task.runs.count && task.runs.max > budgetCycles) overBudget++;
+    }
+    if (!tasks.empty()) printf("%-26s %.0f us, %zu task(s) over\n", "task budget", budgetUs, overBudget);
+    printf("lcd        %llu data writes, %llu commands\n", (unsigned long long)lcd.dataWrites, (unsigned long long)lcd.commands);
+    printf("           [%s]\n           [%s]\n", lcd.row(0).c_str(), lcd.row(1).c_str());
+    printf("serial     %zu bytes\n", serial.bytes.size());
+    printf("decoded    \"%s\"\n", decoded.c_str());
+    if (!trace.expected.empty()) {
+        size_t errors = edit_distance(trace.expected, decoded);
+        printf("expected   \"%s\"\n", trace.expected.c_str());
+        printf("accuracy   %zu edits, CER %.1f%%\n", errors, 100.0 * errors / trace.expected.size());
+    }
+
+    if (serialPath) {
+        std::ofstream out(serialPath, std::ios::binary);
+        out << serial.bytes;
+    }
+    return state == cpu_Crashed ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+/*
+Deterministic virtual-clock simulation of the firmware's input pipeline on the host.
+
+millis() and digitalRead() are backed by 'hostPlatform' (lib/platform.h), so the Simulation owns the
+clock and the key pin: it replays the edges of a trace on the pin, debounces the pin's port on the
+ticks of the TickTimer interrupt (tick_debouncer.h) and runs the same Button -> Decoder -> Display
+path as the tasks in main.cpp, with the lcd simulated by HostLcd (lib/lcd.h). Nothing depends on wall time, so a run is reproducible and
+hours of keying take milliseconds.
+
+By default time jumps straight to the next thing that can happen (a trace edge, a debouncer tick
+or a decoder deadline). With 'loopPeriodMs' set, loop() is instead run every 'loopPeriodMs' ms
+(with the ticks still every ms), which is slower but also exercises polling granularity.
+*/
+
+#include <cstdint>
+#include <string>
+
+#include "../../lib/button.h"
+#include "../../lib/decoder.h"
+#include "../../lib/display.h"
+#include "text_trace.h"
+#include "tick_debouncer.h"
+
+const uint8_t SIMULATED_KEY_PIN = 7; // the push button's digital pin on the board
+typedef DigitalPin<SIMULATED_KEY_PIN> SimulatedKey;
+
+class Simulation { // Button, decoder and display model driven by a virtual clock.
+    public:
+    Button button;
+    Decoder decoder;
+    HostLcd lcd; // what the lcd would show
+    Display<HostLcd> display;
+    std::string decoded; // every letter and word gap in the order they were shown (cleared with the display)
+    unsigned long loopPeriodMs = 0; // 0 = jump between events, otherwise run loop() every this many ms
+    uint64_t loops = 0; // times loop() was run
+    uint64_t edges = 0; // edges handed to the decoder
+    uint64_t invalid = 0; // patterns that matched no letter
+
+    Simulation() : decoder(button.properties()), display(lcd), keyPort(SimulatedKey::mask) {
+        hostPlatform.now = 0;
+        hostPlatform.pins[SIMULATED_KEY_PIN] = LOW;
+    };
+
+    // Replays a trace whose first edge is at least 'offsetMs' in, then keeps running for 'tailMs' so the last letter can finish.
+    void run(const Trace& trace, uint64_t offsetMs, uint64_t tailMs) {
+        for (const TraceEdge& edge : trace.edges) {
+            key(offsetMs + edge.timeMs, edge.pressed);
+        }
+        advance_to(offsetMs + trace.lengthMs + tailMs);
+    };
+
+    // Sets the key pin to 'pressed' at 'time' (ms, not before the current time) after running everything due until then.
+    void key(uint64_t time, bool pressed) {
+        advance_to(time);
+        hostPlatform.pins[SIMULATED_KEY_PIN] = pressed ? HIGH : LOW;
+        keyPort.set(time, SimulatedKey::read_port());
+    };
+
+    // Runs the ticks and loop() at every point in time until 'time' where something can happen, leaving the clock at 'time'.
+    void advance_to(uint64_t time) {
+        uint64_t next;
+        while (next_wakeup(next) && next < time) {
+            hostPlatform.now = next;
+            if (keyPort.pending() && keyPort.next_tick() == next) {
+                keyPort.tick(); // the TickTimer interrupt
+            }
+            if (!loopPeriodMs || next % loopPeriodMs == 0) {
+                loop();
+            }
+        }
+        hostPlatform.now = time;
+    };
+
+    // One pass of the firmware's tasks: take the debounced key edges, decode, show.
+    void loop() {
+        loops++;
+        PortEdge portEdge;
+        bool captured = false;
+        while (keyPort.port.edges.pop(portEdge)) {
+            step(button.check_press((portEdge.levels & SimulatedKey::mask) != 0, portEdge.time));
+            captured = true;
+        }
+        if (!captured) step(EDGE_NONE);
+        display.flush();
+    };
+
+    private:
+    TickDebouncer keyPort; // the key's port, as sampled by the TickTimer interrupt
+
+    // Classifies an edge (or none), decodes and queues the result for the display.
+    void step(ButtonEdge edge) {
+        if (edge != EDGE_NONE) edges++;
+        decoder.update(edge, millis());
+        DecoderEvent event;
+        while (decoder.next_event(event)) {
+            switch (event.type) {
+                case DECODED_LETTER:
+                case DECODED_WORD_GAP:
+                    display.add(event.letter);
+                    decoded += event.letter;
+                    break;
+                case DECODED_INVALID:
+                    invalid++;
+                    break;
+                case DECODED_CLEAR:
+                    display.clear();
+                    decoded.clear();
+                    break;
+            }
+        }
+    };
+
+    // Sets 'next' to the next time from now on at which a tick or loop() would see a change. Returns false if nothing is pending.
+    bool next_wakeup(uint64_t& next) {
+        uint64_t now = hostPlatform.now;
+        bool found;
+        if (loopPeriodMs) {
+            next = (now / loopPeriodMs + 1) * loopPeriodMs;
+            found = true;
+        } else {
+            next = decoder.next_deadline();
+            found = next > now;
+        }
+        if (keyPort.pending() && (!found || keyPort.next_tick() < next)) {
+            next = keyPort.next_tick();
+            found = true;
+        }
+        return found;
+    };
+};
+
+#endif // SIMULATION_H
\ No newline at end of file
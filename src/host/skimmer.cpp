@@ -0,0 +1,306 @@
+/*
+Wideband CW skimmer: finds every CW carrier in a wideband recording and decodes them all at once,
+built for the host by the 'skimmer' environment:
+    pio run -e skimmer && .pio/build/skimmer/program band.wav [--iq] [--threads N]
+
+The input is cut into overlapping Hann-windowed frames, one every --hop-ms, and each frame is
+transformed with an FFT, which splits the band into channels of fs/--fft Hz. Bins whose long-term
+power stands out from the noise floor (by --snr) start a channel. The floor never drops below
+--range dB under the strongest bin: on a clean recording the empty bins hold next to nothing, and the
+window's leakage from a single tone would otherwise stand out from them as a row of phantom carriers. Every channel has its own
+ToneKey and KeyDecoder (key_decoder.h), i.e. the firmware's classifier and MorseCode tables, fed from the
+three bins around its carrier. Channels that stay silent for --idle-s are retired.
+
+Work is done in chunks of --chunk-ms: first the FFTs of the chunk (split into groups of frames),
+then one task per channel, both run on a work-stealing pool across all cores. Memory is fixed by
+the chunk length and the channel limit, not by the length of the input.
+
+Options:
+    --iq                 2-channel input is I/Q (complex baseband), otherwise channels are mixed
+    --raw --rate N --channels N --format F    headerless PCM, as for the audio decoder
+    --fft N              FFT size, a power of two (default 512)
+    --hop-ms N           time between frames, the timing resolution (default 4)
+    --chunk-ms N         audio processed per batch (default 500)
+    --snr X              power ratio over the noise floor that starts a channel (default 10)
+    --range DB           channels start at most this far below the strongest bin (default 50)
+    --max-channels N     channel limit (default 512)
+    --idle-s N           silence after which a channel is retired (default 30)
+    --threshold K        classifier threshold multiplier (default: the firmware's)
+    --threads N          worker threads including the main one (default: one per core)
+    --quiet              do not print text as it is decoded, only the final report
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fft.h"
+#include "goertzel.h"
+#include "key_decoder.h"
+#include "pcm_reader.h"
+#include "work_pool.h"
+
+const int CHANNEL_BINS = 3; // bins each channel listens to: its carrier and one either side
+const int CHANNEL_SPACING = 2; // no two channels start closer than this many bins
+const int NOISE_PERCENTILE = 10; // the noise floor is the power 1/10 of the way up the sorted bins (a crowded band has few empty bins)
+const int FRAMES_PER_TASK = 16; // FFT frames per pool task
+const uint64_t TAIL_MS = 3000; // silence after the input so the last letters finish
+const size_t TEXT_KEEP = 64; // decoded characters kept per channel for the final report
+
+class Channel { // A single carrier and the firmware decoder following it.
+    public:
+    int bin; // FFT bin of the carrier
+    double hz; // carrier frequency (offset from the centre for I/Q)
+    KeyDecoder decoder;
+    ToneKey key;
+    std::string recent; // last TEXT_KEEP characters decoded
+    uint64_t startMs = 0; // when the channel was found
+    uint64_t lastActiveMs = 0; // last time the key was down
+    uint64_t frames = 0; // frames processed
+    double cpuNs = 0; // time spent in this channel's tasks
+    bool retired = false;
+
+    Channel(int bin, double hz, uint64_t now, float decay) : bin(bin), hz(hz), startMs(now), lastActiveMs(now) {
+        key.decay = decay;
+        decoder.now = now;
+    }
+
+    // Runs this channel over 'count' frames of bin powers ('stride' floats per frame), the first at 'firstMs'.
+    void process(const float* power, size_t stride, int binCount, bool wrap, size_t count, uint64_t firstMs, double hopMs) {
+        auto start = std::chrono::steady_clock::now();
+        float around[CHANNEL_BINS];
+        for (size_t f = 0; f < count; f++) {
+            const float* frame = power + f * stride;
+            for (int i = 0; i < CHANNEL_BINS; i++) {
+                int b = bin + i - CHANNEL_BINS / 2;
+                if (wrap) b = (b + binCount) % binCount;
+                around[i] = b >= 0 && b < binCount ? frame[b] : 0;
+            }
+            uint64_t now = firstMs + (uint64_t)(f * hopMs);
+            if (key.update(around, CHANNEL_BINS)) decoder.key(now, key.down);
+            if (key.down) lastActiveMs = now;
+        }
+        decoder.advance_to(firstMs + (uint64_t)(count * hopMs));
+        frames += count;
+        cpuNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Text decoded since the last call.
+    std::string take_text() {
+        std::string text;
+        text.swap(decoder.text);
+        recent += text;
+        if (recent.size() > TEXT_KEEP) recent.erase(0, recent.size() - TEXT_KEEP);
+        return text;
+    }
+};
+
+void usage(const char* program) {
+    fprintf(stderr, "usage: %s FILE|- [--iq] [--raw --rate N --channels N --format F] [--fft N] [--hop-ms N] [--chunk-ms N] [--snr X] [--range DB] [--max-channels N] [--idle-s N] [--threshold K] [--threads N] [--quiet]\n", program);
+    exit(2);
+}
+
+// Prints the text decoded on a channel since the last call (or only keeps it for the report if 'quiet').
+void print_pending(Channel& channel, bool quiet) {
+    std::string text = channel.take_text();
+    if (!quiet && !text.empty()) printf("%9.1f Hz | %s\n", channel.hz, text.c_str());
+}
+
+int main(int argc, char** argv) {
+    const char* path = nullptr;
+    bool iq = false, raw = false, quiet = false;
+    PcmFormat rawFormat;
+    int fftSize = 512;
+    double hopMs = 4, chunkMs = 500, snr = 10, rangeDb = 50, idleS = 30;
+    size_t maxChannels = 512;
+    float threshold = -1;
+    unsigned threads = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool more = i + 1 < argc;
+        if (arg == "--iq") iq = true;
+        else if (arg == "--raw") raw = true;
+        else if (arg == "--quiet") quiet = true;
+        else if (arg == "--rate" && more) rawFormat.sampleRate = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--channels" && more) rawFormat.channels = (uint16_t)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--format" && more) {
+            std::string name = argv[++i];
+            if (name == "u8") rawFormat.encoding = PCM_U8;
+            else if (name == "s16") rawFormat.encoding = PCM_S16;
+            else if (name == "s24") rawFormat.encoding = PCM_S24;
+            else if (name == "s32") rawFormat.encoding = PCM_S32;
+            else if (name == "f32") rawFormat.encoding = PCM_F32;
+            else usage(argv[0]);
+        }
+        else if (arg == "--fft" && more) fftSize = atoi(argv[++i]);
+        else if (arg == "--hop-ms" && more) hopMs = atof(argv[++i]);
+        else if (arg == "--chunk-ms" && more) chunkMs = atof(argv[++i]);
+        else if (arg == "--snr" && more) snr = atof(argv[++i]);
+        else if (arg == "--range" && more) rangeDb = atof(argv[++i]);
+        else if (arg == "--max-channels" && more) maxChannels = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--idle-s" && more) idleS = atof(argv[++i]);
+        else if (arg == "--threshold" && more) threshold = atof(argv[++i]);
+        else if (arg == "--threads" && more) threads = (unsigned)atoi(argv[++i]);
+        else if (arg[0] != '-' || arg == "-") path = argv[i];
+        else usage(argv[0]);
+    }
+    if (!path || !Fft::is_power_of_two(fftSize) || hopMs <= 0 || chunkMs < hopMs) usage(argv[0]);
+
+    PcmReader reader;
+    if (!reader.open(path, raw, rawFormat)) {
+        fprintf(stderr, "%s: %s\n", path, reader.error.c_str());
+        return 1;
+    }
+    const PcmFormat& format = reader.format;
+    if (iq && format.channels != 2) {
+        fprintf(stderr, "%s: --iq needs 2 channels, got %u\n", path, format.channels);
+        return 1;
+    }
+
+    const Fft fft(fftSize);
+    const int binCount = iq ? fftSize : fftSize / 2; // real input only has the positive half
+    const size_t hop = std::max<size_t>(1, (size_t)(format.sampleRate * hopMs / 1000));
+    hopMs = hop * 1000.0 / format.sampleRate; // exact frame spacing
+    const size_t framesPerChunk = std::max<size_t>(1, (size_t)(chunkMs / hopMs));
+    const double binHz = (double)format.sampleRate / fftSize;
+
+    std::vector<float> window(fftSize);
+    for (int i = 0; i < fftSize; i++) window[i] = 0.5f - 0.5f * cosf(2 * (float)M_PI * i / fftSize); // Hann
+
+    // Samples of the chunk plus the overlap the next frame needs; the only buffers that depend on the input.
+    std::vector<std::complex<float>> samples;
+    std::vector<float> interleaved(framesPerChunk * hop * format.channels);
+    std::vector<float> power(framesPerChunk * binCount); // frame-major bin powers of the chunk
+    std::vector<double> average(binCount, 0); // long-term power per bin, for finding carriers
+    std::vector<std::unique_ptr<Channel>> channels;
+    std::vector<std::unique_ptr<Channel>> finished; // retired channels, kept for the report
+    std::vector<int> owner(binCount, -1); // channel listening on/near each bin, -1 if none
+
+    WorkPool pool(threads);
+    std::vector<WorkPool::Task> tasks;
+    uint64_t frameIndex = 0; // frames processed since the start
+    size_t peakChannels = 0;
+    bool done = false;
+    auto start = std::chrono::steady_clock::now();
+    double fftNs = 0, channelNs = 0;
+
+    while (!done) {
+        // Read enough for 'framesPerChunk' more frames.
+        size_t want = framesPerChunk * hop;
+        size_t got = iq ? reader.read_interleaved(interleaved.data(), want) : reader.read(interleaved.data(), want);
+        for (size_t i = 0; i < got; i++) {
+            samples.emplace_back(iq ? interleaved[2 * i] : interleaved[i], iq ? interleaved[2 * i + 1] : 0.0f);
+        }
+        done = got < want;
+        if (samples.size() < (size_t)fftSize) break;
+        size_t frames = std::min(framesPerChunk, (samples.size() - fftSize) / hop + 1);
+
+        // Channelise: one FFT per frame, in groups of frames per task.
+        auto phase = std::chrono::steady_clock::now();
+        for (size_t first = 0; first < frames; first += FRAMES_PER_TASK) {
+            size_t last = std::min(frames, first + FRAMES_PER_TASK);
+            tasks.push_back([&, first, last] {
+                std::vector<std::complex<float>> buffer(fftSize);
+                for (size_t f = first; f < last; f++) {
+                    for (int i = 0; i < fftSize; i++) buffer[i] = samples[f * hop + i] * window[i];
+                    fft.forward(buffer.data());
+                    float* out = &power[f * binCount];
+                    for (int b = 0; b < binCount; b++) out[b] = std::norm(buffer[b]);
+                }
+            });
+        }
+        pool.run(tasks);
+        fftNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - phase).count();
+        uint64_t chunkStartMs = (uint64_t)(frameIndex * hopMs);
+
+        // Find new carriers: bins well above the noise floor that are local peaks away from existing channels.
+        for (int b = 0; b < binCount; b++) {
+            double sum = 0;
+            for (size_t f = 0; f < frames; f++) sum += power[f * binCount + b];
+            average[b] += (sum / frames - average[b]) * 0.3;
+        }
+        std::vector<double> sorted(average);
+        std::nth_element(sorted.begin(), sorted.begin() + binCount / NOISE_PERCENTILE, sorted.end());
+        double noise = sorted[binCount / NOISE_PERCENTILE];
+        double peak = *std::max_element(average.begin(), average.end());
+        noise = std::max(noise, peak * pow(10, -rangeDb / 10) / snr); // leakage of a strong carrier is not a carrier
+        for (int b = 1; b < binCount - 1 && channels.size() < maxChannels; b++) {
+            if (owner[b] >= 0 || average[b] <= noise * snr || average[b] < average[b - 1] || average[b] < average[b + 1]) continue;
+            double hz = (iq && b >= binCount / 2 ? b - binCount : b) * binHz;
+            channels.emplace_back(new Channel(b, hz, chunkStartMs, (float)(hopMs / 2000)));
+            if (threshold >= 0) channels.back()->decoder.decoder.classifier.thresholdMultiplier = threshold;
+            for (int d = -CHANNEL_SPACING; d <= CHANNEL_SPACING; d++) {
+                if (b + d >= 0 && b + d < binCount) owner[b + d] = (int)channels.size() - 1;
+            }
+        }
+        peakChannels = std::max(peakChannels, channels.size());
+
+        // Decode: one task per channel over the whole chunk.
+        phase = std::chrono::steady_clock::now();
+        for (auto& channel : channels) {
+            Channel* c = channel.get();
+            tasks.push_back([&, c, frames, chunkStartMs] {
+                c->process(power.data(), binCount, binCount, iq, frames, chunkStartMs, hopMs);
+            });
+        }
+        pool.run(tasks);
+        channelNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - phase).count();
+        frameIndex += frames;
+        samples.erase(samples.begin(), samples.begin() + frames * hop); // keeps the overlap for the next frames
+
+        // Print new text and retire channels that went quiet.
+        uint64_t nowMs = (uint64_t)(frameIndex * hopMs);
+        for (size_t i = 0; i < channels.size(); i++) {
+            print_pending(*channels[i], quiet);
+            if (nowMs - channels[i]->lastActiveMs > idleS * 1000) channels[i]->retired = true;
+        }
+        for (size_t i = 0; i < channels.size();) {
+            if (!channels[i]->retired) {
+                i++;
+                continue;
+            }
+            channels[i]->decoder.finish(nowMs, TAIL_MS);
+            print_pending(*channels[i], quiet);
+            finished.push_back(std::move(channels[i]));
+            channels.erase(channels.begin() + i);
+        }
+        std::fill(owner.begin(), owner.end(), -1);
+        for (size_t i = 0; i < channels.size(); i++) {
+            for (int d = -CHANNEL_SPACING; d <= CHANNEL_SPACING; d++) {
+                int b = channels[i]->bin + d;
+                if (b >= 0 && b < binCount) owner[b] = (int)i;
+            }
+        }
+    }
+
+    uint64_t audioMs = (uint64_t)(frameIndex * hopMs);
+    for (auto& channel : channels) {
+        channel->decoder.finish(audioMs, TAIL_MS);
+        print_pending(*channel, quiet);
+        finished.push_back(std::move(channel));
+    }
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::sort(finished.begin(), finished.end(), [](const std::unique_ptr<Channel>& a, const std::unique_ptr<Channel>& b) { return a->hz < b->hz; });
+    fprintf(stderr, "\n%9s %8s %7s %7s %8s %10s %10s  %s\n", "Hz", "active s", "edges", "letters", "invalid", "ns/frame", "x realtime", "last text");
+    for (auto& channel : finished) {
+        double activeMs = (double)(std::min(audioMs, channel->lastActiveMs) - std::min(audioMs, channel->startMs));
+        double nsPerFrame = channel->frames ? channel->cpuNs / channel->frames : 0;
+        fprintf(stderr, "%9.1f %8.1f %7llu %7llu %8llu %10.0f %10.0f  %s\n", channel->hz, activeMs / 1000,
+                (unsigned long long)channel->decoder.edges, (unsigned long long)channel->decoder.letters, (unsigned long long)channel->decoder.invalid,
+                nsPerFrame, nsPerFrame > 0 ? hopMs * 1e6 / nsPerFrame : 0, channel->recent.c_str());
+    }
+    fprintf(stderr, "\naudio      %.1f s at %u Hz%s, fft %d (%.1f Hz bins), hop %.2f ms\n", audioMs / 1000.0, format.sampleRate,
+            iq ? " I/Q" : "", fftSize, binHz, hopMs);
+    fprintf(stderr, "channels   %zu found, %zu at most at once\n", finished.size(), peakChannels);
+    fprintf(stderr, "threads    %u, %llu tasks stolen\n", pool.threads(), (unsigned long long)pool.steals());
+    fprintf(stderr, "time       %.1f ms wall (fft %.1f ms, channels %.1f ms), %.0fx real time\n", wallMs, fftNs / 1e6, channelNs / 1e6,
+            audioMs / (wallMs > 0 ? wallMs : 1e-3));
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef TEXT_TRACE_H
+#define TEXT_TRACE_H
+
+/*
+Text key-timing traces shared by the host harnesses (one command per line, '#' starts a comment, times in ms):
+    press 60      key held down for 60 ms, then released
+    gap 180       key left up for 180 ms ('wait' is accepted as well)
+    expect SOS    text the trace should decode to (used for accuracy)
+*/
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct TraceEdge { // A single change of the key pin at a point in time.
+    uint64_t timeMs; // time of the edge since the start of the trace
+    bool pressed; // level of the key after the edge
+};
+
+struct Trace { // Key edges and the text they are supposed to decode to.
+    std::vector<TraceEdge> edges;
+    std::string expected; // ground truth text (upper case)
+    uint64_t lengthMs = 0; // time of the end of the trace
+};
+
+// Reads a text trace file; edges start at 'startMs'. Exits on a malformed file.
+inline Trace load_trace(const char* path, uint64_t startMs) {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "cannot open trace %s\n", path);
+        exit(1);
+    }
+    Trace trace;
+    uint64_t now = startMs; // trace time cursor
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#')); // strips comments
+        std::istringstream words(line);
+        std::string command;
+        if (!(words >> command)) continue; // blank line
+        if (command == "expect") {
+            std::string text;
+            std::getline(words, text);
+            text.erase(0, text.find_first_not_of(' '));
+            for (char& c : text) c = toupper(c);
+            trace.expected += text;
+            continue;
+        }
+        uint64_t ms = 0;
+        if (!(words >> ms)) {
+            fprintf(stderr, "%s: bad line '%s'\n", path, line.c_str());
+            exit(1);
+        }
+        if (command == "press") {
+            trace.edges.push_back({ now, true });
+            trace.edges.push_back({ now + ms, false });
+        } else if (command != "gap" && command != "wait") {
+            fprintf(stderr, "%s: unknown command '%s'\n", path, command.c_str());
+            exit(1);
+        }
+        now += ms;
+    }
+    trace.lengthMs = now;
+    return trace;
+}
+
+#endif // TEXT_TRACE_H
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef TICK_DEBOUNCER_H
+#define TICK_DEBOUNCER_H
+
+/*
+The firmware's key debouncing for the host models: a PortDebouncer (lib/debouncer.h) sampled on
+the 1 ms ticks of the TickTimer interrupt, as in main.cpp.
+
+The host models jump from event to event instead of running every ms, so ticks are only run while
+a change of the watched lines is pending, i.e. from a change of the port until the debouncer has
+either accepted it or seen the line back at its debounced level. A tick in between would sample
+nothing new, so the edges and their times are the same as with a tick every ms.
+*/
+
+#include <cstdint>
+
+#include "../../lib/debouncer.h"
+
+class TickDebouncer { // A PortDebouncer and the ticks that sample it.
+    public:
+    PortDebouncer port; // debounced levels and the queued edges
+
+    // Debounces the lines in 'watched', all of them low at the start.
+    explicit TickDebouncer(uint8_t watched) {
+        port.watched = watched;
+        port.begin(0);
+    }
+
+    // The port reads 'levels' from 'time' (ms) on. Every tick before 'time' must have been run.
+    void set(uint64_t time, uint8_t levels) {
+        current = levels;
+        if (!sampling) {
+            sampling = true;
+            nextTick = time; // the tick of the change's own ms samples it first
+        }
+    }
+
+    // Whether a tick is needed at 'next_tick'.
+    bool pending() const { return sampling; }
+
+    // Time of the next tick that can change something (ms); only valid while 'pending'.
+    uint64_t next_tick() const { return nextTick; }
+
+    // Runs the tick at 'next_tick': one sample, as the interrupt takes it. Accepted edges are queued in 'port.edges'.
+    void tick() {
+        port.sample(current, nextTick);
+        nextTick++;
+        sampling = ((current ^ port.levels()) & port.watched) != 0; // back at the debounced level: the counters were just cleared
+    }
+
+    private:
+    uint8_t current = 0; // what the port reads now
+    bool sampling = false; // a change is pending
+    uint64_t nextTick = 0;
+};
+
+#endif // TICK_DEBOUNCER_H
\ No newline at end of file
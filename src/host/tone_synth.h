@@ -0,0 +1,152 @@
+#ifndef TONE_SYNTH_H
+#define TONE_SYNTH_H
+
+/*
+Keyed sine tone for the host tools: marks and spaces in, blocks of float samples out.
+
+Every key edge starts a raised-cosine ramp: the rise runs into the mark and the fall into the
+following space, so the tone has no clicks and every mark keeps its keyed length (measured between
+the half amplitude points). The sine is phase continuous over the whole output.
+
+The oscillator runs one vector lane per sample: each lane holds sin/cos of its own sample's phase and
+all lanes are rotated by the lane count at once, so a block costs a few multiply-adds per lane group
+(8 samples per instruction with AVX, 4 with SSE, scalar elsewhere; chosen at compile time as in
+goertzel.h). The phase is recomputed in double precision at the start of every block, so rounding
+errors do not add up over hours of audio.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define TONE_LANES 8
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define TONE_LANES 4
+#else
+#define TONE_LANES 1
+#endif
+
+const size_t TONE_BLOCK = 4096; // samples per block handed to the sink (a multiple of every lane width)
+
+class ToneSynth { // Renders marks and spaces as a keyed tone, a block at a time.
+    public:
+    uint64_t samples = 0; // samples handed to the sink so far
+
+    // 'riseMs' is the length of each ramp; marks and spaces shorter than it are keyed with shortened ramps.
+    ToneSynth(double sampleRate, double frequency, double amplitude, double riseMs)
+        : rate(sampleRate), step(2 * M_PI * frequency / sampleRate), amplitude((float)amplitude) {
+        size_t rise = std::max<size_t>(1, (size_t)std::lround(riseMs * sampleRate / 1000));
+        ramp.resize(rise);
+        for (size_t i = 0; i < rise; i++) {
+            ramp[i] = (float)(0.5 - 0.5 * cos(M_PI * (i + 0.5) / rise));
+        }
+        rampAt = rise; // silent until the first mark
+        for (int k = 0; k < TONE_LANES; k++) { // rotation of every lane by one group of samples
+            rotateSin[k] = (float)sin(step * TONE_LANES);
+            rotateCos[k] = (float)cos(step * TONE_LANES);
+        }
+    }
+
+    // Adds 'ms' of key down (tone) or key up (silence). Calls 'sink(samples, n)' for every finished block.
+    template <typename F> void key(bool down, double ms, F sink) {
+        endMs += ms;
+        uint64_t end = (uint64_t)std::llround(endMs * rate / 1000); // rounded from the running total, so lengths do not drift
+        while (position < end) {
+            size_t n = (size_t)std::min<uint64_t>(end - position, TONE_BLOCK - filled);
+            shape(down, n);
+            filled += n;
+            position += n;
+            if (filled == TONE_BLOCK) emit(sink);
+        }
+    }
+
+    // Hands out the last, partly filled block.
+    template <typename F> void flush(F sink) {
+        if (filled > 0) emit(sink);
+    }
+
+    private:
+    double rate; // samples per second
+    double step; // phase advance per sample (radians)
+    float amplitude; // peak level of the tone, 1 for full scale
+    std::vector<float> ramp; // raised-cosine rise, 0 to 1
+    alignas(32) float envelope[TONE_BLOCK]; // level of the tone for every sample of the block being filled
+    alignas(32) float block[TONE_BLOCK]; // finished samples
+    alignas(32) float rotateSin[TONE_LANES], rotateCos[TONE_LANES];
+    size_t filled = 0; // samples of 'envelope' written
+    uint64_t position = 0; // samples keyed so far
+    double endMs = 0; // end of the last mark or space
+    float level = 0; // envelope at the end of the last sample written
+    size_t rampAt = 0; // position within the current ramp, ramp.size() once it has finished
+    bool rising = false; // direction of the current ramp
+
+    // Writes 'n' envelope samples of a mark (down) or a space. A ramp starts at every edge, from whatever level was reached.
+    void shape(bool down, size_t n) {
+        if (down != rising) { // an edge: ramp from the current level to the other end
+            rising = down;
+            rampAt = start_of_ramp(level, down);
+        }
+        float* out = envelope + filled;
+        size_t i = 0;
+        for (; i < n && rampAt < ramp.size(); i++, rampAt++) {
+            out[i] = down ? ramp[rampAt] : ramp[ramp.size() - 1 - rampAt];
+        }
+        std::fill(out + i, out + n, down ? 1.0f : 0.0f);
+        level = n > 0 ? out[n - 1] : level;
+    }
+
+    // Index into the ramp that continues smoothly from 'from' (an edge that came before the previous ramp finished).
+    size_t start_of_ramp(float from, bool up) {
+        float target = up ? from : 1 - from;
+        return std::lower_bound(ramp.begin(), ramp.end(), target) - ramp.begin();
+    }
+
+    // Multiplies the envelope by the oscillator and hands the block to the sink.
+    template <typename F> void emit(F sink) {
+        double phase = fmod(step * (double)samples, 2 * M_PI); // exact phase of the first sample of the block
+        alignas(32) float s[TONE_LANES], c[TONE_LANES];
+        for (int k = 0; k < TONE_LANES; k++) {
+            s[k] = (float)sin(phase + step * k) * amplitude;
+            c[k] = (float)cos(phase + step * k) * amplitude;
+        }
+        size_t n = (filled + TONE_LANES - 1) / TONE_LANES * TONE_LANES;
+        std::fill(envelope + filled, envelope + n, 0.0f); // lanes past the end of a partial block
+#if TONE_LANES == 8
+        __m256 vs = _mm256_load_ps(s), vc = _mm256_load_ps(c);
+        __m256 rs = _mm256_load_ps(rotateSin), rc = _mm256_load_ps(rotateCos);
+        for (size_t i = 0; i < n; i += 8) {
+            _mm256_store_ps(block + i, _mm256_mul_ps(vs, _mm256_load_ps(envelope + i)));
+            __m256 ns = _mm256_add_ps(_mm256_mul_ps(vs, rc), _mm256_mul_ps(vc, rs));
+            vc = _mm256_sub_ps(_mm256_mul_ps(vc, rc), _mm256_mul_ps(vs, rs));
+            vs = ns;
+        }
+#elif TONE_LANES == 4
+        __m128 vs = _mm_load_ps(s), vc = _mm_load_ps(c);
+        __m128 rs = _mm_load_ps(rotateSin), rc = _mm_load_ps(rotateCos);
+        for (size_t i = 0; i < n; i += 4) {
+            _mm_store_ps(block + i, _mm_mul_ps(vs, _mm_load_ps(envelope + i)));
+            __m128 ns = _mm_add_ps(_mm_mul_ps(vs, rc), _mm_mul_ps(vc, rs));
+            vc = _mm_sub_ps(_mm_mul_ps(vc, rc), _mm_mul_ps(vs, rs));
+            vs = ns;
+        }
+#else
+        float vs = s[0], vc = c[0];
+        for (size_t i = 0; i < n; i++) {
+            block[i] = vs * envelope[i];
+            float ns = vs * rotateCos[0] + vc * rotateSin[0];
+            vc = vc * rotateCos[0] - vs * rotateSin[0];
+            vs = ns;
+        }
+#endif
+        sink((const float*)block, filled);
+        samples += filled;
+        filled = 0;
+    }
+};
+
+#endif // TONE_SYNTH_H
\ No newline at end of file
@@ -0,0 +1,182 @@
+/*
+Packs, inspects and replays binary key-timing traces (key_trace.h), built for the host by the
+'traces' environment:
+    pio run -e traces
+    .pio/build/traces/program pack corpus.ktr tools/traces/sos.trace [--operator NAME] [--wpm N]
+    .pio/build/traces/program info corpus.ktr
+    .pio/build/traces/program dump corpus.ktr [SESSION]
+    .pio/build/traces/program replay corpus.ktr [--threshold K]
+
+'pack' converts text traces (text_trace.h) into one .ktr file, a session per input, with the
+'expect' line as the ground truth text. 'dump' prints a session back as a text trace. 'replay' first
+walks every edge of the file without decoding, to show what parsing alone costs, then runs every
+session through the virtual-clock simulation of the firmware and reports decode speed and CER.
+Captures from the device are written by tools/telemetry_decode.py --capture.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "key_trace.h"
+#include "metrics.h"
+#include "simulation.h"
+#include "text_trace.h"
+
+void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s pack OUT.ktr TRACE... [--operator NAME] [--wpm N]\n"
+            "       %s info FILE.ktr\n"
+            "       %s dump FILE.ktr [SESSION]\n"
+            "       %s replay FILE.ktr [--threshold K]\n",
+            program, program, program, program);
+    exit(2);
+}
+
+int pack(int argc, char** argv) {
+    const char* out = nullptr;
+    std::vector<const char*> inputs;
+    std::string op;
+    double wpm = 0;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--operator" && i + 1 < argc) op = argv[++i];
+        else if (arg == "--wpm" && i + 1 < argc) wpm = atof(argv[++i]);
+        else if (arg[0] == '-') usage(argv[0]);
+        else if (!out) out = argv[i];
+        else inputs.push_back(argv[i]);
+    }
+    if (!out || inputs.empty()) usage(argv[0]);
+
+    KeyTraceWriter writer;
+    if (!writer.open(out)) {
+        fprintf(stderr, "%s\n", writer.error.c_str());
+        return 1;
+    }
+    for (const char* input : inputs) {
+        Trace trace = load_trace(input, 0);
+        std::vector<uint64_t> times;
+        for (const TraceEdge& edge : trace.edges) times.push_back(edge.timeMs);
+        std::string meta = "source=" + std::string(input) + "\n";
+        if (!op.empty()) meta += "operator=" + op + "\n";
+        if (wpm > 0) {
+            char value[32];
+            snprintf(value, sizeof(value), "%g", wpm);
+            meta += "wpm=" + std::string(value) + "\n";
+        }
+        if (!trace.expected.empty()) meta += "text=" + trace.expected + "\n";
+        if (!writer.add_session(meta, times, wpm)) {
+            fprintf(stderr, "%s: %s\n", input, writer.error.c_str());
+            return 1;
+        }
+    }
+    if (!writer.close()) {
+        fprintf(stderr, "%s: %s\n", out, writer.error.c_str());
+        return 1;
+    }
+    printf("wrote %zu sessions to %s\n", inputs.size(), out);
+    return 0;
+}
+
+int info(const KeyTraceFile& file) {
+    printf("%zu bytes, %u sessions, tick %u us\n", file.size, file.sessionCount, file.tickUs);
+    printf("%7s %8s %10s %9s %6s %-12s %s\n", "session", "edges", "bytes/edge", "length s", "WPM", "operator", "text");
+    for (uint32_t i = 0; i < file.sessionCount; i++) {
+        KeyTraceSession session = file.session(i);
+        printf("%7u %8u %10.2f %9.1f %6.1f %-12s %.40s\n", i, session.info.edgeCount,
+               session.info.edgeCount ? (double)session.info.edgesBytes / session.info.edgeCount : 0,
+               file.ms(session.info.durationTicks) / 1000, session.wpm(), session.get("operator", "-").c_str(),
+               session.get("text").c_str());
+    }
+    return 0;
+}
+
+int dump(const KeyTraceFile& file, uint32_t index) {
+    if (index >= file.sessionCount) {
+        fprintf(stderr, "no session %u (file has %u)\n", index, file.sessionCount);
+        return 1;
+    }
+    KeyTraceSession session = file.session(index);
+    std::string text = session.get("text");
+    if (!text.empty()) printf("expect %s\n", text.c_str());
+    KeyEdgeCursor cursor = session.edges();
+    KeyEdge edge;
+    double last = 0;
+    while (cursor.next(edge)) {
+        double time = file.ms(edge.time);
+        printf("%s %.0f\n", edge.pressed ? "gap" : "press", time - last); // a press edge ends a gap and vice versa
+        last = time;
+    }
+    return 0;
+}
+
+int replay(const KeyTraceFile& file, float threshold) {
+    // Parse only: how fast the edges come out of the mapping.
+    auto start = std::chrono::steady_clock::now();
+    uint64_t edges = 0, checksum = 0, bytes = 0;
+    for (uint32_t i = 0; i < file.sessionCount; i++) {
+        KeyTraceSession session = file.session(i);
+        KeyEdgeCursor cursor = session.edges();
+        KeyEdge edge;
+        while (cursor.next(edge)) {
+            checksum += edge.time;
+            edges++;
+        }
+        bytes += session.info.edgesBytes;
+    }
+    double parseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Full decode through the firmware's Button -> Decoder path.
+    start = std::chrono::steady_clock::now();
+    size_t errors = 0, expectedLength = 0;
+    double simulatedMs = 0;
+    for (uint32_t i = 0; i < file.sessionCount; i++) {
+        KeyTraceSession session = file.session(i);
+        Simulation simulation;
+        if (threshold >= 0) simulation.decoder.classifier.thresholdMultiplier = threshold;
+        KeyEdgeCursor cursor = session.edges();
+        KeyEdge edge;
+        while (cursor.next(edge)) simulation.key((uint64_t)file.ms(edge.time), edge.pressed);
+        simulation.advance_to((uint64_t)file.ms(session.info.durationTicks) + 3000);
+        simulatedMs += hostPlatform.now;
+        std::string expected = session.get("text");
+        if (expected.empty()) continue;
+        std::string decoded = simulation.decoded;
+        while (!decoded.empty() && decoded.back() == ' ') decoded.pop_back();
+        errors += edit_distance(expected, decoded);
+        expectedLength += expected.size();
+    }
+    double decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("sessions   %u, %llu edges, %.2f bytes/edge (checksum %llu)\n", file.sessionCount, (unsigned long long)edges,
+           edges ? (double)bytes / edges : 0, (unsigned long long)checksum);
+    printf("parse      %.2f ms, %.1f M edges/s, %.0f MB/s\n", parseMs, edges / (parseMs * 1e3), bytes / (parseMs * 1e3));
+    printf("decode     %.2f ms, %.1f M edges/s, %.0fx real time\n", decodeMs, edges / (decodeMs * 1e3), simulatedMs / decodeMs);
+    if (expectedLength) printf("accuracy   %zu edits over %zu characters, CER %.2f%%\n", errors, expectedLength, 100.0 * errors / expectedLength);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) usage(argv[0]);
+    std::string command = argv[1];
+    if (command == "pack") return pack(argc, argv);
+
+    KeyTraceFile file;
+    if (!file.open(argv[2])) {
+        fprintf(stderr, "%s: %s\n", argv[2], file.error.c_str());
+        return 1;
+    }
+    if (command == "info") return info(file);
+    if (command == "dump") return dump(file, argc > 3 ? (uint32_t)atoi(argv[3]) : 0);
+    if (command == "replay") {
+        float threshold = -1;
+        for (int i = 3; i < argc; i++) {
+            if (std::string(argv[i]) == "--threshold" && i + 1 < argc) threshold = atof(argv[++i]);
+            else usage(argv[0]);
+        }
+        return replay(file, threshold);
+    }
+    usage(argv[0]);
+}
\ No newline at end of file
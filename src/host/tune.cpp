@@ -0,0 +1,287 @@
+/*
+Searches the decoder's hand-picked constants for the values that decode a recorded trace corpus
+best, built for the host by the 'tune' environment:
+    pio run -e tune && .pio/build/tune/program traces/ [more files or directories] --out lib/tuning.h
+
+Tuned: the classifier's thresholdMultiplier, shortPressCap, longPressCap and the decoder's
+wordGapMultiplier, all read by the firmware from lib/tuning.h. Debouncing is not tuned: sessions go
+through the firmware's fixed 4-sample debouncer (key_decoder.h). The search is a grid over
+each parameter's range, then repeated on a grid half as wide around the best candidate for every
+further round. A candidate's score is the total edit distance over the corpus (ties go to the one
+closer to the current constants). Candidates are evaluated concurrently on a work-stealing pool
+against sessions parsed into memory once (corpus.h).
+
+With --holdout N every Nth session is left out of the search and only used to report how the
+result does on keying it was not tuned on. With --clean, candidates that decode a corpus of exactly
+timed keying worse than the current constants are rejected, whatever they gain on the rest. No header
+is written if the sweep ends on the current constants.
+
+Options:
+    --out FILE          write the tuned constants as a header (lib/tuning.h for the firmware), with the
+                        command that made them and the resulting CER in its comment
+    --source TEXT       how the corpus was made (e.g. its keygen command), noted in the header; repeatable
+    --clean PATH        clean keying no candidate may decode worse than the current constants; repeatable
+    --steps N           grid points per parameter and round (default 4)
+    --rounds N          refinement rounds (default 3)
+    --holdout N         leave every Nth session out of the search (default 0: use all)
+    --threads N         worker threads including the main one (default: one per core)
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "corpus.h"
+#include "work_pool.h"
+
+const int PARAMETER_COUNT = 4;
+
+struct ParameterRange { // Where a parameter is searched, and how finely its values are rounded.
+    const char* name;
+    double low, high;
+    double resolution;
+};
+
+const ParameterRange RANGES[PARAMETER_COUNT] = {
+    { "thresholdMultiplier", 0.0, 3.0, 0.05 },
+    { "shortPressCap", 20, 200, 1 },
+    { "longPressCap", 100, 600, 1 },
+    { "wordGapMultiplier", 1.2, 4.0, 0.05 },
+};
+
+typedef std::vector<double> Candidate; // one value per entry of RANGES
+
+Candidate from_parameters(const DecoderParameters& p) {
+    return { p.thresholdMultiplier, (double)p.shortPressCap, (double)p.longPressCap, p.wordGapMultiplier };
+}
+
+DecoderParameters to_parameters(const Candidate& c) {
+    DecoderParameters p;
+    p.thresholdMultiplier = (float)c[0];
+    p.shortPressCap = (int)c[1];
+    p.longPressCap = (int)c[2];
+    p.wordGapMultiplier = (float)c[3];
+    return p;
+}
+
+// Distance from the current constants, relative to each range; breaks ties between equal scores.
+double distance(const Candidate& a, const Candidate& b) {
+    double sum = 0;
+    for (int i = 0; i < PARAMETER_COUNT; i++) {
+        double d = (a[i] - b[i]) / (RANGES[i].high - RANGES[i].low);
+        sum += d * d;
+    }
+    return sum;
+}
+
+// Total edit distance of 'candidate' over 'sessions'.
+size_t evaluate(const std::vector<const CorpusSession*>& sessions, const Candidate& candidate) {
+    DecoderParameters parameters = to_parameters(candidate);
+    size_t edits = 0;
+    for (const CorpusSession* session : sessions) edits += decode_session(*session, parameters).edits;
+    return edits;
+}
+
+// Writes the constants in the layout of lib/tuning.h.
+// 'source' is empty or a "Corpus:" paragraph, 'command' the sweep's command line, 'origin' how the result scored.
+bool write_header(const char* path, const DecoderParameters& p, const std::string& source, const std::string& command,
+                  const std::string& origin) {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+    fprintf(out,
+            "#ifndef TUNING_H\n"
+            "#define TUNING_H\n\n"
+            "/*\n"
+            "Decoder constants, generated by the tuning sweep over a trace corpus (src/host/tune.cpp).\n"
+            "%s"
+            "Sweep:\n"
+            "    %s\n"
+            "%s\n"
+            "*/\n\n"
+            "constexpr float TUNED_THRESHOLD_MULTIPLIER = %.2ff; // standard deviations above the average press that still count as short, once dits and dahs were seen\n"
+            "constexpr int TUNED_SHORT_PRESS_CAP = %d; // ms, presses shorter than this are always short\n"
+            "constexpr int TUNED_LONG_PRESS_CAP = %d; // ms, letter gap threshold before any press has been seen\n"
+            "constexpr float TUNED_WORD_GAP_MULTIPLIER = %.2ff; // word gap threshold relative to the letter gap threshold\n\n"
+            "#endif // TUNING_H",
+            source.c_str(), command.c_str(), origin.c_str(), p.thresholdMultiplier, p.shortPressCap, p.longPressCap, p.wordGapMultiplier);
+    return fclose(out) == 0;
+}
+
+void usage(const char* program) {
+    fprintf(stderr, "usage: %s PATH... [--out FILE] [--source TEXT] [--clean PATH] [--steps N] [--rounds N] [--holdout N] [--threads N]\n",
+            program);
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths, cleanPaths;
+    const char* out = nullptr;
+    std::string source; // how the corpora were made, for the header
+    std::string command = "pio run -e tune && .pio/build/tune/program"; // the sweep's command line, for the header
+    int steps = 4, rounds = 3, holdout = 0;
+    unsigned threads = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool more = i + 1 < argc;
+        int first = i; // the option, then its value if it takes one
+        if (arg == "--out" && more) out = argv[++i];
+        else if (arg == "--source" && more) {
+            source += std::string(source.empty() ? "Corpus:\n" : "") + "    " + argv[++i] + "\n";
+            continue; // only a note, not needed to repeat the sweep
+        }
+        else if (arg == "--clean" && more) cleanPaths.push_back(argv[++i]);
+        else if (arg == "--steps" && more) steps = atoi(argv[++i]);
+        else if (arg == "--rounds" && more) rounds = atoi(argv[++i]);
+        else if (arg == "--holdout" && more) holdout = atoi(argv[++i]);
+        else if (arg == "--threads" && more) threads = (unsigned)atoi(argv[++i]);
+        else if (arg[0] == '-') usage(argv[0]);
+        else paths.push_back(arg);
+        for (int j = first; j <= i; j++) command += std::string(" ") + argv[j];
+    }
+    if (paths.empty() || steps < 2 || rounds < 1 || holdout < 0 || holdout == 1) usage(argv[0]);
+
+    Corpus corpus, clean;
+    for (const std::string& path : paths) {
+        if (!corpus.add(path)) {
+            fprintf(stderr, "%s\n", corpus.error.c_str());
+            return 1;
+        }
+    }
+    for (const std::string& path : cleanPaths) {
+        if (!clean.add(path)) {
+            fprintf(stderr, "%s\n", clean.error.c_str());
+            return 1;
+        }
+    }
+    corpus.cache(); // every candidate replays every session
+    clean.cache();
+    std::vector<const CorpusSession*> guard;
+    for (const CorpusSession& session : clean.sessions) guard.push_back(&session);
+    std::vector<const CorpusSession*> training, validation;
+    size_t trainingCharacters = 0, validationCharacters = 0;
+    for (size_t i = 0; i < corpus.sessions.size(); i++) {
+        bool heldOut = holdout > 0 && i % holdout == (size_t)holdout - 1;
+        (heldOut ? validation : training).push_back(&corpus.sessions[i]);
+        (heldOut ? validationCharacters : trainingCharacters) += corpus.sessions[i].expected.size();
+    }
+    if (training.empty()) {
+        fprintf(stderr, "no sessions with ground truth text found\n");
+        return 1;
+    }
+    printf("corpus     %zu sessions, %zu characters (%zu sessions held out)\n", corpus.sessions.size(), corpus.characters,
+           validation.size());
+
+    const Candidate current = from_parameters(DecoderParameters());
+    std::map<Candidate, size_t> scores; // every candidate evaluated so far
+    scores[current] = evaluate(training, current);
+    Candidate best = current;
+    size_t bestEdits = scores[current];
+    printf("current    %zu edits, CER %.2f%%\n", bestEdits, 100.0 * bestEdits / trainingCharacters);
+    const size_t guardLimit = evaluate(guard, current); // edits on clean keying no candidate may exceed
+    if (!guard.empty()) {
+        printf("clean      %zu sessions, %zu edits, CER %.2f%%\n", guard.size(), guardLimit, 100.0 * guardLimit / clean.characters);
+    }
+
+    WorkPool pool(threads);
+    double width[PARAMETER_COUNT]; // grid span of every parameter in this round
+    for (int i = 0; i < PARAMETER_COUNT; i++) width[i] = RANGES[i].high - RANGES[i].low;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        // Grid values of every parameter, centred on the best so far and kept inside the range.
+        std::vector<double> axes[PARAMETER_COUNT];
+        for (int i = 0; i < PARAMETER_COUNT; i++) {
+            const ParameterRange& range = RANGES[i];
+            double low = std::max(range.low, std::min(range.high - width[i], best[i] - width[i] / 2));
+            for (int s = 0; s < steps; s++) {
+                double value = low + width[i] * s / (steps - 1);
+                value = std::round(value / range.resolution) * range.resolution;
+                if (axes[i].empty() || value != axes[i].back()) axes[i].push_back(value);
+            }
+        }
+        std::vector<Candidate> candidates;
+        Candidate candidate(PARAMETER_COUNT);
+        std::function<void(int)> expand = [&](int axis) {
+            if (axis == PARAMETER_COUNT) {
+                if (candidate[1] < candidate[2] && !scores.count(candidate)) candidates.push_back(candidate); // short cap below long cap
+                return;
+            }
+            for (double value : axes[axis]) {
+                candidate[axis] = value;
+                expand(axis + 1);
+            }
+        };
+        expand(0);
+
+        std::vector<size_t> edits(candidates.size());
+        std::vector<char> rejected(candidates.size()); // worse on clean keying
+        std::vector<WorkPool::Task> tasks;
+        for (size_t c = 0; c < candidates.size(); c++) {
+            tasks.push_back([&, c] {
+                rejected[c] = evaluate(guard, candidates[c]) > guardLimit;
+                edits[c] = rejected[c] ? 0 : evaluate(training, candidates[c]);
+            });
+        }
+        pool.run(tasks);
+
+        size_t rejections = 0;
+        for (size_t c = 0; c < candidates.size(); c++) {
+            if (rejected[c]) {
+                scores[candidates[c]] = SIZE_MAX; // never evaluated again
+                rejections++;
+                continue;
+            }
+            scores[candidates[c]] = edits[c];
+            bool better = edits[c] < bestEdits || (edits[c] == bestEdits && distance(candidates[c], current) < distance(best, current));
+            if (better) {
+                best = candidates[c];
+                bestEdits = edits[c];
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("round %d    %zu candidates (%zu worse on clean keying), best %zu edits, CER %.2f%% (%.1f s)\n", round + 1,
+               candidates.size(), rejections, bestEdits, 100.0 * bestEdits / trainingCharacters, seconds);
+        for (int i = 0; i < PARAMETER_COUNT; i++) width[i] /= 2;
+    }
+
+    printf("\n%-20s %9s %9s\n", "parameter", "current", "tuned");
+    for (int i = 0; i < PARAMETER_COUNT; i++) printf("%-20s %9g %9g\n", RANGES[i].name, current[i], best[i]);
+    char origin[512];
+    int length = snprintf(origin, sizeof(origin), "Tuned on %zu sessions, %zu characters: CER %.2f%% (previous constants: %.2f%%).",
+                          training.size(), trainingCharacters, 100.0 * bestEdits / trainingCharacters,
+                          100.0 * scores[current] / trainingCharacters);
+    if (!validation.empty()) {
+        size_t before = evaluate(validation, current), after = evaluate(validation, best);
+        printf("\nheld out   CER %.2f%% with the current constants, %.2f%% tuned\n", 100.0 * before / validationCharacters,
+               100.0 * after / validationCharacters);
+        snprintf(origin + length, sizeof(origin) - length, "\nHeld out %zu sessions, %zu characters: CER %.2f%% (previous constants: %.2f%%).",
+                 validation.size(), validationCharacters, 100.0 * after / validationCharacters, 100.0 * before / validationCharacters);
+    }
+    if (!guard.empty()) {
+        size_t after = evaluate(guard, best);
+        printf("clean      CER %.2f%% with the current constants, %.2f%% tuned\n", 100.0 * guardLimit / clean.characters,
+               100.0 * after / clean.characters);
+        length = strlen(origin);
+        snprintf(origin + length, sizeof(origin) - length, "\nClean keying, %zu sessions, %zu characters: CER %.2f%% (previous constants: %.2f%%).",
+                 guard.size(), clean.characters, 100.0 * after / clean.characters, 100.0 * guardLimit / clean.characters);
+    }
+    if (out && best == current) {
+        printf("\nno better constants found, %s not written\n", out);
+        return 0;
+    }
+    if (out) {
+        if (!write_header(out, to_parameters(best), source, command, origin)) {
+            fprintf(stderr, "cannot write %s\n", out);
+            return 1;
+        }
+        printf("\nwrote %s\n", out);
+    }
+    return 0;
+}
\ No newline at end of file
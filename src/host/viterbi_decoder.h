@@ -0,0 +1,338 @@
+#ifndef VITERBI_DECODER_H
+#define VITERBI_DECODER_H
+
+/*
+Soft-decision decoder for the host: instead of classifying every press and release on its own and
+committing to it (Classifier), it keeps the most likely readings of the whole keying so far and
+lets later elements and the letter model decide between them.
+
+Hidden state after every mark or space:
+    node    position in the Morse tree of the firmware's letter table (lib/morse_code.h)
+    speed   length of a unit, on a log grid from 20 ms (60 WPM) to 300 ms (4 WPM); it may step to
+            a neighbour at every mark, so drifting speed is followed
+    prev    the letter before (or a space), for the bigram letter model
+Observations are log-normally distributed around their nominal length in units: marks at 1 (dit) or
+3 (dah), spaces at 1 (within the letter), 3 (letter gap) or 7 (word gap, any longer pause counts the
+same). A letter gap moves from a letter's node back to the root and adds log P(letter | prev); nodes
+that are not a letter cannot end one, so a misjudged element is resolved by whichever reading makes a
+letter and a likely one, never by '?'.
+
+Viterbi with a beam: equal states are merged keeping the best, and only the 'beam' best states (and
+none worse than 'beamWidth' below the best) survive each step. The decoded text of every state is a
+chain in an arena that grows with the session; create a decoder per session or stream.
+
+Presses and releases shorter than 'glitchMs' are treated as contact bounce and merged into their
+surroundings.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../../lib/morse_code.h"
+
+const int VITERBI_SPACE = 26; // 'letter' index of a word gap in the letter model
+
+class LetterModel { // Bigram model over 26 letters and the word gap, with add-one smoothing.
+    public:
+    float logProbability[27][27]; // [previous][next]
+
+    LetterModel() {
+        train(DEFAULT_TEXT);
+    }
+
+    // Replaces the model by the bigram counts of 'text' (letters and spaces, other characters ignored).
+    void train(const std::string& text) {
+        double counts[27][27];
+        for (auto& row : counts) std::fill(row, row + 27, 1.0);
+        int previous = VITERBI_SPACE;
+        for (char c : text) {
+            int index = symbol(c);
+            if (index < 0 || (index == VITERBI_SPACE && previous == VITERBI_SPACE)) continue;
+            counts[previous][index]++;
+            previous = index;
+        }
+        for (int p = 0; p < 27; p++) {
+            double total = 0;
+            for (int n = 0; n < 27; n++) total += counts[p][n];
+            for (int n = 0; n < 27; n++) logProbability[p][n] = (float)std::log(counts[p][n] / total);
+        }
+    }
+
+    // Letter index 0-25, VITERBI_SPACE for whitespace, -1 for anything else.
+    static int symbol(char c) {
+        if (c >= 'a' && c <= 'z') return c - 'a';
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c == ' ' || c == '\n' || c == '\t') return VITERBI_SPACE;
+        return -1;
+    }
+
+    private:
+    static constexpr const char* DEFAULT_TEXT = // learned at construction until train() is given better text: everyday English and common on-air exchanges
+        "the quick brown fox jumps over the lazy dog and then it was time for all of us to go home "
+        "there is no place like the one where you were born but many people move away when they are young "
+        "what would you like to know about the weather here it has been cold with some rain and wind "
+        "thank you for the call my name is john and my station is in the north of the city "
+        "the rig is a small one at five watts and the antenna is a wire in the trees "
+        "cq cq cq de this is a test please copy your signal is good here "
+        "name qth rst tnx fer call hope to meet again best regards to you and your family "
+        "we have been working on the problem for some time and think that we now know what to do "
+        "which of these would you say is the most important for the people who live here "
+        "if you can hear me please answer and tell me how my signal sounds over there "
+        "she said that she would write a letter to her friend in the morning before work "
+        "every day we learn something new and every night we sleep a little better for it";
+};
+
+struct ViterbiSettings {
+    int beam = 64; // states kept after every step
+    float beamWidth = 25; // states this far (log likelihood) below the best are dropped
+    float markSigma = 0.25f; // spread of log mark lengths around the nominal
+    float spaceSigma = 0.35f; // spread of log space lengths (keyers are sloppier between elements)
+    float dahUnits = 3;
+    float speedStep = 1.06f; // ratio between neighbouring points of the speed grid
+    float speedChange = 0.05f; // probability of stepping to each neighbour speed at a mark
+    float letterModelWeight = 1; // scales the bigram log probabilities
+    unsigned long glitchMs = 10; // shorter presses and releases are contact bounce
+};
+
+class ViterbiDecoder { // Beam-limited Viterbi decoding of key edges into text.
+    public:
+    ViterbiSettings settings;
+    LetterModel model;
+    uint64_t steps = 0; // marks and spaces decoded
+    uint64_t statesExpanded = 0;
+
+    explicit ViterbiDecoder(const ViterbiSettings& settings = ViterbiSettings()) : settings(settings) {
+        build_tree();
+        for (double unit = 20; unit <= 300; unit *= settings.speedStep) logUnits.push_back((float)std::log(unit));
+        reset();
+    }
+
+    // Starts over with no keying seen.
+    void reset() {
+        arena.clear();
+        beam.clear();
+        for (size_t s = 0; s < logUnits.size(); s++) beam.push_back({ 0, 0, (uint8_t)s, VITERBI_SPACE, -1 });
+        hasSegment = hasPrevious = false;
+    }
+
+    // The key is at 'pressed' from 'time' (ms) on.
+    void key(uint64_t time, bool pressed) {
+        if (!hasSegment) { // the first edge only starts the first segment (keying starts with a press)
+            if (!pressed) return;
+            segmentStart = time;
+            segmentPressed = true;
+            hasSegment = true;
+            return;
+        }
+        if (pressed == segmentPressed) return;
+        uint64_t duration = time - segmentStart;
+        if (duration < settings.glitchMs && hasPrevious) { // bounce: the previous segment goes on
+            segmentStart = previousStart;
+            segmentPressed = previousPressed;
+            hasPrevious = false;
+            return;
+        }
+        if (hasPrevious) observe(previousPressed, (float)(segmentStart - previousStart));
+        previousStart = segmentStart;
+        previousPressed = segmentPressed;
+        hasPrevious = true;
+        segmentStart = time;
+        segmentPressed = pressed;
+    }
+
+    // Ends the keying at 'time': the last mark is observed and the last letter completed.
+    void finish(uint64_t time) {
+        if (hasPrevious) observe(previousPressed, (float)(segmentStart - previousStart));
+        if (hasSegment && segmentPressed && time > segmentStart) observe(true, (float)(time - segmentStart));
+        hasSegment = hasPrevious = false;
+        std::vector<Hypothesis> closed;
+        for (const Hypothesis& h : beam) {
+            if (h.node == 0) { // nothing open
+                closed.push_back(h);
+                continue;
+            }
+            if (!tree[h.node].letter) continue;
+            Hypothesis next = h;
+            emit(next, tree[h.node].letter, true);
+            closed.push_back(next);
+        }
+        if (!closed.empty()) beam.swap(closed);
+    }
+
+    // Most likely text so far (letters completed by a letter gap).
+    std::string text() const {
+        if (beam.empty()) return "";
+        const Hypothesis* best = &beam[0];
+        for (const Hypothesis& h : beam) {
+            if (h.score > best->score) best = &h;
+        }
+        std::string result;
+        for (int32_t i = best->tail; i >= 0; i = arena[i].parent) result += arena[i].c;
+        std::reverse(result.begin(), result.end());
+        while (!result.empty() && result.back() == ' ') result.pop_back();
+        return result;
+    }
+
+    // Unit length (ms) of the most likely state, i.e. the speed the decoder believes in.
+    float unit_ms() const {
+        const Hypothesis* best = &beam[0];
+        for (const Hypothesis& h : beam) {
+            if (h.score > best->score) best = &h;
+        }
+        return std::exp(logUnits[best->speed]);
+    }
+
+    private:
+    struct TreeNode {
+        int8_t child[2] = { -1, -1 }; // after a dit / a dah
+        char letter = 0;
+    };
+
+    struct Hypothesis {
+        float score; // log likelihood
+        uint8_t node; // position in the tree, 0 at the start of a letter
+        uint8_t speed; // index into logUnits
+        uint8_t prev; // previous letter or VITERBI_SPACE
+        int32_t tail; // last decoded character in the arena, -1 for none
+    };
+
+    struct Emitted {
+        char c;
+        int32_t parent;
+    };
+
+    std::vector<TreeNode> tree;
+    std::vector<float> logUnits;
+    std::vector<Hypothesis> beam, candidates;
+    std::vector<Emitted> arena;
+    std::unordered_map<uint32_t, size_t> merged; // state -> its index in 'candidates'
+
+    bool hasSegment = false, segmentPressed = false; // segment in progress
+    uint64_t segmentStart = 0;
+    bool hasPrevious = false, previousPressed = false; // last finished segment, held back until it is clear it was no glitch
+    uint64_t previousStart = 0;
+
+    void build_tree() {
+        tree.assign(1, TreeNode());
+        for (int i = 0; i < 26; i++) {
+            int node = 0;
+            for (int j = 0; validPatterns[i][j]; j++) {
+                int element = validPatterns[i][j] == '1';
+                if (tree[node].child[element] < 0) {
+                    tree[node].child[element] = (int8_t)tree.size();
+                    tree.push_back(TreeNode());
+                }
+                node = tree[node].child[element];
+            }
+            tree[node].letter = (char)('A' + i);
+        }
+    }
+
+    // Log likelihood (without constant terms) of a duration with log 'logDuration' at 'units' times the unit.
+    static float emission(float logDuration, float logUnit, float units, float sigma) {
+        float z = (logDuration - logUnit - std::log(units)) / sigma;
+        return -0.5f * z * z;
+    }
+
+    // Completes the letter 'letter' in 'h', followed by a word gap if 'wordEnd'.
+    void emit(Hypothesis& h, char letter, bool wordEnd) {
+        int index = letter - 'A';
+        h.score += settings.letterModelWeight * model.logProbability[h.prev][index];
+        arena.push_back({ letter, h.tail });
+        h.tail = (int32_t)arena.size() - 1;
+        h.prev = (uint8_t)index;
+        h.node = 0;
+        if (wordEnd) {
+            h.score += settings.letterModelWeight * model.logProbability[index][VITERBI_SPACE];
+            arena.push_back({ ' ', h.tail });
+            h.tail = (int32_t)arena.size() - 1;
+            h.prev = VITERBI_SPACE;
+        }
+    }
+
+    // Keeps the better of two hypotheses for the same state.
+    void add(const Hypothesis& h) {
+        uint32_t state = h.node | (uint32_t)h.speed << 8 | (uint32_t)h.prev << 16;
+        auto found = merged.find(state);
+        if (found == merged.end()) {
+            merged.emplace(state, candidates.size());
+            candidates.push_back(h);
+        } else if (h.score > candidates[found->second].score) {
+            candidates[found->second] = h;
+        }
+    }
+
+    void observe(bool mark, float durationMs) {
+        steps++;
+        float logDuration = std::log(std::max(durationMs, 1.0f));
+        float logStay = std::log(1 - 2 * settings.speedChange), logMove = std::log(settings.speedChange);
+        candidates.clear();
+        merged.clear();
+        for (const Hypothesis& h : beam) {
+            statesExpanded++;
+            if (mark) {
+                for (int move = -1; move <= 1; move++) {
+                    int speed = h.speed + move;
+                    if (speed < 0 || speed >= (int)logUnits.size()) continue;
+                    for (int element = 0; element < 2; element++) {
+                        int child = tree[h.node].child[element];
+                        if (child < 0) continue;
+                        Hypothesis next = h;
+                        next.node = (uint8_t)child;
+                        next.speed = (uint8_t)speed;
+                        next.score += (move ? logMove : logStay) +
+                                      emission(logDuration, logUnits[speed], element ? settings.dahUnits : 1, settings.markSigma);
+                        add(next);
+                    }
+                }
+                continue;
+            }
+            float logUnit = logUnits[h.speed];
+            if (h.node == 0) { // pause before any mark of the session, or after a completed letter at the end: nothing to decide
+                add(h);
+                continue;
+            }
+            Hypothesis next = h; // within the letter
+            next.score += emission(logDuration, logUnit, 1, settings.spaceSigma);
+            add(next);
+            char letter = tree[h.node].letter;
+            if (!letter) continue; // only a letter can be ended
+            next = h;
+            next.score += emission(logDuration, logUnit, 3, settings.spaceSigma);
+            emit(next, letter, false);
+            add(next);
+            next = h;
+            next.score += emission(std::min(logDuration, logUnit + std::log(7.0f)), logUnit, 7, settings.spaceSigma); // longer pauses are no less likely a word gap
+            emit(next, letter, true);
+            add(next);
+        }
+        if (candidates.empty()) { // the keying fits no letter (e.g. six elements): start afresh from the best state
+            Hypothesis best = beam[0];
+            for (const Hypothesis& h : beam) {
+                if (h.score > best.score) best = h;
+            }
+            best.node = 0;
+            candidates.push_back(best);
+        }
+        prune();
+    }
+
+    void prune() {
+        size_t keep = std::min(candidates.size(), (size_t)settings.beam);
+        std::partial_sort(candidates.begin(), candidates.begin() + keep, candidates.end(),
+                          [](const Hypothesis& a, const Hypothesis& b) { return a.score > b.score; });
+        float floor = candidates[0].score - settings.beamWidth;
+        beam.clear();
+        for (size_t i = 0; i < keep && candidates[i].score >= floor; i++) {
+            Hypothesis h = candidates[i];
+            h.score -= candidates[0].score; // keeps the scores near zero over long streams
+            beam.push_back(h);
+        }
+    }
+};
+
+#endif // VITERBI_DECODER_H
\ No newline at end of file
@@ -0,0 +1,129 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+/*
+Work-stealing thread pool for the host tools.
+
+Every worker owns a deque of tasks. It takes work from the back of its own deque (most recently
+queued, still warm in cache) and, when that runs dry, steals from the front of another worker's deque,
+so uneven tasks (e.g. busy and idle channels) even out without a central queue. 'run' hands out a
+batch and waits for all of it; the calling thread helps out instead of sleeping.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkPool { // Runs batches of independent tasks on all cores.
+    public:
+    typedef std::function<void()> Task;
+
+    // Starts 'threads' workers (0 = one per core, counting the caller).
+    explicit WorkPool(unsigned threads = 0) {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        for (unsigned i = 0; i < threads; i++) queues.emplace_back(new Queue());
+        for (unsigned i = 1; i < threads; i++) workers.emplace_back([this, i] { work(i); }); // queue 0 belongs to the caller
+    }
+
+    ~WorkPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    unsigned threads() const {
+        return (unsigned)queues.size();
+    }
+
+    // Runs every task and returns when all have finished. Tasks are dealt round-robin, then balanced by stealing.
+    void run(std::vector<Task>& tasks) {
+        if (tasks.empty()) return;
+        pending.fetch_add(tasks.size());
+        for (size_t i = 0; i < tasks.size(); i++) {
+            Queue& queue = *queues[i % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(tasks[i]));
+        }
+        tasks.clear();
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            generation++;
+        }
+        wake.notify_all();
+        while (pending.load() > 0) { // the caller works as worker 0 until the batch is done
+            if (!run_one(0)) std::this_thread::yield();
+        }
+    }
+
+    // Tasks a thread took from another thread's queue since the pool was created.
+    uint64_t steals() const {
+        return stolen.load();
+    }
+
+    private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; // one per thread, index 0 is the caller of 'run'
+    std::vector<std::thread> workers;
+    std::atomic<size_t> pending{0}; // tasks of the current batch not finished yet
+    std::atomic<uint64_t> stolen{0};
+    std::mutex sleepMutex; // guards 'generation' and 'stopping' for the condition variable
+    std::condition_variable wake;
+    uint64_t generation = 0; // bumped for every batch so idle workers wake up
+    bool stopping = false;
+
+    // Runs one task from thread 'self' (own queue first, then stolen). Returns false if there was nothing to do.
+    bool run_one(unsigned self) {
+        Task task;
+        {
+            Queue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+            }
+        }
+        for (unsigned i = 1; !task && i < queues.size(); i++) {
+            Queue& victim = *queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                stolen++;
+            }
+        }
+        if (!task) return false;
+        task();
+        pending--;
+        return true;
+    }
+
+    // Worker loop: drains work while there is any, then sleeps until the next batch.
+    void work(unsigned self) {
+        uint64_t seen = 0; // last batch this worker woke up for
+        while (true) {
+            while (run_one(self)) {
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+    }
+};
+
+#endif // WORK_POOL_H
\ No newline at end of file
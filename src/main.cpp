@@ -29,93 +29,390 @@ The circuit (Button & RGB light):
 
 // All libraries are installed from PlatformIO libraries onto the project (not sys dependent)
 #include <Arduino.h>
-#include <LiquidCrystal.h>
 #include <avr/pgmspace.h>
 
 #include "../lib/button.h"
+#include "../lib/debouncer.h"
+#include "../lib/decoder.h"
 #include "../lib/display.h"
-#include "../lib/morse_code.h"
+#include "../lib/hal.h"
+#include "../lib/keyer.h"
+#include "../lib/lcd.h"
+#include "../lib/log.h"
+#include "../lib/loop_monitor.h"
+#include "../lib/memory_stats.h"
+#include "../lib/power.h"
+#include "../lib/profile.h"
 #include "../lib/rgb.h"
+#include "../lib/scheduler.h"
+#include "../lib/telemetry.h"
+#include "../lib/timing_store.h"
+#include "../lib/word_corrector.h"
 
-using namespace std;
-
-struct PinConfiguation { // Objects specific to the board's I/O pin layout and configuration.
-  // Defining the variables for the digital pin I/O on LCD and RGB light.
-  const int rs = 12, en = 11, d4 = 5, d5 = 4, d6 = 3, d7 = 2;
-  // Defining the variables for the digital pin I/O on RGB & Button.
-  const int pushButton = 7, r = 10, g = 9, b = 6;
-} pin;
-
-const int MAX_LCD_SLOTS = 17; // the max amount of slots for a single lcd row
-struct LcdConfiguration { // Sets up the LCD to have predefined lines for buffering
-  char line0[MAX_LCD_SLOTS] = ""; // Array containing characters which will be displayed on the first row of the lcd.
-  char line1[MAX_LCD_SLOTS] = ""; // Array containing characters which will be displayed on the second row of the lcd.
-} lcd_config;
-LiquidCrystal lcd(pin.rs, pin.en, pin.d4, pin.d5, pin.d6, pin.d7); // Defines the lcd based on its pins. 
-
-const int MAX_INPUT_SIZE = 5; // Max input size for morse code (4), which includes the buffer (1)
-struct InputArrays { // Contains the arrays which stores user input as well as duration array of short and long presses.
-  char userInput[MAX_INPUT_SIZE] = "";  // Stores the user's combination of short and long presses as a single morse code input.
-  int pressDurations[MAX_INPUT_SIZE - 1] = {}; // Stores the duration of the user's presses.
-  int releaseDurations[MAX_INPUT_SIZE - 1] = {}; // Stores the duration of the user's releases.
-} store;
-
-void check_input() { // Based on 'check_press' vars, defines the different durations of presses/releases
-  // Logic to process Morse code input and determine if it's a short or long press
-  button.avgPressDuration = averageArray(pressDurations); // calculates avg durations
-  button.avgReleaseDuration = averageArray(releaseDurations); // ...
-  button.stdPressDuration = stdArray(pressDurations, button.avgPressDuration); // calculates standard deviation durations based on calculated avg
-  button.stdReleaseDuration = stdArray(releaseDurations, button.avgReleaseDuration); // ... 
-  
-  float thresholdMultiplier = 1.5; // threshold for standard deviation (tunable)
-
-  // Determine whether or not the current press is short or long
-  if (button.pressDuration <= button.avgPressDuration + thresholdMultiplier * button.stdPressDuration || button.pressDuration < button.shortPressCap) {
-    addToMorseCode(morseCodeInput, button.shortPress); // short press
-  } else if (button.pressDuration <= button.avgPressDuration + thresholdMultiplier * button.stdPressDuration || button.shortPressCap < button.pressDuration < button.longPressCap) {
-    addToMorseCode(morseCodeInput, button.longPress); // long press
-  }
-
-  char morseCheckResult = getLetterFromMorse(morseCodeInput); // checks the returned char from the function (actual char if correct code; '?' if not)
-  // Determine if the release duration indicates the end of a press vs character
-  if ((button.releaseDuration > button.avgReleaseDuration + thresholdMultiplier * button.stdReleaseDuration || strlen(morseCodeInput) == MAX_INPUT_SIZE - 1) & morseCheckResult != '?') {
-    // Long release duration is for a pause between character inputs (different from individual press)
-    userOutput.morseCodeOutput += morseCheckResult; // convert the current morse code to a letter based on pattern of morse code that was input into ''morseCodeInput' array
-    set_color(LOW, HIGH, LOW); // sets rgb light to green if a valid morse code combination was detected
-    clear_input(); // Clear the input to start the next character
+// Board wiring (see the circuit above) as pin types (lib/hal.h): each access is a single port instruction.
+typedef Pin<PORT_B, 4> LcdRs; // D12
+typedef Pin<PORT_B, 3> LcdEnable; // D11
+typedef Pin<PORT_D, 5> LcdD4; // D5
+typedef Pin<PORT_D, 4> LcdD5; // D4
+typedef Pin<PORT_D, 3> LcdD6; // D3
+typedef Pin<PORT_D, 2> LcdD7; // D2
+typedef Pin<PORT_D, 7> KeyPin; // D7, push button
+typedef Pin<PORT_B, 2> RedPin; // D10
+typedef Pin<PORT_B, 1> GreenPin; // D9
+typedef Pin<PORT_D, 6> BluePin; // D6
+typedef Pin<PORT_C, 0> DitPaddle; // A0, paddle contact to ground (MORSE_PADDLE)
+typedef Pin<PORT_C, 1> DahPaddle; // A1, ...
+static_assert(DistinctPins<LcdRs, LcdEnable, LcdD4, LcdD5, LcdD6, LcdD7, KeyPin, RedPin, GreenPin, BluePin, DitPaddle, DahPaddle>::value, "a pin is wired to two functions");
+static_assert(KeyPin::port == PORT_D, "the key's pin change interrupt below is PCINT2_vect, which serves port D");
+static_assert(DahPaddle::port == DitPaddle::port, "the paddles are debounced from one read of their port");
+const uint8_t PADDLES = DitPaddle::mask | DahPaddle::mask; // both paddles' lines on their port
+
+typedef Hd44780<LcdRs, LcdEnable, LcdD4, LcdD5, LcdD6, LcdD7> Lcd;
+typedef Light<RedPin, GreenPin, BluePin> FeedbackLight;
+
+Lcd lcd; // The 16x2 lcd on its 4-bit bus.
+Display<Lcd> display(lcd); // Scrolls decoded letters across the lcd.
+FeedbackLight light; // RGB light used as feedback for the user.
+Button button; // The morse key.
+Decoder decoder(button.properties()); // Turns presses and releases into letters.
+Scheduler scheduler; // Runs the tasks below from loop().
+Power power; // Sleeps whenever no task is ready.
+PortDebouncer keyPort; // Debounces the key's port every tick; only the key's line is watched.
+TimingStore timingStore; // Keeps the learned keying rhythm in EEPROM across power cycles.
+#ifdef MORSE_PADDLE
+IambicKeyer keyer; // Times dits and dahs from the paddle.
+PortDebouncer paddlePort; // Debounces the paddles' port every tick; the keyer reads its levels, no edges are queued.
+#endif
+
+#ifndef LIGHT_FEEDBACK_MS
+#define LIGHT_FEEDBACK_MS 0 // how long the feedback colour stays on (ms); 0 keeps it until the next event
+#endif
+#ifndef PADDLE_WPM
+#define PADDLE_WPM 20 // keyer speed at power-up ('+' and '-' over serial change it)
+#endif
+const unsigned long SERIAL_SERVICE_MS = 10; // how often serial commands and diagnostics are serviced
+
+enum TaskSlot : uint8_t { // Tasks of the main loop, highest priority first.
+  TASK_KEY_CAPTURE, // takes the key's debounced edges from the tick interrupt
+  TASK_CLASSIFY, // classifies the captured press/release and collects decoded letters
+  TASK_PADDLE, // hands the keyer's elements and spaces to the decoder (MORSE_PADDLE)
+  TASK_GAP_TIMER, // ends letters and words once the pause after the last release is long enough
+  TASK_DISPLAY, // writes changed text to the lcd
+  TASK_LED, // shows (and, with LIGHT_FEEDBACK_MS, ends) the feedback colour
+  TASK_STORE, // writes a timing record to EEPROM, a byte at a time
+  TASK_TELEMETRY // serial commands, diagnostic reports and checks
+};
+
+ButtonEdge capturedEdge = EDGE_NONE; // edge taken by key capture, waiting to be classified (the next one stays queued in 'keyPort' until then)
+uint8_t feedbackColor = 0; // colour the light should show: bit 0 red, bit 1 green, bit 2 blue
+volatile bool keyChanged = false; // the key pin changed since key capture last took an edge
+volatile unsigned long keyChangeUs = 0; // micros() of the first of those changes, for the wake latency
+volatile unsigned long keyAcceptedUs = 0; // micros() of the tick that accepted the key's latest edge, for the capture latency
+
+ISR(PCINT2_vect) { // The key pin changed: wakes the board from power-down and notes when, the tick interrupt debounces it.
+  if (!keyChanged) {
+    keyChanged = true;
+    keyChangeUs = micros();
+  }
+}
+
+ISR(TIMER2_COMPA_vect) { // Every ms (TickTimer): samples the key's port, and the paddles' for the keyer, in one read each.
+  unsigned long now = millis();
+  if (keyPort.sample(KeyPin::read_port(), now) & KeyPin::mask) { // the key settled at a new level
+    keyAcceptedUs = micros();
+    scheduler.post_from_isr(TASK_KEY_CAPTURE);
+  }
+#ifdef MORSE_PADDLE
+  paddlePort.sample(DitPaddle::read_port(), now);
+  uint8_t paddles = paddlePort.levels();
+  if (keyer.tick(!(paddles & DitPaddle::mask), !(paddles & DahPaddle::mask))) { // contacts pull their pins low
+    scheduler.post_from_isr(TASK_PADDLE);
+  }
+#endif
+}
+
+#ifdef MORSE_PADDLE
+EMPTY_INTERRUPT(PCINT1_vect); // A paddle was pressed: only wakes the board from power-down, the tick interrupt samples the paddles itself
+#endif
+
+// Sets the feedback colour; the led task shows it.
+void show_feedback(uint8_t color) {
+  feedbackColor = color;
+  scheduler.post(TASK_LED);
+}
+
+// Queues whatever the decoder decoded for the display and light, and arms the gap timer for what it is still waiting on.
+void collect_decoded() {
+  DecoderEvent event;
+  while (decoder.next_event(event)) {
+    switch (event.type) {
+      case DECODED_LETTER:
+        display.add(event.letter); // shows the letter based on pattern of morse code that was input
+        WORD_CORRECTION_LETTER(event.letter, event.pattern);
+        show_feedback(0b010); // sets rgb light to green if a valid morse code combination was detected
+        break;
+      case DECODED_INVALID:
+        show_feedback(0b001); // sets rgb light to red if invalid morse code combination was detected
+        WORD_CORRECTION_LETTER('?', event.pattern); // the word corrector may still work out what was meant
+        break;
+      case DECODED_WORD_GAP:
+        WORD_CORRECTION_END(display); // swaps in the closest word from the word list if the word looks misread
+        display.add(' '); // separates words on the lcd
+        if (decoder.classifier.settled() && timingStore.offer(TimingSnapshot::of(decoder.classifier), millis())) { // saves the rhythm between words if it drifted
+          scheduler.post(TASK_STORE);
+        }
+        break;
+      case DECODED_CLEAR:
+        display.clear(); // clears the lcd
+        WORD_CORRECTION_RESET();
+        show_feedback(0b100); // sets rgb light to blue if the screen is being cleared
+        break;
+    }
+    scheduler.post(TASK_DISPLAY);
+  }
+
+  unsigned long deadline = decoder.next_deadline(); // when the pause will have ended the letter or word, if anything is pending
+  if (deadline != 0) {
+    scheduler.post_at(TASK_GAP_TIMER, deadline);
   } else {
-    set_color(HIGH, LOW, LOW); // sets rgb light to red if invalid morse code combination was detected
-    clear_input(); // clears the input to start processing next character
+    scheduler.cancel(TASK_GAP_TIMER);
   }
+}
+
+void check_input(ButtonEdge edge) { // Feeds the button's presses/releases to the decoder and queues whatever it decoded for the display and light
+  PROFILE_SCOPE(PROBE_CHECK_INPUT); // times classification, decoding and feedback
+  decoder.update(edge, millis()); // classifies presses and ends letters/words once the pause is long enough
+  collect_decoded();
+}
 
-  if (button.pressDuration > button.clearScreenThreshold) {
-    lcd.clear(); // clears the lcd
-    set_color(LOW, LOW, HIGH); // sets rgb light to blue if the screen is being cleared
+// Handles single-character commands sent over serial (e.g. from the PlatformIO serial monitor).
+void handle_serial_command() {
+  if (Serial.available() == 0) { // nothing was sent
+    return;
+  }
+  char command = Serial.read();
+  switch (command) {
+    case 'p': // dumps the profiling table
+      PROFILE_DUMP();
+      break;
+    case 'P': // clears the profiling table
+      PROFILE_RESET();
+      break;
+    case 'l': // prints the loop latency/jitter report (a line at a time, without blocking)
+      LOOP_MONITOR_REPORT();
+      break;
+    case 'L': // clears the loop latency/jitter statistics
+      LOOP_MONITOR_RESET();
+      break;
+    case 'm': // prints stack/heap high-water marks and heap counters
+      MEMORY_DUMP();
+      break;
+    case 's': // prints the run count and worst-case execution time of every task
+      scheduler.report();
+      break;
+    case 'S': // clears the task statistics
+      scheduler.reset_stats();
+      break;
+#ifdef MORSE_PADDLE
+    case '+': // keyer one WPM faster
+    case '-': // ... slower
+      noInterrupts();
+      keyer.set_wpm(keyer.speed() + (command == '+' ? 1 : -1));
+      interrupts();
+      LOG_INFO(LOG_CAT_INPUT, "Keyer at %d WPM", keyer.speed());
+      break;
+    case 'k': // switches the keyer between Mode A and Mode B
+      keyer.mode = keyer.mode == KEYER_MODE_A ? KEYER_MODE_B : KEYER_MODE_A;
+      LOG_INFO(LOG_CAT_INPUT, "Keyer in mode %c", keyer.mode == KEYER_MODE_A ? 'A' : 'B');
+      break;
+#endif
+    case 'z': // prints the sleep counts, time asleep and wake latency
+      power.report();
+      break;
+    case 'Z': // clears the sleep statistics
+      power.reset_stats();
+      break;
   }
 }
 
+// Task: takes the key's next debounced edge, timed at when the contact stopped bouncing, and hands it to classification.
+void key_capture_task() {
+  if (capturedEdge != EDGE_NONE) { // the last edge is not classified yet; classify posts this task again
+    return;
+  }
+  PortEdge portEdge;
+  noInterrupts(); // the tick interrupt queues edges
+  bool got = keyPort.edges.pop(portEdge);
+  bool changed = keyChanged;
+  unsigned long changedUs = keyChangeUs;
+  unsigned long acceptedUs = keyAcceptedUs;
+  keyChanged = false;
+  interrupts();
+  if (!got) {
+    return;
+  }
+  if (changed) {
+    unsigned long nowUs = micros();
+    power.wake_latency(nowUs - changedUs, nowUs - acceptedUs); // from the first bounce, and from the debouncer accepting it, to the edge being taken
+  }
+  capturedEdge = button.check_press((portEdge.levels & KeyPin::mask) != 0, portEdge.time);
+  scheduler.post(capturedEdge != EDGE_NONE ? TASK_CLASSIFY : TASK_KEY_CAPTURE);
+}
+
+// Task: classifies the captured edge, then lets key capture take the next one.
+void classify_task() {
+  ButtonEdge edge = capturedEdge;
+  capturedEdge = EDGE_NONE;
+  check_input(edge);
+  if (!keyPort.edges.empty()) { // edges that came in meanwhile (the count is one byte, read in one go)
+    scheduler.post(TASK_KEY_CAPTURE);
+  }
+}
+
+#ifdef MORSE_PADDLE
+// Task: the keyer sent elements or ended a letter or word; they go to the decoder without classification.
+void paddle_task() {
+  KeyerEvent event;
+  while (true) {
+    noInterrupts(); // the keyer queues events from its ISR
+    bool got = keyer.events.pop(event);
+    interrupts();
+    if (!got) {
+      break;
+    }
+    switch (event) {
+      case KEYER_DIT:
+        decoder.on_element(button.properties().shortPress);
+        break;
+      case KEYER_DAH:
+        decoder.on_element(button.properties().longPress);
+        break;
+      case KEYER_LETTER_SPACE:
+        decoder.on_letter_space();
+        break;
+      case KEYER_WORD_SPACE:
+        decoder.on_word_space();
+        break;
+    }
+  }
+  collect_decoded();
+}
+#endif
+
+// Task: the pause after the last release has become long enough to end a letter or word.
+void gap_timer_task() {
+  check_input(EDGE_NONE);
+}
+
+// Task: puts new text on the lcd.
+void display_task() {
+  display.flush();
+}
+
+// Task: shows the feedback colour, and turns it off again after LIGHT_FEEDBACK_MS.
+void led_task() {
+  light.color(feedbackColor & 0b001 ? HIGH : LOW, feedbackColor & 0b010 ? HIGH : LOW, feedbackColor & 0b100 ? HIGH : LOW);
+  if (LIGHT_FEEDBACK_MS > 0 && feedbackColor != 0) {
+    feedbackColor = 0;
+    scheduler.post_in(TASK_LED, LIGHT_FEEDBACK_MS);
+  }
+}
+
+// Task: writes the next byte of a timing record once the EEPROM has finished the previous one.
+void store_task() {
+  if (timingStore.write_step()) {
+    scheduler.post_in(TASK_STORE, EEPROM_WRITE_MS);
+  }
+}
+
+// Task: answers serial commands and services the diagnostics, every SERIAL_SERVICE_MS.
+void telemetry_task() {
+  handle_serial_command(); // Answers diagnostic requests from the serial monitor
+  MEMORY_CHECK(); // Warns once if the stack ever came close to the heap
+  LOOP_MONITOR_SERVICE(); // Writes pending stall flags / report lines when the TX buffer has room
+  scheduler.post_in(TASK_TELEMETRY, SERIAL_SERVICE_MS);
+}
+
+// Sleeps until the next interrupt if no task is ready: IDLE while anything may still happen, POWER-DOWN once the key has been left alone for POWER_DOWN_AFTER_MS.
+void idle() {
+  bool powerDown = POWER_DOWN_AFTER_MS > 0 && !button.properties().isPressed
+    && millis() - button.last_edge_time() >= (unsigned long)POWER_DOWN_AFTER_MS
+    && !scheduler.is_armed(TASK_GAP_TIMER) && !timingStore.busy(); // millis() stops, so no deadline that matters may be pending
+  noInterrupts(); // the tick timer stops as well, so nothing it samples may be part way to an edge
+  powerDown = powerDown && keyPort.settled(KeyPin::read_port()); // a change that woke the board is debounced before it sleeps again
+#ifdef MORSE_PADDLE
+  powerDown = powerDown && (DitPaddle::read_port() & PADDLES) == PADDLES && keyer.idle_for(POWER_DOWN_AFTER_MS); // both paddles up, even one that just woke the board
+#endif
+  interrupts();
+  if (powerDown) {
+    feedbackColor = 0;
+    light.off(); // no point lighting a sleeping board
+    scheduler.cancel(TASK_LED);
+    Serial.flush(); // the USART stops as well; lets pending output go out first
+  }
+  noInterrupts();
+  if (scheduler.busy()) { // something became ready since run_once looked
+    interrupts();
+    return;
+  }
+  power.sleep(powerDown ? SLEEP_POWER_DOWN : SLEEP_IDLE); // enables interrupts as it goes to sleep
+}
+
 // Runs only once when the board turns on. Initializes the pins and sets up board to properly run.
 void setup() {
   Serial.begin(9600); // Initialize serial communication at 9600 bits per second
   
   // Initializes the digital board pins for I/O
-  pinMode(pin.pushButton, INPUT); // sets button to read input
-  pinMode(pin.r, OUTPUT); // Sets red rgb pin to output
-  pinMode(pin.g, OUTPUT); // Sets green rgb pin to output
-  pinMode(pin.b, OUTPUT); // Sets blue rgb pin to output
-  for (int i = pin.d4; i <= pin.d7; i++) { // Iterating pin setup for lcd
-    pinMode(i, OUTPUT); // Sets each digital pin for lcd to output
-  }
+  KeyPin::input(); // sets button to read input
+  light.begin(); // Sets the rgb pins to output
   
-  // Initializes the lcd
-  lcd.begin(16, 2); // Defines number of columns, rows
-  lcd.leftToRight(); // Sets default reading/writing pattern
-  lcd.display(); // Turns on the display
+  // Initializes the lcd (4-bit bus, 2 rows, display on, left to right)
+  lcd.begin();
+
+  power.begin(); // Switches off the ADC, SPI, TWI and timer 2 (the tick timer below switches it back on)
+
+  keyPort.watched = KeyPin::mask; // the rest of port D drives the lcd and the light
+  keyPort.begin(0); // starts from the key up, so a key held at power-up is seen as a press
+#ifdef MORSE_PADDLE
+  DitPaddle::input_pullup(); // paddle contacts close to ground
+  DahPaddle::input_pullup();
+  DitPaddle::enable_change_interrupt(); // a paddle wakes the board from power-down (PCINT1_vect)
+  DahPaddle::enable_change_interrupt();
+  paddlePort.watched = 0;
+  paddlePort.begin(PADDLES); // starts from both paddles up (pulled high)
+  keyer.set_wpm(PADDLE_WPM);
+#endif
+  TickTimer::begin(); // debounces the key and times the keyer (TIMER2_COMPA_vect); switches timer 2 back on
+
+  TimingSnapshot saved;
+  if (timingStore.load(saved)) { // Starts from the rhythm learned in the last session
+    decoder.classifier.seed(saved.presses, saved.releases);
+  }
+
+  PROFILE_BEGIN(); // Starts the profiling cycle counter (no-op unless MORSE_PROFILE is defined)
+
+  // Main loop tasks, in priority order
+  scheduler.add(TASK_KEY_CAPTURE, key_capture_task, PSTR("key_capture"));
+  scheduler.add(TASK_CLASSIFY, classify_task, PSTR("classify"));
+#ifdef MORSE_PADDLE
+  scheduler.add(TASK_PADDLE, paddle_task, PSTR("paddle"));
+#endif
+  scheduler.add(TASK_GAP_TIMER, gap_timer_task, PSTR("gap_timer"));
+  scheduler.add(TASK_DISPLAY, display_task, PSTR("display"));
+  scheduler.add(TASK_LED, led_task, PSTR("led"));
+  scheduler.add(TASK_STORE, store_task, PSTR("store"));
+  scheduler.add(TASK_TELEMETRY, telemetry_task, PSTR("telemetry"));
+  KeyPin::enable_change_interrupt(); // key changes wake the board (PCINT2_vect)
+  scheduler.post(TASK_TELEMETRY);
   
   // Serial output
-  Serial.println("Setup complete.");
+  TELEMETRY_BOOT(); // Marks the start of a new telemetry stream
+  LOG_INFO(LOG_CAT_SYSTEM, "Setup complete.");
 }
 
 void loop() {
-
+  LOOP_MONITOR_TICK(); // Measures the period of the main loop
+  if (!scheduler.run_once()) { // Runs the most urgent ready task to completion
+    idle(); // nothing was ready: sleeps until an interrupt (the key, serial, the 1 ms debounce tick or the millis() tick for deadlines)
+  }
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+/*
+Fixed-capacity containers (lib/containers.h) on the host, at their edges: full, wrapping around,
+overwriting the oldest entry and truncating. Run with
+    pio test -e native
+*/
+
+#include <unity.h>
+
+#include "../../lib/containers.h"
+
+void test_ring_buffer_full() {
+    RingBuffer<int, 3> buffer;
+    TEST_ASSERT_TRUE(buffer.empty());
+    for (int i = 1; i <= 3; i++) {
+        TEST_ASSERT_TRUE(buffer.push(i));
+    }
+    TEST_ASSERT_TRUE(buffer.full());
+    TEST_ASSERT_FALSE(buffer.push(4)); // dropped, the buffer as it was
+    TEST_ASSERT_EQUAL(3, buffer.size());
+    TEST_ASSERT_EQUAL(1, buffer[0]);
+    TEST_ASSERT_EQUAL(3, buffer[2]);
+    int value = 0;
+    for (int i = 1; i <= 3; i++) {
+        TEST_ASSERT_TRUE(buffer.pop(value));
+        TEST_ASSERT_EQUAL(i, value);
+    }
+    TEST_ASSERT_FALSE(buffer.pop(value));
+    TEST_ASSERT_EQUAL(3, value); // left alone
+}
+
+void test_ring_buffer_wraps() {
+    RingBuffer<int, 3> buffer;
+    int value = 0;
+    for (int i = 0; i < 10; i++) { // head and tail go round the storage several times
+        TEST_ASSERT_TRUE(buffer.push(i));
+        TEST_ASSERT_TRUE(buffer.push(i + 100));
+        TEST_ASSERT_TRUE(buffer.pop(value));
+        TEST_ASSERT_TRUE(buffer.pop(value));
+        TEST_ASSERT_EQUAL(i + 100, value);
+    }
+    TEST_ASSERT_TRUE(buffer.empty());
+    buffer.push(7);
+    buffer.clear();
+    TEST_ASSERT_TRUE(buffer.empty());
+    TEST_ASSERT_FALSE(buffer.pop(value));
+}
+
+void test_ring_buffer_push_over() {
+    RingBuffer<int, 3> buffer;
+    for (int i = 1; i <= 5; i++) {
+        buffer.push_over(i); // 4 and 5 push out 1 and 2
+    }
+    TEST_ASSERT_EQUAL(3, buffer.size());
+    TEST_ASSERT_EQUAL(3, buffer[0]);
+    TEST_ASSERT_EQUAL(4, buffer[1]);
+    TEST_ASSERT_EQUAL(5, buffer[2]);
+    int value = 0;
+    buffer.pop(value);
+    TEST_ASSERT_EQUAL(3, value);
+    buffer.push_over(6); // not full: nothing dropped
+    TEST_ASSERT_EQUAL(3, buffer.size());
+    TEST_ASSERT_EQUAL(4, buffer[0]);
+    TEST_ASSERT_EQUAL(6, buffer[2]);
+}
+
+void test_static_vector_full() {
+    StaticVector<char, 4> vector;
+    for (char c = 'a'; c < 'e'; c++) {
+        TEST_ASSERT_TRUE(vector.push_back(c));
+    }
+    TEST_ASSERT_TRUE(vector.full());
+    TEST_ASSERT_FALSE(vector.push_back('e'));
+    TEST_ASSERT_EQUAL(4, vector.size());
+    TEST_ASSERT_EQUAL('d', vector[3]);
+    TEST_ASSERT_EQUAL(4, vector.end() - vector.begin());
+    vector.pop_back();
+    TEST_ASSERT_TRUE(vector.push_back('e')); // room again at the end
+    TEST_ASSERT_EQUAL('e', vector[3]);
+    vector.clear();
+    vector.pop_back(); // on an empty vector: nothing
+    TEST_ASSERT_TRUE(vector.empty());
+    TEST_ASSERT_TRUE(vector.begin() == vector.end());
+}
+
+void test_bounded_string_truncates() {
+    BoundedString<3> text;
+    TEST_ASSERT_EQUAL_STRING("", text.c_str());
+    TEST_ASSERT_TRUE(text.append('A'));
+    TEST_ASSERT_TRUE(text.append('B'));
+    TEST_ASSERT_TRUE(text.append('C'));
+    TEST_ASSERT_FALSE(text.append('D')); // dropped; still terminated after the third
+    TEST_ASSERT_EQUAL_STRING("ABC", text.c_str());
+    TEST_ASSERT_TRUE(text.full());
+    text.prepend('Z'); // the last character makes room
+    TEST_ASSERT_EQUAL_STRING("ZAB", text.c_str());
+    TEST_ASSERT_EQUAL(3, text.length());
+}
+
+void test_bounded_string_take() {
+    BoundedString<4> text;
+    text.prepend('B');
+    text.prepend('A');
+    text.append('C');
+    TEST_ASSERT_EQUAL_STRING("ABC", text.c_str());
+    TEST_ASSERT_EQUAL('A', text.take_front());
+    TEST_ASSERT_EQUAL_STRING("BC", text.c_str());
+    TEST_ASSERT_EQUAL('C', text.take_back());
+    TEST_ASSERT_EQUAL_STRING("B", text.c_str());
+    TEST_ASSERT_EQUAL('B', text.take_front());
+    TEST_ASSERT_TRUE(text.empty());
+    TEST_ASSERT_EQUAL('\0', text.take_front()); // empty: nothing to take
+    TEST_ASSERT_EQUAL('\0', text.take_back());
+    TEST_ASSERT_EQUAL_STRING("", text.c_str());
+}
+
+void test_bounded_string_view() {
+    BoundedString<8> text;
+    text.append('S');
+    text.append('O');
+    text.append('S');
+    StringView view = text.view();
+    TEST_ASSERT_EQUAL(3, view.length);
+    TEST_ASSERT_EQUAL('O', view[1]);
+    text.clear();
+    TEST_ASSERT_EQUAL_STRING("", text.c_str());
+    TEST_ASSERT_EQUAL(0, text.view().length);
+    StringView terminated("CQ");
+    TEST_ASSERT_EQUAL(2, terminated.length);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_ring_buffer_full);
+    RUN_TEST(test_ring_buffer_wraps);
+    RUN_TEST(test_ring_buffer_push_over);
+    RUN_TEST(test_static_vector_full);
+    RUN_TEST(test_bounded_string_truncates);
+    RUN_TEST(test_bounded_string_take);
+    RUN_TEST(test_bounded_string_view);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+/*
+Vertical-counter debouncer (lib/debouncer.h) on the host: the port is sampled once per ms tick, as
+the TickTimer interrupt does, and the tests assert on the accepted edges, their times and the
+latency from the line settling to the edge. Run with
+    pio test -e native
+*/
+
+#include <unity.h>
+
+#include "../../lib/debouncer.h"
+
+const uint8_t KEY = 0x01; // line of the key
+const uint8_t PADDLES = 0x06; // two more lines, changing together
+
+// Samples 'levels' on the ticks from 'from' to before 'to'. Returns the lines that changed on the way.
+uint8_t hold(PortDebouncer& port, uint8_t levels, unsigned long from, unsigned long to) {
+    uint8_t changed = 0;
+    for (unsigned long now = from; now < to; now++) {
+        changed |= port.sample(levels, now);
+    }
+    return changed;
+}
+
+void test_four_samples() {
+    PortDebouncer port;
+    port.begin(0);
+    for (unsigned long now = 10; now < 10 + DEBOUNCE_SAMPLES - 1; now++) {
+        TEST_ASSERT_EQUAL(0, port.sample(KEY, now));
+    }
+    TEST_ASSERT_EQUAL(KEY, port.sample(KEY, 13)); // the fourth sample in a row
+    TEST_ASSERT_EQUAL(KEY, port.levels());
+    PortEdge edge;
+    TEST_ASSERT_TRUE(port.edges.pop(edge));
+    TEST_ASSERT_EQUAL(KEY, edge.changed);
+    TEST_ASSERT_EQUAL(KEY, edge.levels);
+    TEST_ASSERT_EQUAL(10, edge.time); // now - 3: the first sample at the new level
+    TEST_ASSERT_FALSE(port.edges.pop(edge));
+
+    TEST_ASSERT_EQUAL(0, hold(port, KEY, 14, 100)); // staying there is no further edge
+    TEST_ASSERT_EQUAL(KEY, hold(port, 0, 100, 104)); // and back down the same way
+    TEST_ASSERT_TRUE(port.edges.pop(edge));
+    TEST_ASSERT_EQUAL(0, edge.levels);
+    TEST_ASSERT_EQUAL(100, edge.time);
+}
+
+void test_glitch_rejected() {
+    for (unsigned long length = 1; length < DEBOUNCE_SAMPLES; length++) {
+        PortDebouncer port;
+        port.begin(0);
+        unsigned long now = 0;
+        for (int glitch = 0; glitch < 100; glitch++) { // the same glitch over and over never adds up
+            now += length;
+            TEST_ASSERT_EQUAL(0, hold(port, KEY, now - length, now));
+            TEST_ASSERT_EQUAL(0, hold(port, 0, now, now + 1));
+            now++;
+        }
+        TEST_ASSERT_EQUAL(0, port.levels());
+        TEST_ASSERT_TRUE(port.edges.empty());
+        TEST_ASSERT_TRUE(port.settled(0));
+    }
+}
+
+void test_bounce_then_settle() {
+    PortDebouncer port;
+    port.begin(0);
+    const uint8_t bounce[] = { KEY, 0, KEY, KEY, 0, KEY, KEY, KEY, 0 }; // chatter for 9 ms
+    for (uint8_t i = 0; i < sizeof(bounce); i++) {
+        TEST_ASSERT_EQUAL(0, port.sample(bounce[i], 20 + i));
+    }
+    TEST_ASSERT_EQUAL(KEY, hold(port, KEY, 29, 33));
+    PortEdge edge;
+    TEST_ASSERT_TRUE(port.edges.pop(edge));
+    TEST_ASSERT_EQUAL(29, edge.time); // when it stopped bouncing, not when it started
+    TEST_ASSERT_TRUE(port.edges.empty());
+}
+
+void test_lines_in_one_tick() {
+    PortDebouncer port;
+    port.watched = KEY | PADDLES;
+    port.begin(0);
+    TEST_ASSERT_EQUAL(KEY | PADDLES, hold(port, KEY | PADDLES, 0, DEBOUNCE_SAMPLES));
+    PortEdge edge;
+    TEST_ASSERT_TRUE(port.edges.pop(edge)); // one edge for all lines that settled together
+    TEST_ASSERT_EQUAL(KEY | PADDLES, edge.changed);
+    TEST_ASSERT_EQUAL(KEY | PADDLES, edge.levels);
+    TEST_ASSERT_EQUAL(0, edge.time);
+    TEST_ASSERT_TRUE(port.edges.empty());
+
+    TEST_ASSERT_EQUAL(0, port.sample(KEY, 10)); // the paddles go low a tick before the key: each line keeps its own count
+    TEST_ASSERT_EQUAL(0, hold(port, 0, 11, 13));
+    TEST_ASSERT_EQUAL(PADDLES, port.sample(0, 13)); // the paddles' fourth sample at 0
+    TEST_ASSERT_EQUAL(KEY, port.sample(0, 14)); // the key's
+    TEST_ASSERT_TRUE(port.edges.pop(edge));
+    TEST_ASSERT_EQUAL(PADDLES, edge.changed);
+    TEST_ASSERT_EQUAL(KEY, edge.levels);
+    TEST_ASSERT_EQUAL(10, edge.time);
+    TEST_ASSERT_TRUE(port.edges.pop(edge));
+    TEST_ASSERT_EQUAL(KEY, edge.changed);
+    TEST_ASSERT_EQUAL(0, edge.levels);
+    TEST_ASSERT_EQUAL(11, edge.time);
+}
+
+void test_unwatched_lines() {
+    PortDebouncer port;
+    port.watched = KEY;
+    port.begin(0);
+    TEST_ASSERT_EQUAL(PADDLES, hold(port, PADDLES, 0, DEBOUNCE_SAMPLES)); // debounced...
+    TEST_ASSERT_EQUAL(PADDLES, port.levels());
+    TEST_ASSERT_TRUE(port.edges.empty()); // ...but not queued
+    TEST_ASSERT_TRUE(port.settled(0)); // nor looked at by 'settled'
+}
+
+void test_settled() {
+    PortDebouncer port;
+    port.begin(0);
+    TEST_ASSERT_TRUE(port.settled(0));
+    port.sample(KEY, 0);
+    TEST_ASSERT_FALSE(port.settled(KEY)); // a change is being counted
+    hold(port, KEY, 1, DEBOUNCE_SAMPLES);
+    TEST_ASSERT_FALSE(port.settled(KEY)); // accepted, but the edge is still waiting
+    PortEdge edge;
+    port.edges.pop(edge);
+    TEST_ASSERT_TRUE(port.settled(KEY));
+    TEST_ASSERT_FALSE(port.settled(0)); // the port reads something else than the debounced level
+}
+
+void test_latency_bound() {
+    uint32_t random = 12345; // fixed-seed LCG, so a failure repeats
+    for (int run = 0; run < 1000; run++) {
+        PortDebouncer port;
+        port.begin(0);
+        unsigned long now = 0;
+        for (int i = 0; i < run % 16; i++) { // up to 15 ms of chatter, which may itself make edges
+            random = random * 1103515245 + 12345;
+            port.sample((random >> 16) & 1 ? KEY : 0, now++);
+        }
+        uint8_t target = port.levels() ^ KEY; // where the line settles, away from its debounced level
+        port.sample(port.levels(), now++); // the last bounce
+        unsigned long settledAt = now;
+        unsigned long acceptedAt = 0;
+        while (!acceptedAt && now < settledAt + 10) {
+            if (port.sample(target, now) & KEY) {
+                acceptedAt = now;
+            }
+            now++;
+        }
+        TEST_ASSERT_EQUAL(settledAt + DEBOUNCE_SAMPLES - 1, acceptedAt); // on the 4th stable sample: under 5 ms after the line settled at the 1 kHz tick
+        PortEdge edge = {};
+        while (port.edges.pop(edge)) {} // the last edge is the one after the chatter
+        TEST_ASSERT_EQUAL(settledAt, edge.time);
+        TEST_ASSERT_EQUAL(target, edge.levels);
+    }
+}
+
+void test_queue_overflow() {
+    PortDebouncer port;
+    port.begin(0);
+    unsigned long now = 0;
+    for (uint8_t i = 0; i < DEBOUNCE_QUEUE_SIZE + 2; i++) { // ten edges, never collected
+        hold(port, i % 2 ? 0 : KEY, now, now + DEBOUNCE_SAMPLES);
+        now += DEBOUNCE_SAMPLES;
+    }
+    TEST_ASSERT_EQUAL(DEBOUNCE_QUEUE_SIZE, port.edges.size());
+    TEST_ASSERT_EQUAL(2, port.dropped);
+    PortEdge oldest = {};
+    port.edges.pop(oldest);
+    TEST_ASSERT_EQUAL(2 * DEBOUNCE_SAMPLES, oldest.time); // the first two went
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_four_samples);
+    RUN_TEST(test_glitch_rejected);
+    RUN_TEST(test_bounce_then_settle);
+    RUN_TEST(test_lines_in_one_tick);
+    RUN_TEST(test_unwatched_lines);
+    RUN_TEST(test_settled);
+    RUN_TEST(test_latency_bound);
+    RUN_TEST(test_queue_overflow);
+    return UNITY_END();
+}
\ No newline at end of file
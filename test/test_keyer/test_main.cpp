@@ -0,0 +1,132 @@
+/*
+Iambic keyer (lib/keyer.h) on the host: the paddles are scripted per ms tick, as the TickTimer
+interrupt samples them, and the tests assert on the queued elements and spaces. Run with
+    pio test -e native
+*/
+
+#include <unity.h>
+
+#include <string>
+
+#include "../../lib/keyer.h"
+
+const unsigned long UNIT = 60; // ms per dit at the default 20 WPM
+
+struct Paddles { // When each paddle is held: [from, to) in ms from the first tick.
+    unsigned long ditFrom, ditTo;
+    unsigned long dahFrom, dahTo;
+};
+
+// Ticks 'keyer' for 'ms' ms with the paddles held as in 'paddles'. Returns the events collected on the way: '.' dit, '-' dah, ' ' letter space, '/' word space; the tick of every event goes to 'times' if given.
+std::string run(IambicKeyer& keyer, const Paddles& paddles, unsigned long ms, std::string* times = nullptr) {
+    std::string sent;
+    for (unsigned long now = 0; now < ms; now++) {
+        bool dit = now >= paddles.ditFrom && now < paddles.ditTo;
+        bool dah = now >= paddles.dahFrom && now < paddles.dahTo;
+        keyer.tick(dit, dah);
+        KeyerEvent event;
+        while (keyer.events.pop(event)) {
+            const char symbols[] = { '.', '-', ' ', '/' };
+            sent += symbols[event];
+            if (times) *times += std::to_string(now) + " ";
+        }
+    }
+    return sent;
+}
+
+void test_squeeze_mode_a() {
+    IambicKeyer keyer;
+    keyer.mode = KEYER_MODE_A;
+    Paddles squeeze = { 0, 150, 0, 150 }; // released during the dah that follows the first dit
+    TEST_ASSERT_EQUAL_STRING(".- /", run(keyer, squeeze, 1000).c_str());
+}
+
+void test_squeeze_mode_b() {
+    IambicKeyer keyer;
+    keyer.mode = KEYER_MODE_B;
+    Paddles squeeze = { 0, 150, 0, 150 }; // the dit pressed during the dah is sent after it
+    TEST_ASSERT_EQUAL_STRING(".-. /", run(keyer, squeeze, 1000).c_str());
+}
+
+void test_held_dit() {
+    IambicKeyer keyer;
+    Paddles dit = { 0, 330, 0, 0 }; // released in the space after the third dit
+    TEST_ASSERT_EQUAL_STRING("... /", run(keyer, dit, 1000).c_str());
+}
+
+void test_dah_memory() {
+    IambicKeyer keyer;
+    keyer.mode = KEYER_MODE_A;
+    keyer.memory = true;
+    Paddles tap = { 0, 10, 20, 40 }; // a dah tap during the dit, with the dit paddle already released
+    TEST_ASSERT_EQUAL_STRING(".- /", run(keyer, tap, 1000).c_str());
+
+    IambicKeyer forgetful;
+    forgetful.mode = KEYER_MODE_A;
+    forgetful.memory = false;
+    TEST_ASSERT_EQUAL_STRING(". /", run(forgetful, tap, 1000).c_str());
+}
+
+void test_space_timing() {
+    IambicKeyer keyer;
+    Paddles tap = { 0, 10, 0, 0 }; // one dit, over at UNIT
+    std::string times;
+    TEST_ASSERT_EQUAL_STRING(". /", run(keyer, tap, 1000, &times).c_str());
+    std::string expected = "0 " + std::to_string(UNIT + LETTER_SPACE_UNITS * UNIT) + " " + std::to_string(UNIT + WORD_SPACE_UNITS * UNIT) + " ";
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), times.c_str()); // key-up for 2 units ends the letter, for 5 the word
+}
+
+void test_no_space_within_letter() {
+    IambicKeyer keyer;
+    Paddles pause = { 0, 10, 150, 160 }; // a dit, then a dah started 1.5 units after the dit's space
+    TEST_ASSERT_EQUAL_STRING(".- /", run(keyer, pause, 1000).c_str());
+}
+
+void test_queue_overflow() {
+    IambicKeyer keyer;
+    for (unsigned long now = 0; now < 10 * 2 * UNIT; now++) { // ten dits, never collected
+        keyer.tick(true, false);
+    }
+    TEST_ASSERT_EQUAL(KEYER_QUEUE_SIZE, keyer.events.size());
+    TEST_ASSERT_EQUAL(10 - KEYER_QUEUE_SIZE, keyer.dropped);
+}
+
+void test_idle_for() {
+    IambicKeyer keyer;
+    TEST_ASSERT_TRUE(keyer.idle_for(60000)); // nothing sent since power-up
+    Paddles tap = { 0, 10, 0, 0 };
+    run(keyer, tap, 4 * UNIT); // the dit is over at tick UNIT, the last tick run is 4 * UNIT - 1
+    TEST_ASSERT_TRUE(keyer.idle_for(3 * UNIT - 1));
+    TEST_ASSERT_FALSE(keyer.idle_for(3 * UNIT));
+}
+
+void test_speed() {
+    IambicKeyer keyer;
+    keyer.set_wpm(2);
+    TEST_ASSERT_EQUAL(5, keyer.speed());
+    keyer.set_wpm(100);
+    TEST_ASSERT_EQUAL(60, keyer.speed());
+    keyer.set_wpm(12);
+    std::string times;
+    Paddles tap = { 0, 10, 0, 0 };
+    run(keyer, tap, 2000, &times);
+    TEST_ASSERT_EQUAL_STRING("0 300 600 ", times.c_str()); // 100 ms units
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_squeeze_mode_a);
+    RUN_TEST(test_squeeze_mode_b);
+    RUN_TEST(test_held_dit);
+    RUN_TEST(test_dah_memory);
+    RUN_TEST(test_space_timing);
+    RUN_TEST(test_no_space_within_letter);
+    RUN_TEST(test_queue_overflow);
+    RUN_TEST(test_idle_for);
+    RUN_TEST(test_speed);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,174 @@
+/*
+Press -> classify -> decode -> display pipeline on the host: scripted key traces go through the
+virtual-clock Simulation (src/host/simulation.h) and the tests assert on the decoded text. Run with
+    pio test -e native
+
+Fixtures are the text traces in tools/traces (the same ones sim_run replays) and traces encoded here
+with standard timing by MorseEncoder (src/host/morse_encoder.h).
+*/
+
+#include <unity.h>
+
+#include <string>
+
+#include "../../src/host/morse_encoder.h"
+#include "../../src/host/simulation.h"
+#include "../../src/host/text_trace.h"
+
+const uint64_t LEAD_IN_MS = 500; // key up before the first press
+const uint64_t TAIL_MS = 3000; // key up after the last release, so the last letter and word finish
+const char* PANGRAM = "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG";
+
+// Path of a fixture in tools/traces, found from this file's own path (the project directory if that is relative).
+std::string fixture(const char* name) {
+    std::string path = __FILE__;
+    size_t test = path.rfind("test/test_pipeline/");
+    return path.substr(0, test == std::string::npos ? 0 : test) + "tools/traces/" + name;
+}
+
+// 'text' keyed exactly with 'timing', with the text it encodes as the expected text.
+Trace encoded(const char* text, const MorseTiming& timing) {
+    Trace trace;
+    MorseEncoder encoder(timing);
+    encoder.text = &trace.expected;
+    uint64_t now = LEAD_IN_MS;
+    encoder.encode(text, strlen(text), [&](bool down, double ms) {
+        if (down) {
+            trace.edges.push_back({ now, true });
+            trace.edges.push_back({ now + (uint64_t)(ms + 0.5), false });
+        }
+        now += (uint64_t)(ms + 0.5);
+    });
+    trace.lengthMs = now;
+    return trace;
+}
+
+// 'text' keyed with standard timing at 'wpm'.
+Trace encoded(const char* text, double wpm) {
+    return encoded(text, MorseTiming::at(wpm));
+}
+
+// Runs a trace through a fresh simulation; returns what was shown, without the final word gap.
+std::string decode(const Trace& trace, unsigned long loopPeriodMs = 0) {
+    Simulation simulation;
+    simulation.loopPeriodMs = loopPeriodMs;
+    simulation.run(trace, 0, TAIL_MS);
+    std::string decoded = simulation.decoded;
+    while (!decoded.empty() && decoded.back() == ' ') decoded.pop_back();
+    return decoded;
+}
+
+void test_sos_fixture() {
+    Trace trace = load_trace(fixture("sos.trace").c_str(), 0);
+    TEST_ASSERT_EQUAL_STRING("SOS", trace.expected.c_str());
+    TEST_ASSERT_EQUAL_STRING(trace.expected.c_str(), decode(trace).c_str());
+}
+
+void test_pangram_fixture() {
+    Trace trace = load_trace(fixture("quick_fox.trace").c_str(), 0);
+    TEST_ASSERT_EQUAL_STRING(PANGRAM, trace.expected.c_str());
+    TEST_ASSERT_EQUAL_STRING(trace.expected.c_str(), decode(trace).c_str());
+}
+
+void test_speeds() {
+    const double speeds[] = { 8, 10, 12, 15, 20, 25, 30, 35, 40 };
+    for (double wpm : speeds) {
+        Trace trace = encoded(PANGRAM, wpm);
+        std::string message = std::to_string((int)wpm) + " WPM";
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(PANGRAM, decode(trace).c_str(), message.c_str());
+    }
+}
+
+void test_repeated_word() {
+    const char* text = "TIME TIME TIME TIME TIME TIME"; // word gaps fill the release window, exact letter gaps must still end letters
+    TEST_ASSERT_EQUAL_STRING(text, decode(encoded(text, 20)).c_str());
+    const char* calls = "TNX TNX TNX OM OM OM";
+    TEST_ASSERT_EQUAL_STRING(calls, decode(encoded(calls, 20)).c_str());
+}
+
+void test_long_letter_gaps() {
+    MorseTiming timing = MorseTiming::at(15);
+    timing.letterGap = 5 * timing.dit; // halfway between a letter gap and a word gap
+    timing.wordGap = 10 * timing.dit;
+    TEST_ASSERT_EQUAL_STRING("SOS SOS", decode(encoded("SOS SOS", timing)).c_str());
+}
+
+void test_farnsworth() {
+    Trace trace = encoded(PANGRAM, MorseTiming::at(20, 10)); // letter gaps of 11 dits, word gaps of 25
+    std::string decoded = decode(trace);
+    size_t second = decoded.find(" QUICK "); // the first letter gap comes before any is known and is taken for a word gap (classifier.h)
+    TEST_ASSERT_TRUE(second != std::string::npos);
+    TEST_ASSERT_EQUAL_STRING(strchr(PANGRAM, ' '), decoded.c_str() + second);
+}
+
+void test_fixed_loop_period() {
+    Trace trace = encoded(PANGRAM, 20);
+    TEST_ASSERT_EQUAL_STRING(PANGRAM, decode(trace, 5).c_str());
+}
+
+void test_contact_bounce() {
+    Trace clean = encoded(PANGRAM, 20);
+    Trace bouncy;
+    bouncy.expected = clean.expected;
+    bouncy.lengthMs = clean.lengthMs;
+    for (const TraceEdge& edge : clean.edges) { // every edge chatters for 2 ms before it settles
+        bouncy.edges.push_back(edge);
+        bouncy.edges.push_back({ edge.timeMs + 1, !edge.pressed });
+        bouncy.edges.push_back({ edge.timeMs + 2, edge.pressed });
+    }
+    TEST_ASSERT_EQUAL_STRING(PANGRAM, decode(bouncy).c_str());
+}
+
+void test_glitch_is_ignored() {
+    Trace trace = encoded("E", 20);
+    trace.edges.insert(trace.edges.begin(), { { 100, true }, { 102, false } }); // shorter than the debouncer's 4 samples
+    TEST_ASSERT_EQUAL_STRING("E", decode(trace).c_str());
+}
+
+void test_hold_clears_display() {
+    Trace trace = encoded("SOS", 20);
+    uint64_t now = trace.lengthMs + TAIL_MS;
+    trace.edges.push_back({ now, true }); // held for longer than the clear threshold
+    trace.edges.push_back({ now + 2500, false });
+    now += 2500 + TAIL_MS;
+    trace.edges.push_back({ now, true }); // then a dit
+    trace.edges.push_back({ now + 60, false });
+    trace.lengthMs = now + 60;
+    TEST_ASSERT_EQUAL_STRING("E", decode(trace).c_str());
+}
+
+void test_hour_of_keying() {
+    Trace trace = load_trace(fixture("sos.trace").c_str(), 0);
+    Simulation simulation;
+    uint64_t period = trace.lengthMs + TAIL_MS;
+    uint64_t repeats = 3600000 / period + 1; // at least an hour of simulated time
+    std::string expected;
+    for (uint64_t i = 0; i < repeats; i++) {
+        simulation.run(trace, i * period, TAIL_MS);
+        expected += (i ? " " : "") + trace.expected;
+    }
+    std::string decoded = simulation.decoded;
+    while (!decoded.empty() && decoded.back() == ' ') decoded.pop_back();
+    TEST_ASSERT_TRUE(hostPlatform.now >= 3600000);
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), decoded.c_str());
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sos_fixture);
+    RUN_TEST(test_pangram_fixture);
+    RUN_TEST(test_speeds);
+    RUN_TEST(test_repeated_word);
+    RUN_TEST(test_long_letter_gaps);
+    RUN_TEST(test_farnsworth);
+    RUN_TEST(test_fixed_loop_period);
+    RUN_TEST(test_contact_bounce);
+    RUN_TEST(test_glitch_is_ignored);
+    RUN_TEST(test_hold_clears_display);
+    RUN_TEST(test_hour_of_keying);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,269 @@
+/*
+Timing store (lib/timing_store.h) on the host, against the simulated EEPROM of lib/platform.h: saves
+are run byte by byte with write_step as on the device, and the tests look at the slots directly. Run
+with
+    pio test -e native
+*/
+
+#include <unity.h>
+
+#include <cstring>
+
+#include "../../lib/classifier.h"
+#include "../../lib/timing_store.h"
+
+const unsigned long LATER = TIMING_STORE_INTERVAL_MS; // far enough apart for two saves
+
+// Windows of keying with a 'dit' ms dit: dits and dahs, element and letter gaps. A 'tag' replaces the last release, to tell saves apart.
+TimingSnapshot timing(int16_t dit, int16_t tag = 0) {
+    TimingSnapshot snapshot;
+    for (uint8_t i = 0; i < CLASSIFIER_WINDOW; i++) {
+        snapshot.presses[i] = snapshot.releases[i] = i % 2 ? 3 * dit : dit;
+    }
+    if (tag) {
+        snapshot.releases[CLASSIFIER_WINDOW - 1] = tag;
+    }
+    return snapshot;
+}
+
+// Tag of save k, distinct for the last saves of test_sequence_wrap.
+int16_t tag(unsigned long k) {
+    return (int16_t)(k % 30000 + 1);
+}
+
+// The record in 'slot' as it is in the EEPROM.
+TimingStore::Record slot_record(uint8_t slot) {
+    TimingStore::Record record;
+    memcpy(&record, hostPlatform.eeprom + TIMING_STORE_ADDRESS + slot * sizeof(record), sizeof(record));
+    return record;
+}
+
+// Offers 'snapshot' and, if taken, writes it completely. Returns whether it was taken.
+bool save(TimingStore& store, const TimingSnapshot& snapshot, unsigned long now) {
+    if (!store.offer(snapshot, now)) {
+        return false;
+    }
+    while (store.write_step()) {}
+    return true;
+}
+
+// Makes saves 'first' to 'last' (from 1), one interval apart, alternating between a 60 and a 100 ms dit so each one has drifted. Save k is tagged tag(k).
+void save_many_from(TimingStore& store, unsigned long first, unsigned long last) {
+    for (unsigned long k = first; k <= last; k++) {
+        save(store, timing(k % 2 ? 60 : 100, tag(k)), k * LATER);
+    }
+}
+
+// Makes the first 'count' saves.
+void save_many(TimingStore& store, unsigned long count) {
+    save_many_from(store, 1, count);
+}
+
+// Tag of a saved or loaded snapshot.
+int16_t tag_of(const TimingSnapshot& snapshot) {
+    return snapshot.releases[CLASSIFIER_WINDOW - 1];
+}
+
+void test_nothing_saved() {
+    TimingStore store;
+    TimingSnapshot loaded = timing(0);
+    TEST_ASSERT_FALSE(store.load(loaded)); // an erased EEPROM has no valid record
+    TEST_ASSERT_TRUE(save(store, timing(60), 0)); // the first save needs neither drift nor an interval
+    TEST_ASSERT_EQUAL(1, store.saves);
+}
+
+void test_round_trip() {
+    TimingStore store;
+    TEST_ASSERT_TRUE(save(store, timing(60), 0));
+    TimingStore rebooted;
+    TimingSnapshot loaded = timing(0);
+    TEST_ASSERT_TRUE(rebooted.load(loaded));
+    TimingStore::Record record = slot_record(0);
+    TEST_ASSERT_EQUAL_MEMORY(&record.timing, &loaded, sizeof(loaded));
+    TEST_ASSERT_EQUAL(60, loaded.presses[0]);
+    TEST_ASSERT_EQUAL(180, loaded.releases[CLASSIFIER_WINDOW - 1]);
+}
+
+void test_one_byte_per_step() {
+    TimingStore store;
+    TEST_ASSERT_TRUE(store.offer(timing(60), 0));
+    TEST_ASSERT_TRUE(store.busy());
+    unsigned long steps = 0;
+    while (store.write_step()) {
+        steps++;
+        TEST_ASSERT_EQUAL(steps, hostPlatform.eepromWrites);
+    }
+    TEST_ASSERT_EQUAL(sizeof(TimingStore::Record), steps + 1);
+    TEST_ASSERT_FALSE(store.busy());
+    TEST_ASSERT_FALSE(store.write_step()); // nothing left to write
+}
+
+void test_round_robin() {
+    TimingStore store;
+    for (unsigned long k = 1; k <= 2 * TIMING_STORE_SLOTS + 1; k++) {
+        save_many_from(store, k, k);
+        TimingStore::Record record = slot_record((k - 1) % TIMING_STORE_SLOTS); // save k goes to the slot after save k - 1
+        TEST_ASSERT_EQUAL(k, record.sequence);
+        TEST_ASSERT_EQUAL(tag(k), tag_of(record.timing));
+    }
+    TEST_ASSERT_EQUAL(2 * TIMING_STORE_SLOTS + 1, store.saves);
+    TEST_ASSERT_EQUAL(2 * TIMING_STORE_SLOTS, slot_record(TIMING_STORE_SLOTS - 1).sequence); // the other slots keep the last round
+    TEST_ASSERT_EQUAL(TIMING_STORE_SLOTS + 2, slot_record(1).sequence);
+
+    TimingStore rebooted; // continues after the newest record, not from slot 0
+    TimingSnapshot loaded;
+    TEST_ASSERT_TRUE(rebooted.load(loaded));
+    TEST_ASSERT_EQUAL(tag(2 * TIMING_STORE_SLOTS + 1), tag_of(loaded));
+    TEST_ASSERT_TRUE(save(rebooted, timing(100), LATER));
+    TEST_ASSERT_EQUAL(2 * TIMING_STORE_SLOTS + 2, slot_record(1).sequence);
+}
+
+void test_torn_write() {
+    TimingStore store;
+    save_many(store, 3);
+    TEST_ASSERT_TRUE(store.offer(timing(100, tag(4)), 4 * LATER));
+    for (uint8_t i = 0; i < sizeof(TimingStore::Record) / 2; i++) { // power lost halfway through the record
+        store.write_step();
+    }
+    TimingStore rebooted;
+    TimingSnapshot loaded;
+    TEST_ASSERT_TRUE(rebooted.load(loaded));
+    TEST_ASSERT_EQUAL(tag(3), tag_of(loaded));
+
+    TEST_ASSERT_TRUE(save(rebooted, timing(100), LATER)); // the next save goes over the torn slot
+    TEST_ASSERT_EQUAL(4, slot_record(3).sequence);
+}
+
+void test_torn_write_over_old_record() {
+    TimingStore store;
+    save_many(store, TIMING_STORE_SLOTS); // every slot in use; the next save overwrites the oldest
+    TEST_ASSERT_TRUE(store.offer(timing(60), (TIMING_STORE_SLOTS + 1) * LATER));
+    for (uint8_t i = 1; i < sizeof(TimingStore::Record); i++) { // all but the last byte of the CRC
+        store.write_step();
+    }
+    TimingStore rebooted;
+    TimingSnapshot loaded;
+    TEST_ASSERT_TRUE(rebooted.load(loaded));
+    TEST_ASSERT_EQUAL(tag(TIMING_STORE_SLOTS), tag_of(loaded));
+}
+
+void test_sequence_wrap() {
+    TimingStore store;
+    save_many(store, 0x10001UL); // the last sequence numbers are 0xFFFF, 0 and 1
+    TEST_ASSERT_EQUAL(0xFFFF, slot_record(14).sequence);
+    TEST_ASSERT_EQUAL(0, slot_record(15).sequence);
+    TEST_ASSERT_EQUAL(1, slot_record(0).sequence);
+    TimingStore rebooted;
+    TimingSnapshot loaded;
+    TEST_ASSERT_TRUE(rebooted.load(loaded));
+    TEST_ASSERT_EQUAL(tag(0x10001UL), tag_of(loaded)); // sequence 1 is newer than 0xFFFF
+    TEST_ASSERT_TRUE(save(rebooted, timing(100), LATER));
+    TEST_ASSERT_EQUAL(2, slot_record(1).sequence);
+}
+
+void test_drift_and_interval() {
+    TimingStore store;
+    TEST_ASSERT_TRUE(save(store, timing(100), 0));
+    TEST_ASSERT_FALSE(store.offer(timing(100), 10 * LATER)); // unchanged
+    TEST_ASSERT_FALSE(store.offer(timing(110), 10 * LATER)); // 10% drift: within TIMING_STORE_DRIFT
+    TEST_ASSERT_FALSE(store.offer(timing(120), LATER - 1)); // 20% drift, but too soon
+    TEST_ASSERT_TRUE(store.offer(timing(120), LATER));
+    TEST_ASSERT_FALSE(store.offer(timing(200), 10 * LATER)); // still writing the last one
+    while (store.write_step()) {}
+    TEST_ASSERT_FALSE(store.offer(timing(125), 10 * LATER)); // drift is measured from the last save
+    TEST_ASSERT_TRUE(store.offer(timing(120, 1000), 10 * LATER)); // the releases alone drifted (a word gap came in)
+    while (store.write_step()) {}
+    TEST_ASSERT_EQUAL(3, store.saves);
+
+    TimingStore rebooted; // a loaded record counts as the last save, made at boot
+    TimingSnapshot loaded;
+    TEST_ASSERT_TRUE(rebooted.load(loaded));
+    TEST_ASSERT_FALSE(rebooted.offer(timing(60), LATER - 1));
+    TEST_ASSERT_FALSE(rebooted.offer(loaded, LATER));
+    TEST_ASSERT_TRUE(rebooted.offer(timing(60), LATER));
+}
+
+void test_seed_then_settled() {
+    Durations::ButtonProperties button;
+    Classifier classifier(button);
+    TimingSnapshot saved = timing(60); // 60 ms dits and element gaps, 180 ms dahs and letter gaps
+    classifier.seed(saved.presses, saved.releases);
+    TEST_ASSERT_FALSE(classifier.settled());
+    TEST_ASSERT_EQUAL_FLOAT(120, button.avgPressDuration);
+    TEST_ASSERT_EQUAL_FLOAT(120, button.avgReleaseDuration);
+    TEST_ASSERT_EQUAL('0', classifier.classify_press(70)); // judged with the seeded rhythm before anything is keyed
+    TEST_ASSERT_EQUAL('1', classifier.classify_press(170));
+    TEST_ASSERT_FALSE(classifier.ends_letter(70));
+    TEST_ASSERT_TRUE(classifier.ends_letter(170));
+
+    for (uint8_t i = 0; i + 1 < CLASSIFIER_WINDOW; i++) {
+        classifier.add_press(i % 2 ? 60 : 180);
+        classifier.add_release(60);
+    }
+    TEST_ASSERT_FALSE(classifier.settled()); // one press short of a full window of real keying
+    classifier.add_press(60);
+    TEST_ASSERT_FALSE(classifier.settled());
+    classifier.add_release(60);
+    TEST_ASSERT_TRUE(classifier.settled());
+
+    classifier.seed(saved.presses, saved.releases); // a new seed starts over
+    TEST_ASSERT_FALSE(classifier.settled());
+}
+
+void test_windows_round_trip() {
+    Durations::ButtonProperties button;
+    Classifier keyed(button);
+    keyed.add_press(50);
+    keyed.add_release(55);
+    keyed.add_press(160);
+    TimingSnapshot saved = TimingSnapshot::of(keyed); // windows that are not full are padded with 0
+    TEST_ASSERT_EQUAL(50, saved.presses[0]);
+    TEST_ASSERT_EQUAL(160, saved.presses[1]);
+    TEST_ASSERT_EQUAL(0, saved.presses[2]);
+    TEST_ASSERT_EQUAL(55, saved.releases[0]);
+    TEST_ASSERT_EQUAL(0, saved.releases[1]);
+
+    Durations::ButtonProperties seededButton;
+    Classifier seeded(seededButton);
+    seeded.seed(saved.presses, saved.releases);
+    TEST_ASSERT_EQUAL_FLOAT(105, seededButton.avgPressDuration);
+    TEST_ASSERT_EQUAL_FLOAT(55, seededButton.avgReleaseDuration);
+    TimingSnapshot again = TimingSnapshot::of(seeded);
+    TEST_ASSERT_EQUAL_MEMORY(&saved, &again, sizeof(saved));
+}
+
+void test_other_speed_drops_seed() {
+    Durations::ButtonProperties button;
+    Classifier classifier(button);
+    TimingSnapshot saved = timing(60);
+    classifier.seed(saved.presses, saved.releases);
+    classifier.add_press(170); // a dah at the seeded speed: takes the oldest seeded dit's place
+    TEST_ASSERT_EQUAL_FLOAT((3 * 60 + 4 * 180 + 170) / 8.0f, button.avgPressDuration);
+    classifier.add_press(25); // under half a seeded dit: keyed faster, the seed goes
+    TEST_ASSERT_EQUAL_FLOAT((170 + 25) / 2.0f, button.avgPressDuration);
+    TEST_ASSERT_EQUAL_FLOAT(0, button.avgReleaseDuration); // no real release yet
+    TEST_ASSERT_FALSE(classifier.settled());
+}
+
+void setUp() {
+    memset(hostPlatform.eeprom, 0xFF, sizeof(hostPlatform.eeprom)); // a new board
+    hostPlatform.eepromWrites = 0;
+}
+
+void tearDown() {}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_saved);
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_one_byte_per_step);
+    RUN_TEST(test_round_robin);
+    RUN_TEST(test_torn_write);
+    RUN_TEST(test_torn_write_over_old_record);
+    RUN_TEST(test_sequence_wrap);
+    RUN_TEST(test_drift_and_interval);
+    RUN_TEST(test_seed_then_settled);
+    RUN_TEST(test_windows_round_trip);
+    RUN_TEST(test_other_speed_drops_seed);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+/*
+Word corrector (lib/word_corrector.h) on the host with the shipped word list (lib/word_list.h): the
+letters of a word are added with the patterns they were keyed as, and the tests assert on what
+'correct' proposes at the word gap. Run with
+    pio test -e native
+*/
+
+#include <unity.h>
+
+#include "../../lib/word_corrector.h"
+#include "../../lib/word_list.h"
+
+// Adds the letters of a word as keyed: patterns separated by spaces, '?' for one that is no letter.
+void key(WordCorrector& corrector, const char* patterns) {
+    char pattern[8];
+    while (*patterns) {
+        int length = 0;
+        while (*patterns && *patterns != ' ') {
+            pattern[length++] = *patterns++;
+        }
+        pattern[length] = '\0';
+        while (*patterns == ' ') {
+            patterns++;
+        }
+        uint8_t packed = pack_pattern(pattern);
+        char letter = '?';
+        for (int i = 0; i < 26; i++) {
+            if (packed_letter(i) == packed) {
+                letter = 'A' + i;
+            }
+        }
+        corrector.add_letter(letter, packed);
+    }
+}
+
+void test_misread_letter() {
+    WordCorrector corrector(wordList);
+    char out[MAX_WORD_LETTERS + 3];
+    key(corrector, "1 0001 0"); // THE with the last dit of H read long: TVE
+    TEST_ASSERT_EQUAL_STRING("TVE", corrector.word());
+    TEST_ASSERT_TRUE(corrector.correct(out));
+    TEST_ASSERT_EQUAL_STRING("THE", out);
+    TEST_ASSERT_EQUAL(3, corrector.shown()); // all three letters were on the lcd and are replaced
+}
+
+void test_invalid_pattern() {
+    WordCorrector corrector(wordList);
+    char out[MAX_WORD_LETTERS + 3];
+    key(corrector, "1101 001 00 1110 101"); // QUICK with the second press of C read long: no letter
+    TEST_ASSERT_EQUAL_STRING("QUI?K", corrector.word());
+    TEST_ASSERT_TRUE(corrector.correct(out));
+    TEST_ASSERT_EQUAL_STRING("QUICK", out);
+    TEST_ASSERT_EQUAL(4, corrector.shown()); // the '?' was never shown
+}
+
+void test_letter_gap() {
+    WordCorrector corrector(wordList);
+    char out[MAX_WORD_LETTERS + 3];
+    key(corrector, "01 1 0 100"); // AND with a pause inside N taken for a letter gap: ATED
+    TEST_ASSERT_TRUE(corrector.correct(out));
+    TEST_ASSERT_EQUAL_STRING("AND", out);
+
+    corrector.reset();
+    key(corrector, "1111"); // TO with the letter gap missed: four dahs are no letter
+    TEST_ASSERT_EQUAL_STRING("?", corrector.word());
+    TEST_ASSERT_TRUE(corrector.correct(out));
+    TEST_ASSERT_EQUAL_STRING("TO", out);
+}
+
+void test_valid_word_left_alone() {
+    WordCorrector corrector(wordList);
+    char out[MAX_WORD_LETTERS + 3];
+    const char* words[] = { "1 0000 0", "011 01 1 0 010", "1101 001 00 1010 101", "1010 1101" }; // THE WATER QUICK CQ
+    for (const char* word : words) {
+        corrector.reset();
+        key(corrector, word);
+        TEST_ASSERT_FALSE(corrector.correct(out));
+        TEST_ASSERT_TRUE(corrector.visited > 0); // it was looked up and found
+    }
+}
+
+void test_far_word_left_alone() {
+    WordCorrector corrector(wordList);
+    char out[MAX_WORD_LETTERS + 3];
+    key(corrector, "1001 1101 1001 1101"); // XQXQ: no word within the bound
+    TEST_ASSERT_FALSE(corrector.correct(out));
+    corrector.reset();
+    key(corrector, "1111 1111 1111"); // nothing but invalid patterns
+    TEST_ASSERT_FALSE(corrector.correct(out));
+}
+
+void test_too_long() {
+    WordCorrector corrector(wordList);
+    char out[MAX_WORD_LETTERS + 3];
+    for (int i = 0; i <= MAX_WORD_LETTERS; i++) {
+        corrector.add_letter('E', pack_pattern("0"));
+    }
+    TEST_ASSERT_FALSE(corrector.correct(out));
+    TEST_ASSERT_EQUAL(0, corrector.visited); // not looked up at all
+    corrector.reset();
+    TEST_ASSERT_EQUAL_STRING("", corrector.word());
+    TEST_ASSERT_FALSE(corrector.correct(out));
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_misread_letter);
+    RUN_TEST(test_invalid_pattern);
+    RUN_TEST(test_letter_gap);
+    RUN_TEST(test_valid_word_left_alone);
+    RUN_TEST(test_far_word_left_alone);
+    RUN_TEST(test_too_long);
+    return UNITY_END();
+}
\ No newline at end of file
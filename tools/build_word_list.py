@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+Builds the word list of the word corrector (lib/word_corrector.h) as a DAWG: the trie of the words
+with identical subtrees merged, stored as an array of 3-byte edges.
+
+    python tools/build_word_list.py tools/words.txt --header lib/word_list.h      # PROGMEM, for the firmware
+    python tools/build_word_list.py big_list.txt --binary words.dawg              # raw edges, for the host tools
+
+Edge layout: byte 0 holds the letter (bits 0-4, 0 for A), 0x20 if a word ends with this letter and
+0x40 on the last edge of a node; bytes 1-2 are the index of the child node's first edge, little endian
+(0 for none: the root starts at edge 0 and is nobody's child). The edges of a node are consecutive.
+
+Input: words separated by whitespace, letters only (others are dropped), lines starting with '#'
+ignored. The first 65535 edges are addressable, several thousand words.
+"""
+
+import argparse
+import sys
+
+TERMINAL = 0x20
+LAST = 0x40
+
+
+def read_words(path):
+    words = []
+    seen = set()
+    with open(path) as file:
+        for line in file:
+            if line.startswith("#"):
+                continue
+            for raw in line.split():
+                word = "".join(c for c in raw.upper() if "A" <= c <= "Z")
+                if word and word not in seen:
+                    seen.add(word)
+                    words.append(word)
+    return words
+
+
+def build(words):
+    """Returns the edges as a list of (letter, terminal, last, child node) with nodes laid out in order."""
+    trie = {}
+    for word in words:
+        node = trie
+        for i, c in enumerate(word):
+            entry = node.setdefault(c, [False, {}])
+            if i == len(word) - 1:
+                entry[0] = True
+            node = entry[1]
+
+    registry = {}  # signature -> node id
+
+    def minimise(node):
+        signature = tuple((c, entry[0], minimise(entry[1])) for c, entry in sorted(node.items()))
+        if not signature:
+            return None
+        return registry.setdefault(signature, len(registry))
+
+    root = minimise(trie)
+    nodes = {node_id: signature for signature, node_id in registry.items()}
+
+    # Breadth-first layout from the root so that related nodes sit close together.
+    order, start = [root], {}
+    position = 0
+    for node_id in order:
+        start[node_id] = position
+        position += len(nodes[node_id])
+        for _, _, child in nodes[node_id]:
+            if child is not None and child not in start and child not in order:
+                order.append(child)
+    if position > 0xFFFF:
+        sys.exit("word list too large: %d edges (at most 65535)" % position)
+
+    out = bytearray()
+    for node_id in order:
+        signature = nodes[node_id]
+        for i, (c, terminal, child) in enumerate(signature):
+            flags = (TERMINAL if terminal else 0) | (LAST if i == len(signature) - 1 else 0)
+            target = start[child] if child is not None else 0
+            out += bytes([(ord(c) - ord("A")) | flags, target & 0xFF, target >> 8])
+    return out
+
+
+def words_in(edges, index=0, prefix=""):
+    """Yields the words stored in 'edges' (to check the encoding)."""
+    while True:
+        byte = edges[index * 3]
+        letter = prefix + chr(ord("A") + (byte & 0x1F))
+        if byte & TERMINAL:
+            yield letter
+        child = edges[index * 3 + 1] | edges[index * 3 + 2] << 8
+        if child:
+            yield from words_in(edges, child, letter)
+        if byte & LAST:
+            return
+        index += 1
+
+
+def write_header(path, edges, source, count):
+    rows = []
+    for i in range(0, len(edges), 24):
+        rows.append("    " + ", ".join("0x%02X" % b for b in edges[i:i + 24]) + ",")
+    with open(path, "w") as file:
+        file.write("#ifndef WORD_LIST_H\n#define WORD_LIST_H\n\n")
+        file.write("/*\nWord list of the word corrector (word_corrector.h) as a DAWG in flash, %d words in %d edges (%d bytes).\n"
+                   % (count, len(edges) // 3, len(edges)))
+        file.write("Generated from %s by tools/build_word_list.py, which also describes the layout.\n*/\n\n" % source)
+        file.write('#include "platform.h"\n\n')
+        file.write("const uint8_t wordList[] PROGMEM = {\n%s\n};\n\n" % "\n".join(rows))
+        file.write("#endif // WORD_LIST_H")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("words")
+    parser.add_argument("--header", help="write a PROGMEM header for the firmware")
+    parser.add_argument("--binary", help="write the raw edges for the host tools")
+    args = parser.parse_args()
+    if not args.header and not args.binary:
+        parser.error("give --header and/or --binary")
+
+    words = read_words(args.words)
+    if not words:
+        sys.exit("no words in %s" % args.words)
+    edges = build(words)
+    if sorted(words_in(edges)) != sorted(words):
+        sys.exit("internal error: the DAWG does not hold the word list")
+    if args.header:
+        write_header(args.header, edges, args.words, len(words))
+    if args.binary:
+        with open(args.binary, "wb") as file:
+            file.write(edges)
+    print("%d words, %d edges, %d bytes" % (len(words), len(edges) // 3, len(edges)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""
+Checks in the disassembly of the firmware that its pin writes are single sbi/cbi instructions.
+
+Pin<P, Bit> (lib/hal.h) is meant to compile every high()/low() to one sbi/cbi on PORTx, which is
+atomic and cannot be torn by an interrupt. If the compiler cannot fold a port to its constant I/O
+address it falls back to a read-modify-write (in, ori/andi, out) or to lds/sts on the memory-mapped
+address, which an interrupt writing the same port between the read and the write would undo. This
+lists, per function, the sbi/cbi on the PORT and DDR registers and any other write to them, and
+exits non-zero if firmware code (anything outside the Arduino core) writes a port another way.
+
+    pio run -e uno && python tools/check_port_writes.py
+    python tools/check_port_writes.py .pio/build/uno/firmware.elf --objdump avr-objdump
+
+Needs avr-objdump: on PATH, given with --objdump, or from PlatformIO's toolchain-atmelavr package.
+"""
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+# I/O addresses of the ATmega328P port registers (sbi/cbi/in/out take these; lds/sts take them + 0x20).
+REGISTERS = {0x04: "DDRB", 0x05: "PORTB", 0x07: "DDRC", 0x08: "PORTC", 0x0A: "DDRD", 0x0B: "PORTD"}
+
+# Functions of the Arduino core whose port accesses are not ours to check. main (setup and loop are
+# inlined into it with LTO) and the interrupt vectors are ours.
+CORE = re.compile(r"^(pinMode|digitalWrite|digitalRead|turnOffPWM)\b")
+
+FUNCTION = re.compile(r"^[0-9a-f]+ <(.+)>:$")
+INSTRUCTION = re.compile(r"^\s*[0-9a-f]+:\s+(?:[0-9a-f]{2} )+\s*(\w+)\s+([^;]*)")
+
+
+def find_objdump(given):
+    """Path of avr-objdump: the one given, the one on PATH, or PlatformIO's."""
+    if given:
+        return given
+    found = shutil.which("avr-objdump")
+    if found:
+        return found
+    bundled = os.path.expanduser("~/.platformio/packages/toolchain-atmelavr/bin/avr-objdump")
+    if os.path.exists(bundled):
+        return bundled
+    raise SystemExit("avr-objdump not found; install PlatformIO's atmelavr platform or pass --objdump")
+
+
+def register(operand):
+    """Port register named by an I/O (0x05) or data space (0x0025) address operand, or None."""
+    try:
+        address = int(operand, 0)
+    except ValueError:
+        return None
+    if address >= 0x20:
+        address -= 0x20  # lds/sts use the data space address
+    return REGISTERS.get(address)
+
+
+def scan(lines):
+    """Returns {function: {'bit': {register: count}, 'other': [instruction, ...]}} for the port registers."""
+    functions = {}
+    current = None
+    for line in lines:
+        match = FUNCTION.match(line)
+        if match:
+            current = functions.setdefault(match.group(1), {"bit": {}, "other": []})
+            continue
+        match = INSTRUCTION.match(line)
+        if not match or current is None:
+            continue
+        mnemonic, operands = match.group(1), [o.strip() for o in match.group(2).split(",")]
+        if mnemonic in ("sbi", "cbi"):
+            name = register(operands[0])
+            if name:
+                current["bit"][name] = current["bit"].get(name, 0) + 1
+        elif mnemonic == "out" or mnemonic == "sts":
+            name = register(operands[0])
+            if name:
+                current["other"].append("%s %s" % (mnemonic, ", ".join(operands)))
+    return {name: found for name, found in functions.items() if found["bit"] or found["other"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("elf", nargs="?", default=".pio/build/uno/firmware.elf", help="firmware to check (default: the uno build)")
+    parser.add_argument("--objdump", help="avr-objdump to use")
+    args = parser.parse_args()
+
+    result = subprocess.run([find_objdump(args.objdump), "-d", "-C", args.elf], capture_output=True, text=True)
+    if result.returncode != 0:
+        sys.stderr.write(result.stderr)
+        raise SystemExit("could not disassemble %s" % args.elf)
+    functions = scan(result.stdout.splitlines())
+
+    failed = False
+    print("| function | sbi/cbi | other port writes |")
+    print("| --- | --- | --- |")
+    for name in sorted(functions):
+        found = functions[name]
+        bits = ", ".join("%s %d" % item for item in sorted(found["bit"].items()))
+        ours = not CORE.match(name)
+        if ours and found["other"]:
+            failed = True
+        print("| %s%s | %s | %s |" % (name, "" if ours else " (core)", bits or "-", "; ".join(found["other"]) or "-"))
+    if failed:
+        print("\nfirmware functions write port registers other than with sbi/cbi", file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
\ No newline at end of file
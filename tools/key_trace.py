@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+Reads and writes binary key-timing trace files (.ktr), the format described in src/host/key_trace.h.
+
+As a script it lists the sessions of a file:
+
+    python tools/key_trace.py corpus.ktr
+
+As a module it is used by telemetry_decode.py --capture to save edges streamed by the device.
+"""
+
+import struct
+import sys
+
+MAGIC = b"KTRC"
+VERSION = 1
+HEADER = struct.Struct("<4sHHIIQQ")  # magic, version, header size, tick us, sessions, index offset, reserved
+INDEX_ENTRY = struct.Struct("<QIIQQQHHI")  # meta offset/bytes, edge count, edges offset/bytes, duration, wpm x10, flags, reserved
+
+
+def encode_varint(value, out):
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def decode_edges(data, count):
+    """Yields (time, pressed) for 'count' varint-encoded edges."""
+    time, pressed, position = 0, True, 0
+    for _ in range(count):
+        delta, shift = 0, 0
+        while True:
+            byte = data[position]
+            position += 1
+            delta |= (byte & 0x7F) << shift
+            if not byte & 0x80:
+                break
+            shift += 7
+        time += delta
+        yield time, pressed
+        pressed = not pressed
+
+
+class Writer:
+    """Writes sessions one at a time; close() adds the index and the final header."""
+
+    def __init__(self, path, tick_us=1000):
+        self.file = open(path, "wb")
+        self.tick_us = tick_us
+        self.index = []
+        self.file.write(HEADER.pack(MAGIC, VERSION, HEADER.size, tick_us, 0, 0, 0))
+
+    def add_session(self, edge_times, metadata=None):
+        """edge_times: ascending tick counts, alternating press/release starting with a press.
+        metadata: dict such as {"operator": ..., "wpm": ..., "text": ...}."""
+        metadata = metadata or {}
+        meta = "".join("%s=%s\n" % (key, value) for key, value in metadata.items()).encode("utf-8")
+        edges = bytearray()
+        previous = 0
+        for time in edge_times:
+            if time < previous:
+                raise ValueError("edge times go backwards")
+            encode_varint(time - previous, edges)
+            previous = time
+        meta_offset = self.file.tell()
+        self.file.write(meta)
+        self.file.write(edges)
+        wpm = float(metadata.get("wpm", 0) or 0)
+        self.index.append((meta_offset, len(meta), len(edge_times), meta_offset + len(meta), len(edges), previous,
+                           int(wpm * 10 + 0.5), 0, 0))
+
+    def close(self):
+        index_offset = self.file.tell()
+        for entry in self.index:
+            self.file.write(INDEX_ENTRY.pack(*entry))
+        self.file.seek(0)
+        self.file.write(HEADER.pack(MAGIC, VERSION, HEADER.size, self.tick_us, len(self.index), index_offset, 0))
+        self.file.close()
+
+
+def read(path):
+    """Returns (tick_us, sessions) where every session is a dict with 'meta' and 'edges' [(time, pressed)]."""
+    with open(path, "rb") as file:
+        data = file.read()
+    magic, version, _, tick_us, count, index_offset, _ = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("%s is not a version %d key trace file" % (path, VERSION))
+    sessions = []
+    for i in range(count):
+        meta_offset, meta_bytes, edge_count, edges_offset, edges_bytes, duration, wpm, _, _ = \
+            INDEX_ENTRY.unpack_from(data, index_offset + i * INDEX_ENTRY.size)
+        lines = data[meta_offset:meta_offset + meta_bytes].decode("utf-8").splitlines()
+        meta = dict(line.split("=", 1) for line in lines if "=" in line)
+        edges = list(decode_edges(data[edges_offset:edges_offset + edges_bytes], edge_count))
+        sessions.append({"meta": meta, "edges": edges, "duration": duration, "wpm": wpm / 10})
+    return tick_us, sessions
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("usage: %s FILE.ktr" % sys.argv[0], file=sys.stderr)
+        sys.exit(2)
+    tick_us, sessions = read(sys.argv[1])
+    print("%d sessions, tick %d us" % (len(sessions), tick_us))
+    for i, session in enumerate(sessions):
+        print("%5d %7d edges %8.1f s  %5.1f WPM  %-12s %s" % (
+            i, len(session["edges"]), session["duration"] * tick_us / 1e6, session["wpm"],
+            session["meta"].get("operator", "-"), session["meta"].get("text", "")[:40]))
+
+
+if __name__ == "__main__":
+    main()
\ No newline at end of file
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+Builds the firmware once per build-flag variant and prints a RAM/flash comparison table.
+
+Each variant is 'name=flags'; the flags are passed through PLATFORMIO_BUILD_FLAGS, so they are added
+on top of the environment's own build_flags. The first variant is the baseline for the deltas.
+
+    python tools/size_report.py --log-levels
+    python tools/size_report.py -v "default=" -v "profiled=-DMORSE_PROFILE -DMORSE_LOOP_MONITOR"
+
+Requires the PlatformIO CLI ('pio') on PATH, except for --strings: that one reads the sources and
+prints the flash taken by the log format strings each level compiles in, without building. It leaves
+out the code of the calls and the formatting functions, so it is a lower bound on the flash a level
+costs, and the strings stay in flash, so they cost no RAM. Statements behind an optional feature's
+flag (e.g. memory_stats.h, MORSE_MEMORY_STATS) are counted too.
+"""
+
+import argparse
+import ast
+import os
+import re
+import subprocess
+import sys
+
+LOG_LEVELS = [
+    ("none", "-DMORSE_LOG_LEVEL=0"),
+    ("error", "-DMORSE_LOG_LEVEL=1"),
+    ("warn", "-DMORSE_LOG_LEVEL=2"),
+    ("info", "-DMORSE_LOG_LEVEL=3"),
+    ("debug", "-DMORSE_LOG_LEVEL=4"),
+]
+
+# Matches the summary PlatformIO prints after linking, e.g.
+#   RAM:   [==        ]  23.4% (used 480 bytes from 2048 bytes)
+USAGE = re.compile(r"^(RAM|Flash):.*used (\d+) bytes from (\d+) bytes", re.MULTILINE)
+
+# A log statement and its format string (one or more adjacent literals), e.g.
+#   LOG_INFO(LOG_CAT_DECODE, "Morse code %s matches letter %c", pattern, letter);
+LOG_CALL = re.compile(r'\bLOG_(ERROR|WARN|INFO|DEBUG)\(\s*[^,]+,\s*((?:"(?:[^"\\]|\\.)*"\s*)+)')
+LITERAL = re.compile(r'"(?:[^"\\]|\\.)*"')
+SOURCES = ["lib", "src/main.cpp"]  # what the firmware is built from
+
+
+def build(env, flags):
+    """Builds one variant and returns {'RAM': (used, total), 'Flash': (used, total)}."""
+    environ = dict(os.environ, PLATFORMIO_BUILD_FLAGS=flags)
+    result = subprocess.run(["pio", "run", "-e", env], env=environ, capture_output=True, text=True)
+    if result.returncode != 0:
+        sys.stderr.write(result.stdout[-4000:] + result.stderr[-4000:])
+        raise SystemExit("build failed for flags '%s'" % flags)
+    usage = {kind: (int(used), int(total)) for kind, used, total in USAGE.findall(result.stdout)}
+    if "RAM" not in usage or "Flash" not in usage:
+        raise SystemExit("could not find the RAM/Flash summary in the build output")
+    return usage
+
+
+def format_strings(root):
+    """Returns {level name: (statements, bytes)} of the log format strings in the firmware sources."""
+    found = {name.upper(): [0, 0] for name, _ in LOG_LEVELS[1:]}
+    paths = []
+    for source in SOURCES:
+        path = os.path.join(root, source)
+        if os.path.isdir(path):
+            paths += [os.path.join(path, name) for name in sorted(os.listdir(path)) if name.endswith(".h")]
+        else:
+            paths.append(path)
+    for path in paths:
+        with open(path) as f:
+            text = f.read()
+        for level, literals in LOG_CALL.findall(text):
+            if path.endswith("log.h"):
+                continue  # the macro definitions and the example in the comment
+            chars = "".join(ast.literal_eval(literal) for literal in LITERAL.findall(literals))
+            found[level][0] += 1
+            found[level][1] += len(chars.encode()) + 1  # and the terminator
+    return found
+
+
+def print_strings(root):
+    """Prints the format string flash of every log level, each including the levels below it."""
+    found = format_strings(root)
+    print("| level | flags | statements | format strings (bytes) |")
+    print("| --- | --- | ---: | ---: |")
+    statements = size = 0
+    for name, flags in LOG_LEVELS:
+        if name != "none":
+            statements += found[name.upper()][0]
+            size += found[name.upper()][1]
+        print("| %s | `%s` | %d | %d |" % (name, flags, statements, size))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("-e", "--env", default="uno", help="PlatformIO environment to build (default uno)")
+    parser.add_argument("-v", "--variant", action="append", default=[], help="name=build flags (repeatable)")
+    parser.add_argument("--log-levels", action="store_true", help="compare every MORSE_LOG_LEVEL")
+    parser.add_argument("--strings", action="store_true", help="only count the log format strings per level (no build)")
+    args = parser.parse_args()
+
+    if args.strings:
+        print_strings(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+        return
+
+    variants = [tuple(v.split("=", 1)) if "=" in v else (v, "") for v in args.variant]
+    if args.log_levels:
+        variants += LOG_LEVELS
+    if not variants:
+        parser.error("no variants given (use -v name=flags or --log-levels)")
+
+    rows = []
+    for name, flags in variants:
+        print("building %s (%s)..." % (name, flags or "no extra flags"), file=sys.stderr)
+        rows.append((name, flags, build(args.env, flags)))
+
+    base_ram, base_flash = rows[0][2]["RAM"][0], rows[0][2]["Flash"][0]
+    print("| variant | flags | RAM (bytes) | ΔRAM | flash (bytes) | Δflash |")
+    print("| --- | --- | ---: | ---: | ---: | ---: |")
+    for name, flags, usage in rows:
+        ram, flash = usage["RAM"][0], usage["Flash"][0]
+        print("| %s | `%s` | %d | %+d | %d | %+d |" % (name, flags, ram, ram - base_ram, flash, flash - base_flash))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+"""
+Pretty-prints the binary telemetry stream produced by firmware built with -D MORSE_TELEMETRY.
+
+Reads from a serial port (needs pyserial) or from a captured file / stdin:
+
+    python tools/telemetry_decode.py --port /dev/ttyACM0 --baud 9600
+    python tools/telemetry_decode.py capture.bin
+    cat capture.bin | python tools/telemetry_decode.py -
+
+With --capture the key edges are also saved as a binary key trace (tools/key_trace.py), one session
+per boot of the device, for replaying through the host decoder:
+
+    python tools/telemetry_decode.py --port /dev/ttyACM0 --capture alice.ktr --operator alice --wpm 18 --text "CQ CQ"
+
+Frame layout matches lib/telemetry.h:
+    0xA5 | type | length | payload[length] | crc8(type, length, payload)
+Bytes that are not part of a valid frame (e.g. the text of a 'p' profiling dump) are printed as text.
+"""
+
+import argparse
+import struct
+import sys
+
+SYNC = 0xA5
+MAX_PAYLOAD = 32  # anything longer is treated as a false sync
+
+BOOT, EDGE, CLASSIFY, PATTERN, DURATION, LETTER, STATS, DROPS = range(1, 9)
+
+
+def crc8(data):
+    """CRC-8, polynomial 0x07, initial value 0 (same as Telemetry::crc8)."""
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def symbol_name(symbol):
+    return {ord("0"): "short", ord("1"): "long"}.get(symbol, "0x%02x" % symbol)
+
+
+def pattern_string(length, bits):
+    return "".join("-" if bits & (1 << i) else "." for i in range(length))
+
+
+class Decoder:
+    """Incremental frame parser: feed() bytes, get back (kind, value) tuples."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.frames = 0
+        self.crc_errors = 0
+        self.last_edge_ms = None
+
+    def feed(self, data):
+        self.buffer.extend(data)
+        out = []
+        while self.buffer:
+            start = self.buffer.find(SYNC)
+            if start < 0:  # no frame start at all: everything is text
+                out.append(("text", bytes(self.buffer)))
+                self.buffer.clear()
+                break
+            if start > 0:
+                out.append(("text", bytes(self.buffer[:start])))
+                del self.buffer[:start]
+            if len(self.buffer) < 3:  # need type and length
+                break
+            length = self.buffer[2]
+            if length > MAX_PAYLOAD:
+                out.append(("text", bytes(self.buffer[:1])))
+                del self.buffer[:1]
+                continue
+            if len(self.buffer) < length + 4:  # frame not complete yet
+                break
+            frame = bytes(self.buffer[1:length + 3])
+            if crc8(frame) != self.buffer[length + 3]:  # false sync or corrupted frame: skip the sync byte
+                self.crc_errors += 1
+                out.append(("text", bytes(self.buffer[:1])))
+                del self.buffer[:1]
+                continue
+            del self.buffer[:length + 4]
+            self.frames += 1
+            out.append(("frame", (frame[0], frame[2:])))
+        return out
+
+    def describe(self, frame_type, payload):
+        """Human readable description of a single frame."""
+        try:
+            if frame_type == BOOT:
+                self.last_edge_ms = None
+                return "BOOT     protocol v%d" % payload[0]
+            if frame_type == EDGE:
+                level, time_ms = struct.unpack("<BI", payload)
+                delta = "" if self.last_edge_ms is None else "  (+%d ms)" % (time_ms - self.last_edge_ms)
+                self.last_edge_ms = time_ms
+                return "EDGE     %-8s at %d ms%s" % ("pressed" if level else "released", time_ms, delta)
+            if frame_type == CLASSIFY:
+                symbol, duration = struct.unpack("<BH", payload)
+                return "CLASSIFY %-8s %d ms" % (symbol_name(symbol), duration)
+            if frame_type == PATTERN:
+                symbol, accepted = struct.unpack("<BB", payload)
+                return "PATTERN  +%s%s" % (symbol_name(symbol), "" if accepted else "  (pattern full)")
+            if frame_type == DURATION:
+                duration, accepted = struct.unpack("<HB", payload)
+                return "DURATION %d ms%s" % (duration, "" if accepted else "  (array full)")
+            if frame_type == LETTER:
+                letter, length, bits = struct.unpack("<BBB", payload)
+                return "LETTER   %s  %s" % (chr(letter), pattern_string(length, bits))
+            if frame_type == STATS:
+                avg_press, std_press, avg_release, std_release = struct.unpack("<HHHH", payload)
+                return "STATS    press %d±%d ms  release %d±%d ms" % (avg_press, std_press, avg_release, std_release)
+            if frame_type == DROPS:
+                (dropped,) = struct.unpack("<H", payload)
+                return "DROPS    %d frames dropped since boot" % dropped
+        except struct.error:
+            return "BAD      type 0x%02x with %d byte payload" % (frame_type, len(payload))
+        return "UNKNOWN  type 0x%02x payload %s" % (frame_type, payload.hex())
+
+
+class Capture:
+    """Collects EDGE frames into key trace sessions (a new session starts at every BOOT frame)."""
+
+    def __init__(self, path, metadata):
+        import key_trace  # tools/key_trace.py
+
+        self.writer = key_trace.Writer(path)
+        self.metadata = metadata
+        self.times = []
+        self.start_ms = None
+        self.sessions = 0
+
+    def on_frame(self, frame_type, payload):
+        if frame_type == BOOT:
+            self.flush()
+        elif frame_type == EDGE and len(payload) == 5:
+            level, time_ms = struct.unpack("<BI", payload)
+            if bool(level) != (len(self.times) % 2 == 0):  # edges must alternate starting with a press
+                return  # (a frame was dropped or the key was down at boot)
+            if self.start_ms is None:
+                self.start_ms = time_ms
+            self.times.append(time_ms - self.start_ms)
+
+    def flush(self):
+        if self.times:
+            self.writer.add_session(self.times, self.metadata)
+            self.sessions += 1
+        self.times = []
+        self.start_ms = None
+
+    def close(self):
+        self.flush()
+        self.writer.close()
+
+
+def open_source(args):
+    if args.port:
+        import serial  # pyserial, only needed for live capture
+
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+        return lambda: port.read(256)
+    stream = sys.stdin.buffer if args.input in (None, "-") else open(args.input, "rb")
+    return lambda: stream.read(4096)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("input", nargs="?", help="captured stream file, or - for stdin")
+    parser.add_argument("--port", help="serial port to read live from (requires pyserial)")
+    parser.add_argument("--baud", type=int, default=9600, help="serial baud rate (default 9600)")
+    parser.add_argument("--raw", help="also save every received byte to this file")
+    parser.add_argument("--capture", help="save key edges to this key trace (.ktr) file")
+    parser.add_argument("--operator", help="operator name stored with the capture")
+    parser.add_argument("--wpm", type=float, help="keying speed stored with the capture")
+    parser.add_argument("--text", help="ground truth text stored with the capture")
+    args = parser.parse_args()
+
+    read = open_source(args)
+    raw = open(args.raw, "wb") if args.raw else None
+    decoder = Decoder()
+    capture = None
+    if args.capture:
+        metadata = {"source": "device"}
+        for key in ("operator", "wpm", "text"):
+            if getattr(args, key) is not None:
+                metadata[key] = getattr(args, key)
+        capture = Capture(args.capture, metadata)
+    text = bytearray()
+    try:
+        while True:
+            data = read()
+            if not data:
+                if args.port:
+                    continue
+                break
+            if raw:
+                raw.write(data)
+            for kind, value in decoder.feed(data):
+                if kind == "text":
+                    text.extend(value)
+                    while b"\n" in text:  # print complete text lines only
+                        line, _, rest = text.partition(b"\n")
+                        print("text     " + line.decode("ascii", "replace").rstrip("\r"))
+                        text = bytearray(rest)
+                else:
+                    if capture:
+                        capture.on_frame(*value)
+                    print(decoder.describe(*value))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if raw:
+            raw.close()
+        if capture:
+            capture.close()
+            print("# %d sessions saved to %s" % (capture.sessions, args.capture), file=sys.stderr)
+    print("# %d frames, %d crc errors" % (decoder.frames, decoder.crc_errors), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()